@@ -29,7 +29,6 @@
 #include <QtCore/qcommandlineparser.h>
 #include <QtGui/qguiapplication.h>
 #include <QtQml/qqmlapplicationengine.h>
-#include <QtQml/qqmlproperty.h>
 #include <QtQuickControls2/qquickstyle.h>
 #include <QtQuick/qquickwindow.h>
 #include <QtQuick/qquickitem.h>
@@ -326,6 +325,18 @@ int Application::run(int argc, char *argv[])
     engine.load(mainUrl);
 
     const QObjectList rootObjects = engine.rootObjects();
+    // Keep the player's renderer and its compiled shaders alive while the
+    // window is hidden, showing it again doesn't have to start from scratch.
+    if (!rootObjects.isEmpty()) {
+        if (const auto window = qobject_cast<QQuickWindow *>(rootObjects.at(0))) {
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+            window->setPersistentGraphics(true);
+#else
+            window->setPersistentOpenGLContext(true);
+#endif
+            window->setPersistentSceneGraph(true);
+        }
+    }
     if (!positionalArguments.isEmpty() && !rootObjects.isEmpty()) {
         const auto window = qobject_cast<QQuickWindow *>(rootObjects.at(0));
         Q_ASSERT(window);
@@ -345,7 +356,8 @@ int Application::run(int argc, char *argv[])
             const QUrl url = QUrl::fromUserInput(arg, QCoreApplication::applicationDirPath(),
                                                  QUrl::AssumeLocalFile);
             if (url.isValid()) {
-                if (QQmlProperty::write(player, QStringLiteral("source"), url)) {
+                // Goes through "Player.open()" so the last position is restored right away.
+                if (QMetaObject::invokeMethod(player, "open", Q_ARG(QVariant, url))) {
                     break;
                 }
             }
@@ -36,9 +36,15 @@ FramelessWindow {
                  ? Application.displayName : player.fileName
     color: Theme.windowBackgroundColor
     onVisibilityChanged: {
-        if ((visibility === Window.Minimized)
-                && player.isPlayingVideo() && Settings.pauseWhenMinimized) {
-            player.pause();
+        if (visibility === Window.Minimized) {
+            if (player.isPlayingVideo() && Settings.pauseWhenMinimized) {
+                player.pause();
+            } else {
+                // Nobody sees the video, only the audio needs to go on.
+                player.videoDecodingEnabled = false;
+            }
+        } else {
+            player.videoDecodingEnabled = true;
         }
     }
     Component.onCompleted: {
@@ -183,7 +189,7 @@ FramelessWindow {
         onDropped: {
             if (drop.hasUrls) {
                 if ((drop.proposedAction === Qt.MoveAction) || (drop.proposedAction === Qt.CopyAction)) {
-                    player.source = drop.urls[0];
+                    player.open(drop.urls[0]);
                     drop.acceptProposedAction();
                     return;
                 }
@@ -295,7 +301,7 @@ FramelessWindow {
             if (selectedUrl !== "") {
                 Settings.file = selectedUrl;
                 Settings.dir = dir;
-                player.source = selectedUrl;
+                player.open(selectedUrl);
             }
         }
     }
@@ -46,6 +46,7 @@ Item {
     property alias videoSize: player.videoSize
     property alias logLevel: player.logLevel
     property alias hardwareDecoding: player.hardwareDecoding
+    property alias videoDecodingEnabled: player.videoDecodingEnabled
     property alias snapshotFormat: player.snapshotFormat
     property alias snapshotDirectory: player.snapshotDirectory
     property alias seekable: player.seekable
@@ -68,6 +69,11 @@ Item {
         messageLabelTimer.restart();
     }
 
+    function open(url) {
+        // Passing the resume position into the initial load saves decoding from the start and seeking afterwards.
+        player.open(url, Settings.startFromLastPosition ? History.getLastPosition(url) : 0);
+    }
+
     function togglePlayPause() {
         if (player.playbackState !== QtMediaPlayer.Stopped) {
             if (player.playbackState === QtMediaPlayer.Playing) {
@@ -214,12 +220,7 @@ Item {
     MediaPlayer {
         id: player
         anchors.fill: parent
-        onLoaded: {
-            root.loaded();
-            if (Settings.startFromLastPosition) {
-                position = History.getLastPosition(source);
-            }
-        }
+        onLoaded: root.loaded()
         onPlaying: {
             showMessage(qsTr("Playing"));
             root.playing();
@@ -294,10 +295,14 @@ Item {
                 showMessage(qsTr("Seek to: %1%").arg(Math.round(positionSlider.value / player.duration * 100.0)));
                 player.seek(positionSlider.value);
             }
+            // Key frame seeks while dragging, one exact seek once released.
+            onPressedChanged: player.scrubbing = positionSlider.pressed
             onPreviewPositionChanged: {
                 if (Settings.enableTimelinePreview) {
                     let percent = (mouseX - positionSlider.leftPadding) / positionSlider.availableWidth;
-                    timelinePreviewPlayer.seek(timelinePreviewPlayer.duration * percent);
+                    timelinePreviewPlayer.position = player.duration * percent;
+                    // Make a click at the hovered position as fast as possible.
+                    player.prefetchAt(timelinePreviewPlayer.position);
                     let newX = mouseX + positionSlider.x - (timelinePreviewPlayer.width / 2.0);
                     if (newX < 0) {
                         newX = 0;
@@ -345,13 +350,11 @@ Item {
         color: Qt.color("yellow")
     }
 
-    MediaPlayer {
+    ThumbnailIndex {
         id: timelinePreviewPlayer
-        enabled: Settings.enableTimelinePreview && (player.playbackState !== QtMediaPlayer.Stopped)
         visible: false
-        hardwareDecoding: false
-        livePreview: true
-        source: player.source
+        // Only index the media when the preview is actually wanted.
+        source: Settings.enableTimelinePreview ? player.source : ""
         x: 0
         y: parent.height - controlPanel.height - height
         width: parent.width * Settings.timelinePreviewZoomFactor
@@ -368,7 +371,7 @@ Item {
                 bold: true
                 pointSize: 15
             }
-            text: timelinePreviewPlayer.formatTime(timelinePreviewPlayer.position, "hh:mm:ss")
+            text: player.formatTime(timelinePreviewPlayer.position, "hh:mm:ss")
         }
     }
 
@@ -23,9 +23,11 @@
  */
 
 #include "../../common/backendinterface.h"
+#include "../../common/resourcegovernor.h"
 #include "include/mdk/global.h"
 #include "mdkplayer.h"
 #include "mdkqthelper.h"
+#include "mdkthumbnaildecoder.h"
 
 QTMEDIAPLAYER_BEGIN_NAMESPACE
 Q_LOGGING_CATEGORY(lcQMPMDK, "wangwenx190.qtmediaplayer.mdk")
@@ -136,6 +138,7 @@ public:
 #if (QT_VERSION >= QT_VERSION_CHECK(5, 14, 0))
         case QSGRendererInterface::OpenGL:
 #endif
+        case QSGRendererInterface::Software:
             return true;
         default:
             return false;
@@ -165,6 +168,9 @@ public:
         }
         m_initialized = true;
         QTMEDIAPLAYER_REGISTER_CUSTOM_TYPES(MDKPlayer)
+        QTMEDIAPLAYER_QML_NAMED_REGISTER(QTMEDIAPLAYER_PREPEND_NAMESPACE(MDKThumbnailIndex), ThumbnailIndex);
+        QTMEDIAPLAYER_QML_NAMED_REGISTER(QTMEDIAPLAYER_PREPEND_NAMESPACE(MDKStreamSwitcher), StreamSwitcher);
+        QTMEDIAPLAYER_QML_SINGLETON_REGISTER(QTMEDIAPLAYER_PREPEND_NAMESPACE(ResourceGovernor), ResourceGovernor);
         return true;
     }
 
@@ -0,0 +1,147 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "mdkdecoderbenchmarker.h"
+#include "mdkqthelper.h"
+#include "include/mdk/Player.h"
+#include <QtCore/qdebug.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qdeadlinetimer.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qwaitcondition.h>
+#include <limits>
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+// Network sources may take a while, but a stuck worker must not block forever.
+static constexpr const int kDecodeTimeout = 30000;
+
+// Software decoders of FFmpeg besides the native ones, only used if MDK's
+// FFmpeg build has them.
+static const QHash<QString, QStringList> kExternalDecoders = {
+    {QStringLiteral("av1"), {QStringLiteral("FFmpeg:codec=libdav1d"), QStringLiteral("FFmpeg:codec=libaom-av1")}},
+    {QStringLiteral("vp9"), {QStringLiteral("FFmpeg:codec=libvpx-vp9")}},
+    {QStringLiteral("vp8"), {QStringLiteral("FFmpeg:codec=libvpx")}},
+    {QStringLiteral("h264"), {QStringLiteral("FFmpeg:codec=libopenh264")}}
+};
+
+MDKDecoderBenchmarker::MDKDecoderBenchmarker() = default;
+
+MDKDecoderBenchmarker::~MDKDecoderBenchmarker() = default;
+
+QString MDKDecoderBenchmarker::decoderName(const DecoderConfig &config)
+{
+    // Unknown options are passed on to the codec context of FFmpeg.
+    return (config.sliceThreads ? (config.decoder + QStringLiteral(":thread_type=slice")) : config.decoder);
+}
+
+QList<DecoderConfig> MDKDecoderBenchmarker::candidates(const QString &codec)
+{
+    Q_ASSERT(!codec.isEmpty());
+    if (codec.isEmpty()) {
+        return {};
+    }
+    // Naming the codec explicitly keeps the entry from being used for any other
+    // codec: FFmpeg refuses to open a decoder for a stream of another codec.
+    DecoderConfig config = {};
+    config.decoder = QStringLiteral("FFmpeg:codec=") + codec;
+    QList<DecoderConfig> result = {config};
+    config.sliceThreads = true;
+    result.append(config);
+    config.sliceThreads = false;
+    // MDK's own AV1 decoder plugin.
+    if (codec == QStringLiteral("av1")) {
+        config.decoder = QStringLiteral("dav1d");
+        result.append(config);
+    }
+    const QStringList externalDecoders = kExternalDecoders.value(codec);
+    for (auto &&decoder : qAsConst(externalDecoders)) {
+        config.decoder = decoder;
+        result.append(config);
+    }
+    return result;
+}
+
+int MDKDecoderBenchmarker::decode(const QUrl &url, const DecoderConfig &config, const int frameCount)
+{
+    Q_ASSERT(url.isValid());
+    Q_ASSERT(!config.decoder.isEmpty());
+    Q_ASSERT(frameCount > 0);
+    if (!url.isValid() || config.decoder.isEmpty() || (frameCount <= 0)) {
+        return 0;
+    }
+    if (!MDK::Qt::isMDKAvailable()) {
+        qCWarning(lcQMPMDK) << "MDK is not available.";
+        return 0;
+    }
+    QMutex mutex;
+    QWaitCondition condition;
+    int frames = 0;
+    bool finished = false;
+    MDK_NS_PREPEND(Player) player;
+    player.setMute(true);
+    // The one and only decoder, MDK must not fall back to another one.
+    player.setDecoders(MDK_NS_PREPEND(MediaType)::Video, {qUtf8Printable(decoderName(config))});
+    player.onFrame<MDK_NS_PREPEND(VideoFrame)>([&](MDK_NS_PREPEND(VideoFrame) &frame, int track){
+        Q_UNUSED(track);
+        QMutexLocker locker(&mutex);
+        // An invalid frame marks the end of the stream.
+        if (frame.isValid()) {
+            ++frames;
+        }
+        if (!frame.isValid() || (frames >= frameCount)) {
+            finished = true;
+            condition.wakeAll();
+        }
+        return 0;
+    });
+    const QString path = (url.isLocalFile() ? QDir::toNativeSeparators(url.toLocalFile()) : url.toString());
+    player.setMedia(qUtf8Printable(path));
+    player.setActiveTracks(MDK_NS_PREPEND(MediaType)::Audio, {});
+    player.setActiveTracks(MDK_NS_PREPEND(MediaType)::Subtitle, {});
+    // MDK paces the frames by its clock even without any renderer, a sync clock
+    // which is always at the end of the stream lets every frame through at once.
+    player.onSync([](){
+        return std::numeric_limits<double>::max();
+    });
+    player.set(MDK_NS_PREPEND(PlaybackState)::Playing);
+    {
+        QMutexLocker locker(&mutex);
+        const QDeadlineTimer deadline(kDecodeTimeout);
+        while (!finished) {
+            if (!condition.wait(&mutex, deadline)) {
+                break;
+            }
+        }
+    }
+    // The frame callback refers to our locals, it must be gone before them.
+    player.onFrame<MDK_NS_PREPEND(VideoFrame)>(nullptr);
+    player.onSync(nullptr);
+    player.set(MDK_NS_PREPEND(PlaybackState)::Stopped);
+    player.waitFor(MDK_NS_PREPEND(PlaybackState)::Stopped);
+    QMutexLocker locker(&mutex);
+    return qMin(frames, frameCount);
+}
+
+QTMEDIAPLAYER_END_NAMESPACE
@@ -26,17 +26,32 @@
 #include "mdkbackend.h"
 #include "mdkvideotexturenode.h"
 #include "mdkqthelper.h"
+#include "mdkthumbnaildecoder.h"
+#include "mdkdecoderbenchmarker.h"
 #include "../../common/backendinterface.h"
+#include "../../common/framebackcache.h"
+#include "../../common/keyframeindex.h"
 #include "include/mdk/Player.h"
 #include <QtCore/qdebug.h>
 #include <QtCore/qdir.h>
 #include <QtCore/qdatetime.h>
+#include <QtCore/qrunnable.h>
+#include <QtCore/qmath.h>
 #include <QtQuick/qquickwindow.h>
+#include <cmath>
+#include <cstring>
+#include <utility>
 
 QTMEDIAPLAYER_BEGIN_NAMESPACE
 
 [[nodiscard]] extern MDKVideoTextureNode *createNode(MDKPlayer *item);
 
+// Milliseconds between two key frames shown while playing backwards in trick play.
+static constexpr const qreal kTrickPlayInterval = 100.0;
+
+// MDK's default lower bound of the buffer, in milliseconds.
+static constexpr const qint64 kMinimumBufferDuration = 1000;
+
 [[nodiscard]] static inline std::vector<std::string> qStringListToStdStringVector(const QStringList &stringList)
 {
     if (stringList.isEmpty()) {
@@ -49,6 +64,23 @@ QTMEDIAPLAYER_BEGIN_NAMESPACE
     return result;
 }
 
+[[nodiscard]] static inline YUVConverter::PixelFormat toYUVConverterPixelFormat(const MDK_NS_PREPEND(PixelFormat) format)
+{
+    switch (format) {
+    case MDK_NS_PREPEND(PixelFormat)::NV12:
+        return YUVConverter::PixelFormat::NV12;
+    case MDK_NS_PREPEND(PixelFormat)::YUV420P:
+        return YUVConverter::PixelFormat::I420;
+    // Only the high byte of each sample is used, so P016 looks exactly the same as P010.
+    case MDK_NS_PREPEND(PixelFormat)::P010LE:
+    case MDK_NS_PREPEND(PixelFormat)::P016LE:
+        return YUVConverter::PixelFormat::P010;
+    default:
+        break;
+    }
+    return YUVConverter::PixelFormat::Unknown;
+}
+
 [[nodiscard]] static inline QString urlToString(const QUrl &value, const bool display = false)
 {
     if (!value.isValid()) {
@@ -128,6 +160,10 @@ void MDKPlayer::initialize()
     // Default to software decoding.
     m_player->setDecoders(MDK_NS_PREPEND(MediaType)::Video, {"FFmpeg"});
 
+    // The next media of the queue is opened and decoded right away, instead of
+    // when the current one is about to end.
+    m_player->setPreloadImmediately(true);
+
     m_snapshotDirectory = QDir::toNativeSeparators(QCoreApplication::applicationDirPath());
 
     connect(this, &MDKPlayer::sourceChanged, this, &MDKPlayer::fileNameChanged);
@@ -148,6 +184,40 @@ void MDKPlayer::initialize()
     });
     m_timer.start();
 
+    m_reverseTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_reverseTimer, &QTimer::timeout, this, &MDKPlayer::stepReversePlayback);
+
+    connect(this, &MDKPlayer::sourceChanged, this, [this](){
+        stopReversePlayback();
+        leaveReverseMode();
+        if (m_backCache) {
+            m_backCache->open(source());
+        }
+    });
+
+    // The automatic display sync mode depends on the frame rate of the video.
+    connect(this, &MDKPlayer::loaded, this, [this](){
+        if (displaySync() == DisplaySync::Auto) {
+            applyDisplaySync();
+        }
+        // The cache size is translated into a duration, which needs the bit rate.
+        if (effectiveCacheSize() > 0) {
+            applyResourceLimits();
+        }
+        // Keep the new media in background mode as well.
+        if (!videoDecodingEnabled()) {
+            applyVideoDecoding();
+        }
+        updateSoftwareFrameColors();
+        // The decoders are created already, this only starts the calibration of
+        // a new codec, for the next media.
+        const auto &videoStreams = m_player->mediaInfo().video;
+        if (!videoStreams.empty()) {
+            DecoderConfig config = {};
+            Q_UNUSED(selectDecoder(QString::fromUtf8(videoStreams.front().codec.codec), source(), &config));
+        }
+    });
+
     connect(this, &MDKPlayer::rendererReadyChanged, this, [this](){
         if (!m_rendererReady) {
             return;
@@ -165,6 +235,8 @@ void MDKPlayer::deinitialize()
     if (!isStopped()) {
         stop();
     }
+    // The software frame sink captures "this", it must not outlive us.
+    m_player->onFrame<MDK_NS_PREPEND(VideoFrame)>(nullptr);
     if (!m_livePreview) {
         qCDebug(lcQMPMDK) << "Player destroyed.";
     }
@@ -216,6 +288,12 @@ QString MDKPlayer::ffmpegConfiguration() const
 void MDKPlayer::invalidateSceneGraph() // Called on the render thread when the scenegraph is invalidated.
 {
     m_node = nullptr;
+    // The graphics resources are going away, so is the renderer bound to them.
+    const auto win = window();
+    if (m_player && win) {
+        m_player->setVideoSurfaceSize(-1, -1, win);
+        qCDebug(lcQMPMDK) << "Renderer destroyed.";
+    }
 }
 
 void MDKPlayer::setRendererReady(const bool value)
@@ -227,9 +305,47 @@ void MDKPlayer::setRendererReady(const bool value)
     Q_EMIT rendererReadyChanged();
 }
 
+void MDKPlayer::applyDisplaySync()
+{
+    if (!m_player) {
+        return;
+    }
+    const qreal videoFrameRate = this->videoFrameRate();
+    const qreal refreshRate = displayRefreshRate();
+    // Zero means "follow the frame timestamps", which is MDK's default.
+    float frameRate = 0.0f;
+    // MDK has no audio resampling for this, but pacing the video at an exact fraction
+    // of the refresh rate gives the same even cadence. Frame dropping and repeating
+    // against the clock is what MDK does by default anyway.
+    if ((effectiveDisplaySync(videoFrameRate) == DisplaySync::Resample)
+            && (refreshRate > 0.0) && (videoFrameRate > 0.0)) {
+        const qreal repeatCount = qMax(qreal(1.0), std::round(refreshRate / videoFrameRate));
+        frameRate = static_cast<float>(refreshRate / repeatCount);
+    }
+    m_player->setFrameRate(frameRate);
+    if (!m_livePreview) {
+        qCDebug(lcQMPMDK) << "Video frame rate -->" << frameRate;
+    }
+}
+
 void MDKPlayer::releaseResources() // Called on the gui thread if the item is removed from scene.
 {
     m_node = nullptr;
+    // The item is leaving this window, the renderer bound to it won't be used any more.
+    // It must be released on the render thread of the window it belongs to.
+    const auto win = window();
+    if (!win) {
+        return;
+    }
+    const QWeakPointer<MDK_NS_PREPEND(Player)> weakPlayer = m_player;
+    win->scheduleRenderJob(QRunnable::create([weakPlayer, win](){
+        const auto player = weakPlayer.lock();
+        if (!player) {
+            return;
+        }
+        player->setVideoSurfaceSize(-1, -1, win);
+        qCDebug(lcQMPMDK) << "Renderer destroyed.";
+    }), QQuickWindow::NoStage);
 }
 
 QSGNode *MDKPlayer::updatePaintNode(QSGNode *node, UpdatePaintNodeData *data)
@@ -275,13 +391,19 @@ QUrl MDKPlayer::source() const
 
 void MDKPlayer::setSource(const QUrl &value)
 {
+    const qint64 startPosition = qMax(takeStartPosition(), std::exchange(m_cachedStartPosition, 0));
     if (!m_rendererReady) {
         m_cachedUrl = value;
+        m_cachedStartPosition = startPosition;
         return;
     }
     const auto realStop = [this]() -> void {
+        {
+            QMutexLocker locker(&m_nextMediaMutex);
+            m_nextMediaPath.clear();
+        }
         m_player->setMedia(nullptr);
-        m_player->setNextMedia(nullptr);
+        m_player->setNextMedia(nullptr, -1);
         m_player->set(MDK_NS_PREPEND(PlaybackState)::Stopped);
         m_player->waitFor(MDK_NS_PREPEND(PlaybackState)::Stopped);
     };
@@ -315,9 +437,13 @@ void MDKPlayer::setSource(const QUrl &value)
     }
     realStop();
     m_player->setMedia(qUtf8Printable(urlToString(value)));
+    startFirstFrameTimer();
     Q_EMIT sourceChanged();
-    // It's necessary to call "prepare()", otherwise we'll get no picture.
-    m_player->prepare();
+    // It's necessary to call "prepare()", otherwise we'll get no picture. Starting
+    // at the resume position right away avoids decoding from zero and seeking afterwards.
+    m_player->prepare(startPosition, nullptr, MDK_NS_PREPEND(SeekFlag)::FromStart);
+    // Stopping the previous media dropped the preloaded one as well.
+    applyNextMedia();
     if (m_autoStart && !m_livePreview) {
         m_player->set(MDK_NS_PREPEND(PlaybackState)::Playing);
     }
@@ -337,12 +463,15 @@ QString MDKPlayer::filePath() const
 
 qint64 MDKPlayer::position() const
 {
+    if (m_reversePosition >= 0) {
+        return m_reversePosition;
+    }
     return isLoaded() ? m_player->position() : 0;
 }
 
 void MDKPlayer::setPosition(const qint64 value)
 {
-    seek(value);
+    seek(value, SeekMode::Exact);
 }
 
 qint64 MDKPlayer::duration() const
@@ -405,7 +534,7 @@ void MDKPlayer::setMute(const bool value)
         return;
     }
     m_mute = value;
-    m_player->setMute(m_mute);
+    m_player->setMute(m_mute || trickPlay());
     Q_EMIT muteChanged();
     if (!m_livePreview) {
         qCDebug(lcQMPMDK) << "Mute -->" << m_mute;
@@ -420,6 +549,10 @@ bool MDKPlayer::seekable() const
 
 PlaybackState MDKPlayer::playbackState() const
 {
+    // MDK itself is paused while playing backwards.
+    if (m_reverseTimer.isActive()) {
+        return PlaybackState::Playing;
+    }
     switch (m_player->state()) {
     case MDK_NS_PREPEND(PlaybackState)::Playing:
         return PlaybackState::Playing;
@@ -437,13 +570,12 @@ void MDKPlayer::setPlaybackState(const PlaybackState value)
         return;
     }
     switch (value) {
-    case PlaybackState::Playing: {
-        if (!m_livePreview) {
-            m_player->set(MDK_NS_PREPEND(PlaybackState)::Playing);
-        }
-    } break;
+    // Both of them know about playing backwards.
+    case PlaybackState::Playing:
+        play();
+        break;
     case PlaybackState::Paused:
-        m_player->set(MDK_NS_PREPEND(PlaybackState)::Paused);
+        pause();
         break;
     case PlaybackState::Stopped:
         m_player->set(MDK_NS_PREPEND(PlaybackState)::Stopped);
@@ -504,6 +636,9 @@ void MDKPlayer::setLogLevel(const LogLevel value)
 
 qreal MDKPlayer::playbackRate() const
 {
+    if (m_reverseRate > 0.0) {
+        return -m_reverseRate;
+    }
     return static_cast<qreal>(m_player->playbackRate());
 }
 
@@ -512,11 +647,28 @@ void MDKPlayer::setPlaybackRate(const qreal value)
     if (qFuzzyCompare(value, playbackRate())) {
         return;
     }
-    if (value <= 0.0) {
+    if (qFuzzyIsNull(value)) {
         qCWarning(lcQMPMDK) << "The user is trying to change the playback rate to" << value << ", which is not allowed.";
         return;
     }
-    m_player->setPlaybackRate(value);
+    if (value < 0.0) {
+        if (!keyframeIndex()) {
+            qCWarning(lcQMPMDK) << "Playing backwards is only possible once the key frame index is ready.";
+            return;
+        }
+        m_reverseRate = -value;
+        if (m_reverseTimer.isActive() || isPlaying()) {
+            startReversePlayback();
+        }
+    } else {
+        const bool reversing = m_reverseTimer.isActive();
+        m_reverseRate = 0.0;
+        stopReversePlayback();
+        m_player->setPlaybackRate(value);
+        if (reversing) {
+            play();
+        }
+    }
     Q_EMIT playbackRateChanged();
     if (!m_livePreview) {
         qCDebug(lcQMPMDK) << "Playback rate -->" << value;
@@ -606,38 +758,6 @@ bool MDKPlayer::hardwareDecoding() const
 
 void MDKPlayer::setHardwareDecoding(const bool value)
 {
-    const auto setVideoDecoders = [this](const QStringList &decoders) -> void
-    {
-        const QStringList videoDecoders = decoders.isEmpty() ? QStringList{QStringLiteral("FFmpeg")} : decoders;
-        m_player->setDecoders(MDK_NS_PREPEND(MediaType)::Video, qStringListToStdStringVector(videoDecoders));
-        if (!m_livePreview) {
-            qCDebug(lcQMPMDK) << "Video decoders -->" << videoDecoders;
-        }
-    };
-    // The order is important. Only FFmpeg is software decoding.
-    static const QStringList defaultVideoDecoders =
-    {
-#ifdef Q_OS_WINDOWS
-        QStringLiteral("MFT:d3d=11"),
-        QStringLiteral("MFT:d3d=9"),
-        QStringLiteral("MFT"),
-        QStringLiteral("D3D11"),
-        QStringLiteral("DXVA"),
-        QStringLiteral("CUDA"),
-        QStringLiteral("NVDEC"),
-#elif (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
-        QStringLiteral("VAAPI"),
-        QStringLiteral("VDPAU"),
-        QStringLiteral("CUDA"),
-        QStringLiteral("NVDEC"),
-#elif (defined(Q_OS_MACOS) || defined(Q_OS_IOS))
-        QStringLiteral("VT"),
-        QStringLiteral("VideoToolbox"),
-#elif defined(Q_OS_ANDROID)
-        QStringLiteral("AMediaCodec"),
-#endif
-        QStringLiteral("FFmpeg")
-    };
     if (m_hardwareDecoding != value) {
         m_hardwareDecoding = value;
         if (m_hardwareDecoding) {
@@ -646,10 +766,8 @@ void MDKPlayer::setHardwareDecoding(const bool value)
                 warningOnce = true;
                 qCWarning(lcQMPMDK).noquote() << hardwareDecodingWarningText;
             }
-            setVideoDecoders(defaultVideoDecoders);
-        } else {
-            setVideoDecoders({QStringLiteral("FFmpeg")});
         }
+        applyVideoDecoders();
         Q_EMIT hardwareDecodingChanged();
         if (!m_livePreview) {
             qCDebug(lcQMPMDK) << "Hardware decoding -->" << m_hardwareDecoding;
@@ -657,6 +775,55 @@ void MDKPlayer::setHardwareDecoding(const bool value)
     }
 }
 
+void MDKPlayer::applyVideoDecoders()
+{
+    QStringList videoDecoders = (m_hardwareDecoding ? hardwareVideoDecoders : QStringList{QStringLiteral("FFmpeg")});
+    // MDK tries the decoders in order, the calibrated entries only work for
+    // their own codec and fall through to plain FFmpeg for all others.
+    if (!m_hardwareDecoding && autoSelectDecoder() && !m_livePreview) {
+        if (DecoderCalibration * const calibration = DecoderCalibration::instance()) {
+            const QHash<QString, DecoderConfig> configs = calibration->bestConfigs(backendName(), backendVersion());
+            for (auto &&config : qAsConst(configs)) {
+                videoDecoders.prepend(MDKDecoderBenchmarker::decoderName(config));
+            }
+        }
+    }
+    // The frames and filters are discarded before they are decoded. FFmpeg based
+    // decoders understand these options, the others just ignore them. So does
+    // "lowres" for most codecs.
+    const DecodeShortcuts shortcuts = decodeShortcuts();
+    const QString defaultLevel = QStringLiteral("default");
+    QString options = {};
+    if (shortcuts.skipFrame != defaultLevel) {
+        options.append(QStringLiteral(":skip_frame=") + shortcuts.skipFrame);
+    }
+    if (shortcuts.skipLoopFilter != defaultLevel) {
+        options.append(QStringLiteral(":skip_loop_filter=") + shortcuts.skipLoopFilter);
+    }
+    if (shortcuts.lowres > 0) {
+        options.append(QStringLiteral(":lowres=%1").arg(shortcuts.lowres));
+    }
+    if (shortcuts.fast) {
+        options.append(QStringLiteral(":flags2=+fast"));
+    }
+    if (!options.isEmpty()) {
+        for (auto &&decoder : videoDecoders) {
+            decoder.append(options);
+        }
+    }
+    const int threadCount = effectiveDecoderThreads();
+    if (threadCount > 0) {
+        const QString threads = QStringLiteral(":threads=%1").arg(threadCount);
+        for (auto &&decoder : videoDecoders) {
+            decoder.append(threads);
+        }
+    }
+    m_player->setDecoders(MDK_NS_PREPEND(MediaType)::Video, qStringListToStdStringVector(videoDecoders));
+    if (!m_livePreview) {
+        qCDebug(lcQMPMDK) << "Video decoders -->" << videoDecoders;
+    }
+}
+
 bool MDKPlayer::autoStart() const
 {
     return m_autoStart;
@@ -690,17 +857,17 @@ void MDKPlayer::setLivePreview(const bool value)
             // Disable media tracks that are not needed.
             m_player->setActiveTracks(MDK_NS_PREPEND(MediaType)::Audio, {});
             m_player->setActiveTracks(MDK_NS_PREPEND(MediaType)::Subtitle, {});
-            // Decode as soon as possible when media data received.
-            m_player->setBufferRange(0);
+            // Decode as soon as possible when media data received (the preview profile).
+            applyPerformanceProfile();
             // Prevent player stop playing after EOF is reached.
             m_player->setProperty("continue_at_end", "1");
             // And don't forget to use accurate seek.
         } else {
             // Restore everything to default.
-            m_player->setBufferRange(1000);
+            applyPerformanceProfile();
             m_player->setActiveTracks(MDK_NS_PREPEND(MediaType)::Audio, {m_activeAudioTrack});
             m_player->setActiveTracks(MDK_NS_PREPEND(MediaType)::Subtitle, {m_activeSubtitleTrack});
-            m_player->setMute(m_mute);
+            m_player->setMute(m_mute || trickPlay());
             m_player->setProperty("continue_at_end", "0");
         }
         Q_EMIT livePreviewChanged();
@@ -847,7 +1014,10 @@ void MDKPlayer::setActiveVideoTrack(const int value)
     if (m_activeVideoTrack == track) {
         return;
     }
-    m_player->setActiveTracks(MDK_NS_PREPEND(MediaType)::Video, {track});
+    // Without video decoding or while suspended, the selection is only applied later.
+    if (videoDecodingEnabled() && !suspended()) {
+        m_player->setActiveTracks(MDK_NS_PREPEND(MediaType)::Video, {track});
+    }
     m_activeVideoTrack = track;
     Q_EMIT activeVideoTrackChanged();
 }
@@ -880,7 +1050,9 @@ void MDKPlayer::setActiveAudioTrack(const int value)
     if (m_activeAudioTrack == track) {
         return;
     }
-    m_player->setActiveTracks(MDK_NS_PREPEND(MediaType)::Audio, {track});
+    if (!suspended()) {
+        m_player->setActiveTracks(MDK_NS_PREPEND(MediaType)::Audio, {track});
+    }
     m_activeAudioTrack = track;
     Q_EMIT activeAudioTrackChanged();
 }
@@ -913,7 +1085,9 @@ void MDKPlayer::setActiveSubtitleTrack(const int value)
     if (m_activeSubtitleTrack == track) {
         return;
     }
-    m_player->setActiveTracks(MDK_NS_PREPEND(MediaType)::Subtitle, {track});
+    if (!suspended()) {
+        m_player->setActiveTracks(MDK_NS_PREPEND(MediaType)::Subtitle, {track});
+    }
     m_activeSubtitleTrack = track;
     Q_EMIT activeSubtitleTrackChanged();
 }
@@ -928,6 +1102,16 @@ void MDKPlayer::play()
     if (!source().isValid() || m_livePreview) {
         return;
     }
+    if (m_reverseRate > 0.0) {
+        startReversePlayback();
+        return;
+    }
+    // MDK is still where the backwards stepping started.
+    if (m_reversePosition >= 0) {
+        const qint64 target = m_reversePosition;
+        leaveReverseMode();
+        seek(target, SeekMode::Exact);
+    }
     m_player->set(MDK_NS_PREPEND(PlaybackState)::Playing);
 }
 
@@ -936,6 +1120,7 @@ void MDKPlayer::pause()
     if (!source().isValid()) {
         return;
     }
+    stopReversePlayback();
     m_player->set(MDK_NS_PREPEND(PlaybackState)::Paused);
 }
 
@@ -944,33 +1129,369 @@ void MDKPlayer::stop()
     if (!source().isValid()) {
         return;
     }
+    stopReversePlayback();
+    leaveReverseMode();
+    {
+        QMutexLocker locker(&m_nextMediaMutex);
+        m_nextMediaPath.clear();
+    }
     m_player->setMedia(nullptr);
-    m_player->setNextMedia(nullptr);
+    m_player->setNextMedia(nullptr, -1);
     m_player->set(MDK_NS_PREPEND(PlaybackState)::Stopped);
 }
 
-void MDKPlayer::seek(const qint64 value)
+bool MDKPlayer::doSeek(const qint64 value, const bool exact)
 {
+    if (value != m_pendingReversePosition) {
+        m_pendingReversePosition = -1;
+    }
+    // MDK has to catch up with the frame shown from the back cache.
+    leaveReverseMode();
     if (!isLoaded() || (value == position())) {
-        return;
+        return false;
     }
     const auto &mi = m_player->mediaInfo();
     if (value < mi.start_time) {
         qCWarning(lcQMPMDK) << "Media start time is" << mi.start_time
                             << ", however, the user is trying to seek to" << value;
-        return;
+        return false;
     }
     if (value > mi.duration) {
         qCWarning(lcQMPMDK) << "Media duration is" << mi.duration
                             << ", however, the user is trying to seek to" << value;
+        return false;
+    }
+    const auto flags = (exact ? MDK_NS_PREPEND(SeekFlag)::FromStart : MDK_NS_PREPEND(SeekFlag)::Default);
+    // MDK skips a seek while the previous one is unfinished, the scheduler never
+    // overlaps them. The callback comes from one of MDK's threads.
+    const bool result = m_player->seek(value, flags, [this](int64_t ret){
+        Q_UNUSED(ret);
+        QMetaObject::invokeMethod(this, [this](){
+            seekFinished();
+            // In case the playback is paused.
+            Q_EMIT positionChanged();
+        }, Qt::QueuedConnection);
+    });
+    if (!result) {
+        return false;
+    }
+    if (!m_livePreview) {
+        qCDebug(lcQMPMDK) << "Seek -->" << value << (exact ? "(exact)" : "(key frame)");
+    }
+    return true;
+}
+
+void MDKPlayer::stepForward()
+{
+    if (!isLoaded()) {
         return;
     }
-    // We have to seek accurately when we are in live preview mode.
-    m_player->seek(value, m_livePreview ? MDK_NS_PREPEND(SeekFlag)::FromStart : MDK_NS_PREPEND(SeekFlag)::Default);
-    // In case the playback is paused.
-    Q_EMIT positionChanged();
+    stopReversePlayback();
+    if (m_reversePosition >= 0) {
+        const auto index = keyframeIndex();
+        const qint64 next = (index ? index->frameToTimestamp(index->timestampToFrame(m_reversePosition) + 1) : -1);
+        if ((next >= 0) && showCachedFrame(next)) {
+            return;
+        }
+        const qint64 target = ((next >= 0) ? next : m_reversePosition);
+        leaveReverseMode();
+        seek(target, SeekMode::Exact);
+        return;
+    }
+    m_player->set(MDK_NS_PREPEND(PlaybackState)::Paused);
+    // Goes through the seek scheduler: MDK would skip the step while a seek is
+    // running, and a seek while the step is.
+    requestStep(1);
+}
+
+bool MDKPlayer::doStep(const int frames)
+{
+    if (!isLoaded()) {
+        return false;
+    }
+    const bool result = m_player->seek(frames, MDK_NS_PREPEND(SeekFlag)::Frame | MDK_NS_PREPEND(SeekFlag)::FromNow, [this](int64_t ret){
+        Q_UNUSED(ret);
+        QMetaObject::invokeMethod(this, [this](){
+            seekFinished();
+            notifyChanged(PropertyChange::Position);
+        }, Qt::QueuedConnection);
+    });
+    if (result && !m_livePreview) {
+        qCDebug(lcQMPMDK) << "Step -->" << frames << "frames";
+    }
+    return result;
+}
+
+void MDKPlayer::stepBackward()
+{
+    if (!isLoaded()) {
+        return;
+    }
+    stopReversePlayback();
+    m_player->set(MDK_NS_PREPEND(PlaybackState)::Paused);
+    const qint64 current = position();
+    const auto index = keyframeIndex();
+    if (!index) {
+        // The best guess without an index is one frame duration back.
+        const qreal frameRate = videoFrameRate();
+        const qint64 frameDuration = ((frameRate > 0.0) ? qCeil(1000.0 / frameRate) : 40);
+        seek(qMax(qint64(0), current - frameDuration), SeekMode::Exact);
+        return;
+    }
+    const int frame = index->timestampToFrame(current);
+    if (frame <= 0) {
+        return;
+    }
+    const qint64 target = index->frameToTimestamp(frame - 1);
+    prefetchBackwards(target);
+    if (showCachedFrame(target)) {
+        return;
+    }
+    // Not decoded yet, MDK seeks there exactly meanwhile. The cached frame
+    // takes over once it's ready, so that the following steps are instant.
+    seek(target, SeekMode::Exact);
+    m_pendingReversePosition = target;
+}
+
+void MDKPlayer::applyTrickPlay()
+{
+    if (!m_player) {
+        return;
+    }
+    applyVideoDecoders();
+    // Audio is just noise at such rates, and time stretching it isn't free either.
+    if (!m_livePreview) {
+        m_player->setMute(m_mute || trickPlay());
+    }
+    // Playing backwards jumps from key frame to key frame now, or the other way around.
+    if (m_reverseTimer.isActive()) {
+        startReversePlayback();
+    }
+}
+
+void MDKPlayer::applyLoopRange()
+{
+    if (!m_player) {
+        return;
+    }
+    // MDK has no seekable packet cache, but its own A-B loop prepares the jump
+    // back to the loop start internally, which avoids most of the gap.
+    if (loopStart() >= 0) {
+        m_player->setRange(loopStart(), loopEnd());
+        m_player->setLoop(-1);
+    } else {
+        m_player->setLoop(0);
+        m_player->setRange(0);
+    }
+}
+
+void MDKPlayer::applyNextMedia()
+{
+    if (!m_player || m_livePreview) {
+        return;
+    }
+    const QUrl next = nextMedia();
+    const QString path = urlToString(next);
+    {
+        QMutexLocker locker(&m_nextMediaMutex);
+        m_nextMediaPath = path;
+    }
+    if (path.isEmpty()) {
+        m_player->setNextMedia(nullptr, -1);
+        return;
+    }
+    m_player->setNextMedia(qUtf8Printable(path));
+    qCDebug(lcQMPMDK) << "Next media -->" << urlToString(next, true);
+}
+
+void MDKPlayer::applyResourceLimits()
+{
+    if (!m_player) {
+        return;
+    }
+    applyVideoDecoders();
+    applyBufferRange();
+}
+
+qint64 MDKPlayer::queryMemoryUsage() const
+{
+    if (!m_player || !isLoaded()) {
+        return -1;
+    }
+    int64_t bytes = 0;
+    m_player->buffered(&bytes);
+    // The frames kept for stepping backwards, they survive a suspension.
+    const qint64 backCache = ((m_backCache ? m_backCache->memoryUsage() : 0) + m_reverseFrame.sizeInBytes());
+    return (qint64(bytes) + backCache);
+}
+
+FrameStatistics MDKPlayer::queryFrameStatistics()
+{
+    if (!m_player || !isLoaded()) {
+        return {};
+    }
+    FrameStatistics result = {};
+    result.presented = m_presentedFrames.load();
+    result.dropped = m_droppedFrames.load();
+    return result;
+}
+
+void MDKPlayer::applyDecodeQuality()
+{
+    if (!m_player) {
+        return;
+    }
+    // MDK renders with fixed bilinear scaling already and has no deinterlacer,
+    // dithering or debanding, only the decoder can save anything.
+    applyVideoDecoders();
+}
+
+void MDKPlayer::applyAudioOutput()
+{
+    if (!m_player) {
+        return;
+    }
+    // MDK tries the backends in order, an empty list restores its platform
+    // defaults. It has no options for the device buffer, so the buffer and
+    // period sizes and the low latency mode are ignored.
+    const QString output = audioOutput();
+    const QStringList backends = (output.isEmpty() ? QStringList{} : QStringList{output});
+    m_player->setAudioBackends(qStringListToStdStringVector(backends));
+    qCDebug(lcQMPMDK) << "Audio backends -->" << backends;
+}
+
+DecoderBenchmarker *MDKPlayer::createDecoderBenchmarker() const
+{
+    return new MDKDecoderBenchmarker;
+}
+
+CacheState MDKPlayer::queryCacheState()
+{
+    if (!m_player || !isLoaded()) {
+        m_lastBufferedBytes = -1;
+        return {};
+    }
+    int64_t bytes = 0;
+    const qint64 duration = m_player->buffered(&bytes);
+    CacheState result = {};
+    // MDK only buffers ahead of the playback position, in one piece.
+    const qint64 start = position();
+    if (duration > 0) {
+        result.ranges.append(qMakePair(start, start + duration));
+    }
+    // MDK doesn't report its input rate. What arrived is what the buffer grew
+    // by plus what the playback consumed meanwhile.
+    const qint64 elapsed = m_cacheStateTimer.restart();
+    const qint64 bitRate = m_player->mediaInfo().bit_rate;
+    if ((m_lastBufferedBytes >= 0) && (elapsed > 0) && (bitRate > 0)) {
+        const qint64 consumed = (isPlaying() ? (bitRate / 8 * elapsed / 1000) : 0);
+        result.inputRate = qMax(qint64(0), (bytes - m_lastBufferedBytes + consumed) * 1000 / elapsed);
+    }
+    m_lastBufferedBytes = bytes;
+    const MediaStatus status = mediaStatus();
+    result.underrun = (status.testFlag(MediaStatusFlag::Stalled) || status.testFlag(MediaStatusFlag::Buffering));
+    return result;
+}
+
+void MDKPlayer::applyBufferRange()
+{
+    const PerformanceSettings settings = performanceSettings();
+    qint64 minMs = kMinimumBufferDuration;
+    qint64 maxMs = -1;
+    // MDK waits for "minMs" before it starts decoding, so a deep read ahead
+    // only raises the upper bound.
+    const qint64 readAheadTime = effectiveReadAheadTime();
+    if (readAheadTime >= 0) {
+        minMs = qMin(readAheadTime, kMinimumBufferDuration);
+        if (readAheadTime > kMinimumBufferDuration) {
+            maxMs = readAheadTime;
+        }
+    }
+    // MDK limits its buffer by duration, not by size. It has no back buffer, so
+    // all of the memory budget goes to the read ahead.
+    const qint64 bitRate = m_player->mediaInfo().bit_rate;
+    const int cacheSize = effectiveCacheSize();
+    if ((cacheSize > 0) && (bitRate > 0)) {
+        const qint64 cacheMs = qMax(kMinimumBufferDuration, qint64(cacheSize) * 1024 * 1024 * 8 * 1000 / bitRate);
+        maxMs = ((maxMs < 0) ? cacheMs : qMin(maxMs, cacheMs));
+    }
+    // Dropping buffered non key frames is MDK's way of catching up when late.
+    m_player->setBufferRange(minMs, maxMs, settings.decoderFrameDrop);
     if (!m_livePreview) {
-        qCDebug(lcQMPMDK) << "Seek -->" << value;
+        qCDebug(lcQMPMDK) << "Buffer range -->" << minMs << maxMs << settings.decoderFrameDrop;
+    }
+}
+
+void MDKPlayer::applyPerformanceProfile()
+{
+    if (!m_player) {
+        return;
+    }
+    // MDK has neither scripts nor a configurable frame drop policy of the
+    // renderer, everything else is covered by these.
+    applyResourceLimits();
+    const PerformanceSettings settings = performanceSettings();
+    for (auto it = settings.backendOptions.constBegin(); it != settings.backendOptions.constEnd(); ++it) {
+        m_player->setProperty(qUtf8Printable(it.key()), qUtf8Printable(it.value().toString()));
+    }
+}
+
+void MDKPlayer::applyVideoDecoding()
+{
+    // Resuming takes care of it.
+    if (!m_player || suspended()) {
+        return;
+    }
+    if (!videoDecodingEnabled()) {
+        // No video packets reach the decoder anymore, the audio keeps playing.
+        m_player->setActiveTracks(MDK_NS_PREPEND(MediaType)::Video, {});
+        return;
+    }
+    m_player->setActiveTracks(MDK_NS_PREPEND(MediaType)::Video, {m_activeVideoTrack});
+    // While playing, the decoder simply picks up at the next key frame. A paused
+    // player gets no new packets though, its picture has to be re-synced.
+    if (isPaused()) {
+        resyncDecoders();
+    }
+}
+
+void MDKPlayer::applySuspension()
+{
+    if (!m_player) {
+        return;
+    }
+    if (suspended()) {
+        // The decoders go away together with their tracks, and nothing gets
+        // buffered for them anymore. The media itself stays open.
+        m_player->setActiveTracks(MDK_NS_PREPEND(MediaType)::Video, {});
+        m_player->setActiveTracks(MDK_NS_PREPEND(MediaType)::Audio, {});
+        m_player->setActiveTracks(MDK_NS_PREPEND(MediaType)::Subtitle, {});
+        return;
+    }
+    if (!m_livePreview) {
+        m_player->setActiveTracks(MDK_NS_PREPEND(MediaType)::Audio, {m_activeAudioTrack});
+        m_player->setActiveTracks(MDK_NS_PREPEND(MediaType)::Subtitle, {m_activeSubtitleTrack});
+    }
+    if (videoDecodingEnabled()) {
+        m_player->setActiveTracks(MDK_NS_PREPEND(MediaType)::Video, {m_activeVideoTrack});
+    }
+    resyncDecoders();
+}
+
+void MDKPlayer::resyncDecoders()
+{
+    if (!isLoaded()) {
+        return;
+    }
+    // Feeds the decoders from the previous key frame up to the current position.
+    // Unlike "doSeek()", a seek to where the player already is must not be skipped.
+    m_player->seek(position(), MDK_NS_PREPEND(SeekFlag)::FromStart);
+}
+
+void MDKPlayer::applyFrameCacheSize()
+{
+    if (m_backCache) {
+        m_backCache->setMemoryLimit(frameCacheSize());
     }
 }
 
@@ -1060,22 +1581,47 @@ void MDKPlayer::initMdkHandlers()
         if (!url.isValid()) {
             return;
         }
+        bool switched = false;
+        {
+            QMutexLocker locker(&m_nextMediaMutex);
+            if (!m_nextMediaPath.isEmpty() && (m_nextMediaPath == urlToString(url))) {
+                m_nextMediaPath.clear();
+                switched = true;
+            }
+        }
+        if (switched) {
+            // The previous media just ended, the preloaded one takes over.
+            startTransitionTimer();
+            QMetaObject::invokeMethod(this, [this](){
+                advanceQueue();
+                notifyChanged(PropertyChange::VideoSize);
+                resetInternalData();
+                Q_EMIT loaded();
+            }, Qt::QueuedConnection);
+        }
         if (!m_livePreview) {
             qCDebug(lcQMPMDK) << "Current media source -->" << urlToString(url, true);
         }
-        Q_EMIT sourceChanged();
+        notifyChanged(PropertyChange::Source);
     });
+    // The callbacks below come from MDK's threads. The members they change are
+    // only ever touched on the GUI thread, so the updates are queued there, and
+    // the signals are emitted from the same queued calls, after the new values
+    // are in place.
     m_player->onMediaStatusChanged([this](MDK_NS_PREPEND(MediaStatus) ms) {
-        m_mediaStatus = mediaStatusFromMDK(ms);
-        Q_EMIT mediaStatusChanged();
-        if ((m_mediaStatus & MediaStatusFlag::Prepared) && !m_loaded) {
-            m_loaded = true;
-            Q_EMIT loaded();
-            Q_EMIT videoSizeChanged();
-            resetInternalData();
-        }
+        const MediaStatus status = mediaStatusFromMDK(ms);
+        QMetaObject::invokeMethod(this, [this, status](){
+            m_mediaStatus = status;
+            notifyChanged(PropertyChange::MediaStatus);
+            if ((m_mediaStatus & MediaStatusFlag::Prepared) && !m_loaded) {
+                m_loaded = true;
+                notifyChanged(PropertyChange::VideoSize);
+                resetInternalData();
+                Q_EMIT loaded();
+            }
+        }, Qt::QueuedConnection);
         if (!m_livePreview) {
-            qCDebug(lcQMPMDK) << "Current media status -->" << m_mediaStatus;
+            qCDebug(lcQMPMDK) << "Current media status -->" << status;
         }
         return true;
     });
@@ -1092,29 +1638,35 @@ void MDKPlayer::initMdkHandlers()
         return false;
     });
     m_player->onStateChanged([this](MDK_NS_PREPEND(PlaybackState) pbs) {
-        Q_EMIT playbackStateChanged();
+        notifyChanged(PropertyChange::PlaybackState);
         if (pbs == MDK_NS_PREPEND(PlaybackState)::Playing) {
-            Q_EMIT playing();
+            QMetaObject::invokeMethod(this, "playing", Qt::QueuedConnection);
             if (!m_livePreview) {
                 qCDebug(lcQMPMDK) << "Playing.";
             }
         }
         if (pbs == MDK_NS_PREPEND(PlaybackState)::Paused) {
-            Q_EMIT paused();
+            QMetaObject::invokeMethod(this, "paused", Qt::QueuedConnection);
             if (!m_livePreview) {
                 qCDebug(lcQMPMDK) << "Paused.";
             }
         }
         if (pbs == MDK_NS_PREPEND(PlaybackState)::Stopped) {
             const QUrl url = source();
-            const qint64 pos = m_lastPosition;
+            {
+                QMutexLocker locker(&m_nextMediaMutex);
+                m_nextMediaPath.clear();
+            }
             m_player->setMedia(nullptr);
-            m_player->setNextMedia(nullptr);
-            m_loaded = false;
-            Q_EMIT stopped();
-            Q_EMIT stoppedWithPosition(url, pos);
-            Q_EMIT sourceChanged();
-            resetInternalData();
+            m_player->setNextMedia(nullptr, -1);
+            QMetaObject::invokeMethod(this, [this, url](){
+                const qint64 pos = m_lastPosition;
+                m_loaded = false;
+                notifyChanged(PropertyChange::Source);
+                resetInternalData();
+                Q_EMIT stopped();
+                Q_EMIT stoppedWithPosition(url, pos);
+            }, Qt::QueuedConnection);
             if (!m_livePreview) {
                 qCDebug(lcQMPMDK) << "Stopped.";
             }
@@ -1129,12 +1681,12 @@ bool MDKPlayer::isLoaded() const
 
 bool MDKPlayer::isPlaying() const
 {
-    return (m_player->state() == MDK_NS_PREPEND(PlaybackState)::Playing);
+    return (m_reverseTimer.isActive() || (m_player->state() == MDK_NS_PREPEND(PlaybackState)::Playing));
 }
 
 bool MDKPlayer::isPaused() const
 {
-    return (m_player->state() == MDK_NS_PREPEND(PlaybackState)::Paused);
+    return (!m_reverseTimer.isActive() && (m_player->state() == MDK_NS_PREPEND(PlaybackState)::Paused));
 }
 
 bool MDKPlayer::isStopped() const
@@ -1142,21 +1694,296 @@ bool MDKPlayer::isStopped() const
     return (m_player->state() == MDK_NS_PREPEND(PlaybackState)::Stopped);
 }
 
+void MDKPlayer::installSoftwareFrameSink()
+{
+    // Called on the render thread. The callback itself runs on MDK's video thread,
+    // the converted frame is picked up by the texture node in the next sync.
+    m_player->onFrame<MDK_NS_PREPEND(VideoFrame)>([this](MDK_NS_PREPEND(VideoFrame) &frame, int track){
+        Q_UNUSED(track);
+        if (!frame) {
+            return 0;
+        }
+        QImage image = convertSoftwareFrame(frame);
+        if (image.isNull()) {
+            return 0;
+        }
+        {
+            QMutexLocker locker(&m_softwareFrameMutex);
+            m_softwareFrame.swap(image);
+            m_softwareFrameChanged = true;
+        }
+        // "image" is the previous frame now, the renderer may still be using it.
+        m_softwareFramePool.recycle(std::move(image));
+        QMetaObject::invokeMethod(this, "update");
+        return 0;
+    });
+    qCDebug(lcQMPMDK) << "Software frame sink installed, YUV conversion kernel:"
+                      << YUVConverter::kernelName(YUVConverter::bestKernel());
+}
+
+QImage MDKPlayer::takeSoftwareFrame()
+{
+    QMutexLocker locker(&m_softwareFrameMutex);
+    if (!m_softwareFrameChanged) {
+        return {};
+    }
+    m_softwareFrameChanged = false;
+    return m_softwareFrame;
+}
+
+QImage MDKPlayer::convertSoftwareFrame(MDK_NS_PREPEND(VideoFrame) &frame)
+{
+    const QSize size = {frame.width(), frame.height()};
+    if (size.isEmpty()) {
+        return {};
+    }
+    YUVConverter::Frame source = {};
+    source.format = toYUVConverterPixelFormat(frame.format());
+    source.width = size.width();
+    source.height = size.height();
+    {
+        QMutexLocker locker(&m_softwareFrameMutex);
+        source.matrix = m_softwareFrameMatrix;
+        source.range = m_softwareFrameRange;
+        const bool convertible = ((source.format == YUVConverter::PixelFormat::P010) ? m_convert10BitFrames : m_convert8BitFrames);
+        if (!convertible) {
+            source.format = YUVConverter::PixelFormat::Unknown;
+        }
+    }
+    const int planeCount = (source.format == YUVConverter::PixelFormat::I420) ? 3 : 2;
+    bool hostMemory = (frame.planeCount() >= planeCount);
+    for (int plane = 0; hostMemory && (plane != planeCount); ++plane) {
+        source.planes[plane] = frame.bufferData(plane);
+        source.bytesPerLine[plane] = frame.bytesPerLine(plane);
+        hostMemory = (source.planes[plane] != nullptr);
+    }
+    if ((source.format != YUVConverter::PixelFormat::Unknown) && hostMemory) {
+        QImage image = m_softwareFramePool.acquire(size);
+        if (!YUVConverter::convert(source, &image)) {
+            return {};
+        }
+        return image;
+    }
+    // Everything else (RGB, 4:2:2, 4:4:4, frames not in host memory, etc) is converted by MDK itself.
+    const auto rgba = frame.to(MDK_NS_PREPEND(PixelFormat)::RGBA);
+    if (!rgba || !rgba.bufferData(0)) {
+        return {};
+    }
+    QImage image = m_softwareFramePool.acquire(size);
+    if (image.isNull()) {
+        return {};
+    }
+    const auto bytesPerLine = rgba.bytesPerLine(0);
+    for (int row = 0; row != size.height(); ++row) {
+        std::memcpy(image.scanLine(row), rgba.bufferData(0) + (qsizetype(row) * bytesPerLine), size.width() * 4);
+    }
+    return image;
+}
+
+void MDKPlayer::updateSoftwareFrameColors()
+{
+    const auto &videoStreams = m_player->mediaInfo().video;
+    if (videoStreams.empty()) {
+        return;
+    }
+    const auto &codec = videoStreams.front().codec;
+    const bool hdr = ((codec.color_space == MDK_NS_PREPEND(ColorSpaceBT2100_PQ))
+                      || (codec.color_space == MDK_NS_PREPEND(ColorSpaceBT2100_HLG)));
+    const bool tagged709 = (codec.color_space == MDK_NS_PREPEND(ColorSpaceBT709));
+    const QByteArray formatName = QByteArray(codec.format_name ? codec.format_name : "");
+    QMutexLocker locker(&m_softwareFrameMutex);
+    // Untagged streams get the same guess most players make: HD is BT.709.
+    m_softwareFrameMatrix = ((tagged709 || (codec.height >= 720)) ? YUVConverter::ColorMatrix::BT709 : YUVConverter::ColorMatrix::BT601);
+    // JPEG style full range shows up as its own FFmpeg pixel format.
+    m_softwareFrameRange = (formatName.startsWith("yuvj") ? YUVConverter::ColorRange::Full : YUVConverter::ColorRange::Limited);
+    // PQ and HLG need tone mapping, and untagged 10 bit media is most likely
+    // BT.2020, neither of which the converter does.
+    m_convert8BitFrames = !hdr;
+    m_convert10BitFrames = (!hdr && tagged709);
+    if (hdr) {
+        qCDebug(lcQMPMDK) << "HDR video, the software frames are converted by MDK.";
+    } else {
+        qCDebug(lcQMPMDK) << "Software frame colors -->"
+                          << ((m_softwareFrameMatrix == YUVConverter::ColorMatrix::BT709) ? "BT.709" : "BT.601")
+                          << ((m_softwareFrameRange == YUVConverter::ColorRange::Full) ? "full range" : "limited range");
+    }
+}
+
+qreal MDKPlayer::videoFrameRate() const
+{
+    if (!isLoaded()) {
+        return 0.0;
+    }
+    const auto &vs = m_player->mediaInfo().video;
+    return (vs.empty() ? 0.0 : vs.at(0).codec.frame_rate);
+}
+
+FrameBackCache *MDKPlayer::backCache()
+{
+    if (!m_backCache) {
+        m_backCache = new FrameBackCache([](){
+            return new MDKThumbnailDecoder;
+        }, this);
+        m_backCache->setMemoryLimit(frameCacheSize());
+        connect(m_backCache, &FrameBackCache::framesAdded, this, [this](){
+            if ((m_pendingReversePosition >= 0) && showCachedFrame(m_pendingReversePosition)) {
+                m_pendingReversePosition = -1;
+            }
+        }, Qt::QueuedConnection);
+        m_backCache->open(source());
+    }
+    m_backCache->setFrameSize(backCacheFrameSize());
+    return m_backCache;
+}
+
+QSize MDKPlayer::backCacheFrameSize() const
+{
+    const QSizeF frameSize = videoSize();
+    if (frameSize.isEmpty()) {
+        return {};
+    }
+    const auto win = window();
+    const QSizeF itemSize = QSizeF(width(), height()) * (win ? win->effectiveDevicePixelRatio() : 1.0);
+    if (itemSize.isEmpty()) {
+        return frameSize.toSize();
+    }
+    // Frames larger than they are displayed would only waste memory.
+    const auto mode = ((m_fillMode == FillMode::PreserveAspectCrop) ? Qt::KeepAspectRatioByExpanding : Qt::KeepAspectRatio);
+    return frameSize.scaled(itemSize, mode).boundedTo(frameSize).toSize();
+}
+
+void MDKPlayer::prefetchBackwards(const qint64 timestamp)
+{
+    const auto index = keyframeIndex();
+    if (!index) {
+        return;
+    }
+    const QVector<qint64> frames = index->gopFrames(timestamp);
+    if (frames.isEmpty()) {
+        return;
+    }
+    FrameBackCache * const cache = backCache();
+    // The latest request is decoded first: the GOP of the given frame, then the
+    // one before it, so that the next steps don't have to wait.
+    if (frames.constFirst() > 0) {
+        const qint64 previousKeyframe = index->keyframeBefore(frames.constFirst() - 1);
+        if (previousKeyframe >= 0) {
+            cache->request(index->gopFrames(previousKeyframe));
+        }
+    }
+    cache->request(frames);
+}
+
+bool MDKPlayer::showCachedFrame(const qint64 timestamp)
+{
+    if (!m_backCache) {
+        return false;
+    }
+    const QImage frame = m_backCache->frame(timestamp);
+    if (frame.isNull()) {
+        return false;
+    }
+    m_reverseFrame = frame;
+    m_reversePosition = timestamp;
+    Q_EMIT positionChanged();
+    update();
+    return true;
+}
+
+void MDKPlayer::leaveReverseMode()
+{
+    if (m_reversePosition < 0) {
+        return;
+    }
+    m_reverseFrame = {};
+    m_reversePosition = -1;
+    update();
+}
+
+void MDKPlayer::startReversePlayback()
+{
+    Q_ASSERT(m_reverseRate > 0.0);
+    if (!isLoaded() || (m_reverseRate <= 0.0)) {
+        return;
+    }
+    m_player->set(MDK_NS_PREPEND(PlaybackState)::Paused);
+    const qreal frameRate = videoFrameRate();
+    const qreal interval = (trickPlay() ? kTrickPlayInterval : (1000.0 / (((frameRate > 0.0) ? frameRate : 25.0) * m_reverseRate)));
+    const bool wasActive = m_reverseTimer.isActive();
+    m_reverseTimer.start(qMax(1, qRound(interval)));
+    prefetchBackwards(position());
+    if (!wasActive) {
+        Q_EMIT playbackStateChanged();
+        Q_EMIT playing();
+        if (!m_livePreview) {
+            qCDebug(lcQMPMDK) << "Playing backwards.";
+        }
+    }
+}
+
+void MDKPlayer::stopReversePlayback()
+{
+    if (!m_reverseTimer.isActive()) {
+        return;
+    }
+    m_reverseTimer.stop();
+    Q_EMIT playbackStateChanged();
+    Q_EMIT paused();
+}
+
+void MDKPlayer::stepReversePlayback()
+{
+    const auto index = keyframeIndex();
+    if (!index) {
+        stopReversePlayback();
+        return;
+    }
+    if (trickPlay()) {
+        // One key frame per tick, as far back as the playback rate asks for.
+        const qint64 current = position();
+        const qint64 distance = qMax(qint64(1), qRound64(m_reverseRate * kTrickPlayInterval));
+        const qint64 target = index->keyframeBefore(current - distance);
+        if ((target < 0) || (target >= current)) {
+            stopReversePlayback();
+            return;
+        }
+        seek(target, SeekMode::Exact);
+        return;
+    }
+    const int frame = index->timestampToFrame(position());
+    if (frame <= 0) {
+        // The beginning is reached.
+        stopReversePlayback();
+        return;
+    }
+    const qint64 target = index->frameToTimestamp(frame - 1);
+    // Keeps the GOP before the current one decoded ahead of time. If decoding is
+    // slower than the playback, the current frame simply stays a bit longer.
+    prefetchBackwards(target);
+    showCachedFrame(target);
+}
+
 void MDKPlayer::resetInternalData()
 {
     m_lastPosition = 0;
     m_activeVideoTrack = 0;
     m_activeAudioTrack = 0;
     m_activeSubtitleTrack = 0;
-    Q_EMIT positionChanged();
-    Q_EMIT durationChanged();
-    Q_EMIT seekableChanged();
-    Q_EMIT chaptersChanged();
-    Q_EMIT metaDataChanged();
-    Q_EMIT mediaTracksChanged();
-    Q_EMIT activeVideoTrackChanged();
-    Q_EMIT activeAudioTrackChanged();
-    Q_EMIT activeSubtitleTrackChanged();
+    notifyChanged(PropertyChange::Position | PropertyChange::Duration | PropertyChange::Seekable
+                  | PropertyChange::Chapters | PropertyChange::MetaData | PropertyChange::MediaTracks
+                  | PropertyChange::ActiveVideoTrack | PropertyChange::ActiveAudioTrack
+                  | PropertyChange::ActiveSubtitleTrack);
+}
+
+MDKStreamSwitcher::MDKStreamSwitcher(QQuickItem *parent) : StreamSwitcher(parent)
+{
+}
+
+MDKStreamSwitcher::~MDKStreamSwitcher() = default;
+
+MediaPlayer *MDKStreamSwitcher::createPlayer() const
+{
+    return new MDKPlayer;
 }
 
 QTMEDIAPLAYER_END_NAMESPACE
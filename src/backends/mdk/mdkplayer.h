@@ -26,17 +26,22 @@
 
 #include "mdkbackend_global.h"
 #include "../../common/playerinterface.h"
+#include "../../common/streamswitcher.h"
+#include "../../common/yuvconverter.h"
 #include "include/mdk/global.h"
 #include <QtCore/qurl.h>
 #include <QtCore/qtimer.h>
+#include <QtCore/qmutex.h>
 
 MDK_NS_BEGIN
 class Player;
+class VideoFrame;
 MDK_NS_END
 
 QTMEDIAPLAYER_BEGIN_NAMESPACE
 
 class MDKVideoTextureNode;
+class FrameBackCache;
 
 class MDKPlayer : public MediaPlayer
 {
@@ -139,7 +144,8 @@ public Q_SLOTS:
     void play() override;
     void pause() override;
     void stop() override;
-    void seek(const qint64 value) override;
+    void stepForward() override;
+    void stepBackward() override;
     void snapshot() override;
 
 public:
@@ -150,6 +156,23 @@ public:
 
 protected:
     Q_NODISCARD QSGNode *updatePaintNode(QSGNode *node, UpdatePaintNodeData *data) override;
+    void applyDisplaySync() override;
+    bool doSeek(const qint64 value, const bool exact) override;
+    bool doStep(const int frames) override;
+    void applyFrameCacheSize() override;
+    void applyTrickPlay() override;
+    void applyLoopRange() override;
+    void applyNextMedia() override;
+    void applyResourceLimits() override;
+    Q_NODISCARD qint64 queryMemoryUsage() const override;
+    Q_NODISCARD CacheState queryCacheState() override;
+    Q_NODISCARD DecoderBenchmarker *createDecoderBenchmarker() const override;
+    Q_NODISCARD FrameStatistics queryFrameStatistics() override;
+    void applyDecodeQuality() override;
+    void applyAudioOutput() override;
+    void applyPerformanceProfile() override;
+    void applyVideoDecoding() override;
+    void applySuspension() override;
 #if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
     void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) override;
 #else
@@ -157,7 +180,7 @@ protected:
 #endif
 
 private Q_SLOTS:
-    void invalidateSceneGraph();
+    void invalidateSceneGraph() override;
     void setRendererReady(const bool value);
 
 private:
@@ -166,6 +189,28 @@ private:
     void releaseResources() override;
     void initMdkHandlers();
     void resetInternalData();
+    void applyVideoDecoders();
+    void applyBufferRange();
+    void resyncDecoders();
+
+    // Used by the Software scene graph, MDK can't render anything itself in that case.
+    void installSoftwareFrameSink();
+    Q_NODISCARD QImage takeSoftwareFrame();
+    Q_NODISCARD QImage convertSoftwareFrame(MDK_NS_PREPEND(VideoFrame) &frame);
+    void updateSoftwareFrameColors();
+
+    Q_NODISCARD qreal videoFrameRate() const;
+
+    // MDK can neither step nor play backwards. Frames before the current one are
+    // decoded into a back cache by a second decoder and shown instead of MDK's output.
+    Q_NODISCARD FrameBackCache *backCache();
+    Q_NODISCARD QSize backCacheFrameSize() const;
+    void prefetchBackwards(const qint64 timestamp);
+    bool showCachedFrame(const qint64 timestamp);
+    void leaveReverseMode();
+    void startReversePlayback();
+    void stopReversePlayback();
+    void stepReversePlayback();
 
 private:
     MDKVideoTextureNode *m_node = nullptr;
@@ -186,6 +231,8 @@ private:
     QString m_snapshotTemplate = QStringLiteral("${filename}_${datetime}_${frametime}");
 
     FillMode m_fillMode = FillMode::PreserveAspectFit;
+    // Like the position, the tracks and "m_loaded", only touched on the GUI
+    // thread: MDK's callbacks queue their updates.
     MediaStatus m_mediaStatus = {};
 
     qint64 m_lastPosition = 0;
@@ -194,10 +241,56 @@ private:
     int m_activeAudioTrack = 0;
     int m_activeSubtitleTrack = 0;
 
+    // Counted by the texture node on the render thread.
+    std::atomic<qint64> m_presentedFrames{0};
+    std::atomic<qint64> m_droppedFrames{0};
+
+    QElapsedTimer m_cacheStateTimer;
+    qint64 m_lastBufferedBytes = -1;
+
     QUrl m_cachedUrl = {};
+    qint64 m_cachedStartPosition = 0;
     bool m_rendererReady = false;
 
+    QMutex m_softwareFrameMutex;
+    QImage m_softwareFrame = {};
+    bool m_softwareFrameChanged = false;
+    // How the YUV converter has to treat the frames of the current media, also
+    // guarded by "m_softwareFrameMutex". Frames it can't convert correctly are
+    // left to MDK.
+    YUVConverter::ColorMatrix m_softwareFrameMatrix = YUVConverter::ColorMatrix::BT601;
+    YUVConverter::ColorRange m_softwareFrameRange = YUVConverter::ColorRange::Limited;
+    bool m_convert8BitFrames = true;
+    bool m_convert10BitFrames = false;
+    YUVConverter::ImagePool m_softwareFramePool; // Only touched by MDK's video thread.
+
+    FrameBackCache *m_backCache = nullptr;
+    QImage m_reverseFrame = {}; // Rendered instead of MDK's output unless null.
+    qint64 m_reversePosition = -1; // Timestamp of "m_reverseFrame".
+    qint64 m_pendingReversePosition = -1; // Shown as soon as the back cache has it.
+    qreal m_reverseRate = 0.0; // Absolute value of a negative playback rate.
+    QTimer m_reverseTimer;
+
+    QMutex m_nextMediaMutex;
+    QString m_nextMediaPath = {}; // Preloaded by MDK, compared on MDK's threads.
+
     bool m_loaded = false;
 };
 
+class MDKStreamSwitcher final : public StreamSwitcher
+{
+    Q_OBJECT
+#ifdef QML_NAMED_ELEMENT
+    QML_NAMED_ELEMENT(StreamSwitcher)
+#endif
+    Q_DISABLE_COPY_MOVE(MDKStreamSwitcher)
+
+public:
+    explicit MDKStreamSwitcher(QQuickItem *parent = nullptr);
+    ~MDKStreamSwitcher() override;
+
+protected:
+    Q_NODISCARD MediaPlayer *createPlayer() const override;
+};
+
 QTMEDIAPLAYER_END_NAMESPACE
@@ -0,0 +1,192 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "mdkthumbnaildecoder.h"
+#include "mdkqthelper.h"
+#include "include/mdk/Player.h"
+#include <QtCore/qdebug.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qdeadlinetimer.h>
+#include <utility>
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+// Network sources may take a while, but a stuck worker must not block the GUI forever.
+static constexpr const int kOpenTimeout = 10000;
+static constexpr const int kFrameTimeout = 5000;
+
+MDKThumbnailDecoder::MDKThumbnailDecoder() = default;
+
+MDKThumbnailDecoder::~MDKThumbnailDecoder()
+{
+    if (!m_player) {
+        return;
+    }
+    // The frame callback captures "this", it must not outlive us.
+    m_player->onFrame<MDK_NS_PREPEND(VideoFrame)>(nullptr);
+    m_player->setMedia(nullptr);
+    m_player->set(MDK_NS_PREPEND(PlaybackState)::Stopped);
+    m_player->waitFor(MDK_NS_PREPEND(PlaybackState)::Stopped);
+}
+
+qint64 MDKThumbnailDecoder::open(const QUrl &url)
+{
+    Q_ASSERT(url.isValid());
+    if (!url.isValid()) {
+        return -1;
+    }
+    if (!MDK::Qt::isMDKAvailable()) {
+        qCWarning(lcQMPMDK) << "MDK is not available.";
+        return -1;
+    }
+    m_player.reset(new MDK_NS_PREPEND(Player));
+    m_player->setMute(true);
+    m_player->setDecoders(MDK_NS_PREPEND(MediaType)::Video, {"FFmpeg"});
+    m_player->onFrame<MDK_NS_PREPEND(VideoFrame)>([this](MDK_NS_PREPEND(VideoFrame) &frame, int track){
+        Q_UNUSED(track);
+        return captureFrame(frame);
+    });
+    const QString path = (url.isLocalFile() ? QDir::toNativeSeparators(url.toLocalFile()) : url.toString());
+    m_player->setMedia(qUtf8Printable(path));
+    // Only the video track is needed.
+    m_player->setActiveTracks(MDK_NS_PREPEND(MediaType)::Audio, {});
+    m_player->setActiveTracks(MDK_NS_PREPEND(MediaType)::Subtitle, {});
+    m_player->prepare(0, [this](int64_t position, bool *boost){
+        Q_UNUSED(boost);
+        QMutexLocker locker(&m_mutex);
+        m_prepared = (position >= 0);
+        m_condition.wakeAll();
+        return true;
+    });
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_prepared) {
+            m_condition.wait(&m_mutex, kOpenTimeout);
+        }
+        if (!m_prepared) {
+            qCWarning(lcQMPMDK) << "Failed to open" << path << "for thumbnails.";
+            return -1;
+        }
+    }
+    return m_player->mediaInfo().duration;
+}
+
+QImage MDKThumbnailDecoder::decode(const qint64 position, const bool accurate, const QSize &size, qint64 *timestamp)
+{
+    auto flags = MDK_NS_PREPEND(SeekFlag)::FromStart;
+    if (!accurate) {
+        flags |= MDK_NS_PREPEND(SeekFlag)::KeyFrame;
+    }
+    const QImage image = waitForFrame(size, timestamp, [this, position, flags](){
+        m_player->seek(position, flags);
+    });
+    if (image.isNull()) {
+        qCDebug(lcQMPMDK) << "Timed out while seeking to" << position << "for a thumbnail.";
+    }
+    return image;
+}
+
+QImage MDKThumbnailDecoder::decodeNext(const QSize &size, qint64 *timestamp)
+{
+    // Stepping forward by one frame is the only kind of frame seek MDK supports.
+    return waitForFrame(size, timestamp, [this](){
+        m_player->seek(1, MDK_NS_PREPEND(SeekFlag)::Frame | MDK_NS_PREPEND(SeekFlag)::FromNow);
+    });
+}
+
+QImage MDKThumbnailDecoder::waitForFrame(const QSize &size, qint64 *timestamp, const std::function<void()> &trigger)
+{
+    Q_ASSERT(m_player);
+    Q_ASSERT(!size.isEmpty());
+    Q_ASSERT(trigger);
+    if (timestamp) {
+        *timestamp = -1;
+    }
+    if (!m_player || size.isEmpty() || !trigger) {
+        return {};
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        m_frame = {};
+        m_frameTimestamp = -1;
+        m_frameSize = size;
+        m_waitingForFrame = true;
+    }
+    trigger();
+    QMutexLocker locker(&m_mutex);
+    const QDeadlineTimer deadline(kFrameTimeout);
+    while (m_waitingForFrame) {
+        if (!m_condition.wait(&m_mutex, deadline)) {
+            m_waitingForFrame = false;
+            break;
+        }
+    }
+    if (timestamp && !m_frame.isNull()) {
+        *timestamp = m_frameTimestamp;
+    }
+    return std::exchange(m_frame, {});
+}
+
+// Called on the decoder thread of MDK.
+int MDKThumbnailDecoder::captureFrame(MDK_NS_PREPEND(VideoFrame) &frame)
+{
+    if (!frame.isValid()) {
+        return 0;
+    }
+    QMutexLocker locker(&m_mutex);
+    if (!m_waitingForFrame) {
+        return 0;
+    }
+    const QSize fittedSize = QSize(frame.width(), frame.height()).scaled(m_frameSize, Qt::KeepAspectRatio);
+    if (fittedSize.isEmpty()) {
+        return 0;
+    }
+    // Let MDK do the color conversion and the scaling in one go.
+    auto rgba = frame.to(MDK_NS_PREPEND(PixelFormat)::RGBA, fittedSize.width(), fittedSize.height());
+    if (!rgba.isValid()) {
+        return 0;
+    }
+    // The frame buffer belongs to MDK, take a deep copy.
+    m_frame = QImage(rgba.bufferData(0), rgba.width(), rgba.height(), rgba.bytesPerLine(0),
+                     QImage::Format_RGBA8888).copy();
+    // In seconds, negative if unknown.
+    const double frameTimestamp = frame.timestamp();
+    m_frameTimestamp = ((frameTimestamp >= 0.0) ? qRound64(frameTimestamp * 1000.0) : -1);
+    m_waitingForFrame = false;
+    m_condition.wakeAll();
+    return 0;
+}
+
+MDKThumbnailIndex::MDKThumbnailIndex(QQuickItem *parent) : ThumbnailIndex(parent)
+{
+}
+
+MDKThumbnailIndex::~MDKThumbnailIndex() = default;
+
+ThumbnailDecoder *MDKThumbnailIndex::createDecoder() const
+{
+    return new MDKThumbnailDecoder;
+}
+
+QTMEDIAPLAYER_END_NAMESPACE
@@ -0,0 +1,88 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "mdkbackend_global.h"
+#include "../../common/thumbnailindex.h"
+#include "include/mdk/global.h"
+#include <QtCore/qmutex.h>
+#include <QtCore/qwaitcondition.h>
+#include <QtCore/qscopedpointer.h>
+#include <functional>
+
+MDK_NS_BEGIN
+class Player;
+class VideoFrame;
+MDK_NS_END
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+// A second, muted MDK player which never renders, the decoded frames are
+// captured from its frame callback instead.
+class MDKThumbnailDecoder final : public ThumbnailDecoder
+{
+    Q_DISABLE_COPY_MOVE(MDKThumbnailDecoder)
+
+public:
+    explicit MDKThumbnailDecoder();
+    ~MDKThumbnailDecoder() override;
+
+    Q_NODISCARD qint64 open(const QUrl &url) override;
+    Q_NODISCARD QImage decode(const qint64 position, const bool accurate, const QSize &size,
+                              qint64 *timestamp = nullptr) override;
+    Q_NODISCARD QImage decodeNext(const QSize &size, qint64 *timestamp = nullptr) override;
+
+private:
+    int captureFrame(MDK_NS_PREPEND(VideoFrame) &frame);
+    Q_NODISCARD QImage waitForFrame(const QSize &size, qint64 *timestamp, const std::function<void()> &trigger);
+
+private:
+    QScopedPointer<MDK_NS_PREPEND(Player)> m_player;
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+    bool m_prepared = false;
+    bool m_waitingForFrame = false;
+    QSize m_frameSize = {};
+    QImage m_frame = {};
+    qint64 m_frameTimestamp = -1;
+};
+
+class MDKThumbnailIndex final : public ThumbnailIndex
+{
+    Q_OBJECT
+#ifdef QML_NAMED_ELEMENT
+    QML_NAMED_ELEMENT(ThumbnailIndex)
+#endif
+    Q_DISABLE_COPY_MOVE(MDKThumbnailIndex)
+
+public:
+    explicit MDKThumbnailIndex(QQuickItem *parent = nullptr);
+    ~MDKThumbnailIndex() override;
+
+protected:
+    Q_NODISCARD ThumbnailDecoder *createDecoder() const override;
+};
+
+QTMEDIAPLAYER_END_NAMESPACE
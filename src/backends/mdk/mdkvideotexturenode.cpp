@@ -30,6 +30,9 @@
 
 QTMEDIAPLAYER_BEGIN_NAMESPACE
 
+// Larger gaps between two rendered frames (in seconds) come from seeks, not drops.
+static constexpr const qreal kMaximumFrameGap = 1.0;
+
 MDKVideoTextureNode::MDKVideoTextureNode(QQuickItem *item) : VideoTextureNode(item)
 {
     Q_ASSERT(item);
@@ -39,6 +42,8 @@ MDKVideoTextureNode::MDKVideoTextureNode(QQuickItem *item) : VideoTextureNode(it
     m_item = static_cast<MDKPlayer *>(item);
     m_window = m_item->window();
     m_player = m_item->m_player;
+    // MDK can't render with the Software scene graph, the frames are converted on the CPU instead.
+    m_software = (m_window->rendererInterface()->graphicsApi() == QSGRendererInterface::Software);
     connect(m_window, &QQuickWindow::beforeRendering, this, &MDKVideoTextureNode::render);
     connect(m_window, &QQuickWindow::screenChanged, this, [this](QScreen *screen){
         Q_UNUSED(screen);
@@ -52,13 +57,18 @@ MDKVideoTextureNode::~MDKVideoTextureNode()
     if (tex) {
         delete tex;
     }
-    // When device lost occurs
-    const auto player = m_player.lock();
-    if (!player) {
-        return;
+    // Don't waste time converting frames nobody will see. The item may be gone
+    // already, so only the player is touched here.
+    if (m_softwareFrameSinkInstalled) {
+        const auto player = m_player.lock();
+        if (player) {
+            player->onFrame<MDK_NS_PREPEND(VideoFrame)>(nullptr);
+        }
     }
-    player->setVideoSurfaceSize(-1, -1, m_window);
-    qCDebug(lcQMPMDK) << "Renderer destroyed.";
+    // Don't release MDK's renderer here: the node is re-created every time the item
+    // is shown again, but the renderer (and all its compiled shaders) stays valid
+    // as long as the graphics resources of the window are alive. It's released
+    // by the player when the scene graph is invalidated instead.
 }
 
 void MDKVideoTextureNode::sync()
@@ -68,6 +78,21 @@ void MDKVideoTextureNode::sync()
     if (!m_item || !m_window) {
         return;
     }
+    m_renderingEnabled = m_item->renderingEnabled();
+    m_frameRate = m_item->videoFrameRate();
+
+    if (!m_item->m_reverseFrame.isNull()) {
+        syncReverseFrame(m_item->m_reverseFrame);
+        return;
+    }
+    if (m_showingReverseFrame) {
+        leaveReverseFrame();
+    }
+
+    if (m_software) {
+        syncSoftwareFrame();
+        return;
+    }
 
     // effectiveDevicePixelRatio() will always give the correct result even if QQuickWindow is not available.
     const auto dpr = m_window->effectiveDevicePixelRatio();
@@ -105,11 +130,121 @@ void MDKVideoTextureNode::sync()
 // beforeRenderPassRecording() instead.
 void MDKVideoTextureNode::render()
 {
+    // Without video decoding, while suspended or on standby, the texture just keeps the last frame.
+    if (m_software || m_showingReverseFrame || !m_renderingEnabled) {
+        return;
+    }
     const auto player = m_player.lock();
     if (!player) {
         return;
     }
-    player->renderVideo(m_window);
+    const qreal timestamp = player->renderVideo(m_window);
+    if (timestamp < 0.0) {
+        return;
+    }
+    m_item->reportFirstFrame();
+    if (timestamp == m_lastFrameTimestamp) {
+        return;
+    }
+    // MDK drops late frames silently, they only show up as gaps between the
+    // timestamps of the frames that made it. Seeks and loops are no drops.
+    const qreal gap = (timestamp - m_lastFrameTimestamp);
+    m_lastFrameTimestamp = timestamp;
+    ++m_item->m_presentedFrames;
+    if ((m_frameRate > 0.0) && (gap > 0.0) && (gap <= kMaximumFrameGap)) {
+        const qint64 dropped = (qRound64(gap * m_frameRate) - 1);
+        if (dropped > 0) {
+            m_item->m_droppedFrames += dropped;
+        }
+    }
+}
+
+void MDKVideoTextureNode::syncSoftwareFrame()
+{
+    if (!m_softwareFrameSinkInstalled) {
+        m_item->installSoftwareFrameSink();
+        m_softwareFrameSinkInstalled = true;
+        QMetaObject::invokeMethod(m_item, "setRendererReady", Q_ARG(bool, true));
+    }
+    const QImage frame = m_item->takeSoftwareFrame();
+    if (!frame.isNull()) {
+        const auto tex = m_window->createTextureFromImage(frame);
+        if (tex) {
+            delete texture();
+            setTexture(tex);
+            setFiltering(QSGTexture::Linear);
+            m_softwareFrameSize = frame.size();
+            m_item->reportFirstFrame();
+        }
+    }
+    if (!texture()) {
+        return;
+    }
+    // Nobody scales the frame for us in this mode, apply the fill mode here.
+    applyFillMode(m_softwareFrameSize);
+}
+
+void MDKVideoTextureNode::syncReverseFrame(const QImage &frame)
+{
+    Q_ASSERT(!frame.isNull());
+    if (frame.isNull()) {
+        return;
+    }
+    // The scene graph syncs far more often than the frame changes.
+    if (m_showingReverseFrame && (frame.cacheKey() == m_reverseFrameKey)) {
+        applyFillMode(m_softwareFrameSize);
+        return;
+    }
+    const auto tex = m_window->createTextureFromImage(frame);
+    if (!tex) {
+        return;
+    }
+    delete texture();
+    setTexture(tex);
+    // Unlike MDK's render target, an image is never upside down.
+    setTextureCoordinatesTransform(TextureCoordinatesTransformFlag::NoTransform);
+    setFiltering(QSGTexture::Linear);
+    m_softwareFrameSize = frame.size();
+    m_reverseFrameKey = frame.cacheKey();
+    m_showingReverseFrame = true;
+    applyFillMode(m_softwareFrameSize);
+}
+
+void MDKVideoTextureNode::leaveReverseFrame()
+{
+    m_showingReverseFrame = false;
+    if (m_software) {
+        // The next frame from the software sink replaces it.
+        return;
+    }
+    // MDK renders into its own texture, the next sync creates it again.
+    setSourceRect(QRectF());
+    m_size = {};
+}
+
+void MDKVideoTextureNode::applyFillMode(const QSizeF &frameSize)
+{
+    const QSizeF itemSize = {m_item->width(), m_item->height()};
+    switch (m_item->fillMode()) {
+    case FillMode::PreserveAspectFit: {
+        const QSizeF fittedSize = frameSize.scaled(itemSize, Qt::KeepAspectRatio);
+        const QPointF topLeft = {(itemSize.width() - fittedSize.width()) / 2.0,
+                                 (itemSize.height() - fittedSize.height()) / 2.0};
+        setRect(QRectF(topLeft, fittedSize));
+        setSourceRect(QRectF(QPointF(0, 0), frameSize));
+    } break;
+    case FillMode::PreserveAspectCrop: {
+        const QSizeF visibleSize = itemSize.scaled(frameSize, Qt::KeepAspectRatio);
+        const QPointF topLeft = {(frameSize.width() - visibleSize.width()) / 2.0,
+                                 (frameSize.height() - visibleSize.height()) / 2.0};
+        setRect(QRectF(QPointF(0, 0), itemSize));
+        setSourceRect(QRectF(topLeft, visibleSize));
+    } break;
+    case FillMode::Stretch:
+        setRect(QRectF(QPointF(0, 0), itemSize));
+        setSourceRect(QRectF(QPointF(0, 0), frameSize));
+        break;
+    }
 }
 
 QTMEDIAPLAYER_END_NAMESPACE
@@ -34,6 +34,7 @@ class Player;
 
 QT_BEGIN_NAMESPACE
 QT_FORWARD_DECLARE_CLASS(QQuickWindow)
+QT_FORWARD_DECLARE_CLASS(QImage)
 QT_END_NAMESPACE
 
 QTMEDIAPLAYER_BEGIN_NAMESPACE
@@ -54,6 +55,13 @@ public:
 protected Q_SLOTS:
     void render() override;
 
+private:
+    void syncSoftwareFrame();
+    // Frames from the back cache (see "MDKPlayer::m_reverseFrame") replace MDK's output.
+    void syncReverseFrame(const QImage &frame);
+    void leaveReverseFrame();
+    void applyFillMode(const QSizeF &frameSize);
+
 protected:
     TextureCoordinatesTransformMode m_transformMode = TextureCoordinatesTransformFlag::NoTransform;
     QQuickWindow *m_window = nullptr;
@@ -62,6 +70,14 @@ protected:
 
 private:
     QWeakPointer<mdk::Player> m_player;
+    bool m_software = false;
+    bool m_softwareFrameSinkInstalled = false;
+    QSize m_softwareFrameSize = {};
+    bool m_showingReverseFrame = false;
+    bool m_renderingEnabled = true; // Copied from the item while syncing.
+    qreal m_frameRate = 0.0; // Copied from the item while syncing.
+    qreal m_lastFrameTimestamp = -1.0; // In seconds.
+    qint64 m_reverseFrameKey = 0;
 };
 
 QTMEDIAPLAYER_END_NAMESPACE
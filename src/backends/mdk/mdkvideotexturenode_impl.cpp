@@ -300,10 +300,9 @@ QSGTexture *MDKVideoTextureNodeImpl::ensureTexture(void *player, const QSize &si
     } break;
 #endif // (QT_VERSION >= QT_VERSION_CHECK(5, 14, 0))
     case QSGRendererInterface::Software:
-    {
-        // TODO: implement this.
-        qFatal("TO BE IMPLEMENTED: Software backend of MDK.");
-    } break;
+        // Never gets here: with the Software scene graph the frames are converted
+        // on the CPU and uploaded by MDKVideoTextureNode::syncSoftwareFrame().
+        break;
     default:
         qFatal("Unsupported backend of MDK: %d", static_cast<int>(rif->graphicsApi()));
         break;
@@ -29,8 +29,10 @@
 #include <QtCore/qscopeguard.h>
 #include <QtQuick/qquickwindow.h>
 #include "../../common/backendinterface.h"
+#include "../../common/resourcegovernor.h"
 #include "mpvplayer.h"
 #include "mpvqthelper.h"
+#include "mpvthumbnaildecoder.h"
 
 // Q_INIT_RESOURCE() can't be used inside namespace, we have to
 // wrap it into a function outside of the namespace and use the
@@ -216,6 +218,9 @@ public:
 #endif
         qRegisterMetaType<MPV::Qt::ErrorReturn>();
         QTMEDIAPLAYER_REGISTER_CUSTOM_TYPES(MPVPlayer)
+        QTMEDIAPLAYER_QML_NAMED_REGISTER(QTMEDIAPLAYER_PREPEND_NAMESPACE(MPVThumbnailIndex), ThumbnailIndex);
+        QTMEDIAPLAYER_QML_NAMED_REGISTER(QTMEDIAPLAYER_PREPEND_NAMESPACE(MPVStreamSwitcher), StreamSwitcher);
+        QTMEDIAPLAYER_QML_SINGLETON_REGISTER(QTMEDIAPLAYER_PREPEND_NAMESPACE(ResourceGovernor), ResourceGovernor);
         return true;
     }
 
@@ -0,0 +1,196 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "mpvdecoderbenchmarker.h"
+#include "mpvqthelper.h"
+#include <QtCore/qdebug.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qelapsedtimer.h>
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+// Network sources may take a while, but a stuck worker must not block forever.
+static constexpr const int kOpenTimeout = 10000;
+static constexpr const int kDecodeTimeout = 30000;
+
+// libavcodec wraps hardware decoders as codec specific decoders as well, the
+// calibration is about the software ones only.
+static const QStringList kHardwareDecoderSuffixes = {
+    QStringLiteral("_cuvid"), QStringLiteral("_qsv"), QStringLiteral("_mediacodec"),
+    QStringLiteral("_v4l2m2m"), QStringLiteral("_mmal"), QStringLiteral("_rkmpp"),
+    QStringLiteral("_amf"), QStringLiteral("_crystalhd"), QStringLiteral("_omx")
+};
+
+[[nodiscard]] static inline bool isHardwareDecoder(const QString &driver)
+{
+    for (auto &&suffix : qAsConst(kHardwareDecoderSuffixes)) {
+        if (driver.endsWith(suffix)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+MPVDecoderBenchmarker::MPVDecoderBenchmarker() = default;
+
+MPVDecoderBenchmarker::~MPVDecoderBenchmarker() = default;
+
+mpv_handle *MPVDecoderBenchmarker::createInstance(const QList<std::pair<QString, QString>> &options)
+{
+    if (!MPV::Qt::isLibmpvAvailable()) {
+        qCWarning(lcQMPMPV) << "libmpv is not available.";
+        return nullptr;
+    }
+    mpv_handle * const mpv = mpv_create();
+    if (!mpv) {
+        qCWarning(lcQMPMPV) << "Failed to create the mpv instance for the decoder calibration.";
+        return nullptr;
+    }
+    // Nothing but the video decoder does any work.
+    static const std::pair<const char *, const char *> defaultOptions[] = {
+        {"vo", "null"},
+        {"ao", "null"},
+        {"aid", "no"},
+        {"sid", "no"},
+        {"hwdec", "no"},
+        {"untimed", "yes"},
+        // Every decoded frame has to reach the VO, or it's not counted.
+        {"framedrop", "no"},
+        {"load-scripts", "no"},
+        {"ytdl", "no"},
+        {"osc", "no"},
+        {"terminal", "no"}
+    };
+    for (auto &&option : defaultOptions) {
+        if (mpv_set_option_string(mpv, option.first, option.second) < 0) {
+            qCWarning(lcQMPMPV) << "Failed to set" << option.first << "to" << option.second;
+        }
+    }
+    for (auto &&option : qAsConst(options)) {
+        if (mpv_set_option_string(mpv, qUtf8Printable(option.first), qUtf8Printable(option.second)) < 0) {
+            qCWarning(lcQMPMPV) << "Failed to set" << option.first << "to" << option.second;
+        }
+    }
+    if (mpv_initialize(mpv) < 0) {
+        qCWarning(lcQMPMPV) << "Failed to initialize the mpv instance for the decoder calibration.";
+        mpv_terminate_destroy(mpv);
+        return nullptr;
+    }
+    return mpv;
+}
+
+QList<DecoderConfig> MPVDecoderBenchmarker::candidates(const QString &codec)
+{
+    Q_ASSERT(!codec.isEmpty());
+    if (codec.isEmpty()) {
+        return {};
+    }
+    mpv_handle * const mpv = createInstance({});
+    if (!mpv) {
+        return {};
+    }
+    const QVariantList decoders = MPV::Qt::get_property(mpv, QStringLiteral("decoder-list")).toList();
+    mpv_terminate_destroy(mpv);
+    // The native decoder of libavcodec has the name of the codec, it's tried with
+    // both kinds of threading. The external ones only with their default.
+    QList<DecoderConfig> result = {};
+    for (auto &&decoder : qAsConst(decoders)) {
+        const QVariantMap map = decoder.toMap();
+        const QString driver = map.value(QStringLiteral("driver")).toString();
+        if ((map.value(QStringLiteral("codec")).toString() != codec) || driver.isEmpty() || isHardwareDecoder(driver)) {
+            continue;
+        }
+        DecoderConfig config = {};
+        config.decoder = driver;
+        if (driver == codec) {
+            result.prepend(config);
+            config.sliceThreads = true;
+            result.insert(1, config);
+        } else {
+            result.append(config);
+        }
+    }
+    return result;
+}
+
+int MPVDecoderBenchmarker::decode(const QUrl &url, const DecoderConfig &config, const int frameCount)
+{
+    Q_ASSERT(url.isValid());
+    Q_ASSERT(!config.decoder.isEmpty());
+    Q_ASSERT(frameCount > 0);
+    if (!url.isValid() || config.decoder.isEmpty() || (frameCount <= 0)) {
+        return 0;
+    }
+    // mpv ends the playback by itself once the VO got "frames" frames, so the
+    // count is exact and nothing needs to be polled in the meantime.
+    mpv_handle * const mpv = createInstance({
+        {QStringLiteral("vd"), QStringLiteral("lavc:") + config.decoder},
+        {QStringLiteral("vd-lavc-o"), (config.sliceThreads ? QStringLiteral("thread_type=slice") : QStringLiteral("thread_type=frame"))},
+        {QStringLiteral("frames"), QString::number(frameCount)}
+    });
+    if (!mpv) {
+        return 0;
+    }
+    const QString path = (url.isLocalFile() ? QDir::toNativeSeparators(url.toLocalFile()) : url.toString());
+    int frames = 0;
+    if (!MPV::Qt::is_error(MPV::Qt::command(mpv, QStringList{QStringLiteral("loadfile"), path}))) {
+        bool loaded = false;
+        QElapsedTimer timer;
+        timer.start();
+        while (!timer.hasExpired(loaded ? kDecodeTimeout : kOpenTimeout)) {
+            const int timeout = ((loaded ? kDecodeTimeout : kOpenTimeout) - int(timer.elapsed()));
+            const mpv_event * const event = mpv_wait_event(mpv, qreal(qMax(0, timeout)) / 1000.0);
+            if (!event || (event->event_id == MPV_EVENT_NONE)) {
+                continue;
+            }
+            if (event->event_id == MPV_EVENT_FILE_LOADED) {
+                // mpv silently falls back to another decoder if this one fails.
+                const QString description = MPV::Qt::get_property(mpv, QStringLiteral("current-tracks/video/decoder-desc")).toString();
+                if (!description.isEmpty() && !description.startsWith(config.decoder)) {
+                    break;
+                }
+                // A media shorter than the limit would end early, with an unknown number of frames.
+                const int frameTotal = MPV::Qt::get_property(mpv, QStringLiteral("estimated-frame-count")).toInt();
+                if ((frameTotal > 0) && (frameTotal < frameCount)) {
+                    qCDebug(lcQMPMPV) << path << "is too short for the decoder calibration.";
+                    break;
+                }
+                loaded = true;
+                timer.restart();
+                continue;
+            }
+            if (event->event_id == MPV_EVENT_END_FILE) {
+                const auto endFile = static_cast<const mpv_event_end_file *>(event->data);
+                if (loaded && endFile && (endFile->reason == MPV_END_FILE_REASON_EOF)) {
+                    frames = frameCount;
+                }
+                break;
+            }
+        }
+    }
+    mpv_terminate_destroy(mpv);
+    return frames;
+}
+
+QTMEDIAPLAYER_END_NAMESPACE
@@ -0,0 +1,52 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "mpvbackend_global.h"
+#include "../../common/decodercalibration.h"
+#include <utility>
+
+struct mpv_handle;
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+// Decodes untimed into a headless mpv instance, with one of the software
+// decoders of libavcodec.
+class MPVDecoderBenchmarker final : public DecoderBenchmarker
+{
+    Q_DISABLE_COPY_MOVE(MPVDecoderBenchmarker)
+
+public:
+    explicit MPVDecoderBenchmarker();
+    ~MPVDecoderBenchmarker() override;
+
+    Q_NODISCARD QList<DecoderConfig> candidates(const QString &codec) override;
+    Q_NODISCARD int decode(const QUrl &url, const DecoderConfig &config, const int frameCount) override;
+
+private:
+    Q_NODISCARD static mpv_handle *createInstance(const QList<std::pair<QString, QString>> &options);
+};
+
+QTMEDIAPLAYER_END_NAMESPACE
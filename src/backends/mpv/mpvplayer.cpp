@@ -26,11 +26,15 @@
 #include "mpvbackend.h"
 #include "mpvqthelper.h"
 #include "mpvvideotexturenode.h"
+#include "mpvdecoderbenchmarker.h"
 #include "../../common/backendinterface.h"
+#include "../../common/mediacache.h"
 #include "include/mpv/render.h"
 #include <clocale>
+#include <utility>
 #include <QtCore/qdebug.h>
 #include <QtCore/qdir.h>
+#include <QtCore/qmetaobject.h>
 #include <QtQuick/qquickwindow.h>
 
 QTMEDIAPLAYER_BEGIN_NAMESPACE
@@ -91,16 +95,10 @@ void MPVPlayer::initialize()
     if (!mpvSetProperty(QStringLiteral("vo"), QStringLiteral("libmpv"))) {
         qCWarning(lcQMPMPV) << "Failed to set \"vo\" to \"libmpv\".";
     }
-    if (!mpvSetProperty(QStringLiteral("ytdl"), true)) {
-        qCWarning(lcQMPMPV) << "Failed to set \"ytdl\" to \"true\".";
-    }
     static const QString clientName = QStringLiteral("QtMediaPlayer");
     if (!mpvSetProperty(QStringLiteral("audio-client-name"), clientName)) {
         qCWarning(lcQMPMPV) << "Failed to set \"audio-client-name\" to" << clientName;
     }
-    if (!mpvSetProperty(QStringLiteral("load-scripts"), true)) {
-        qCWarning(lcQMPMPV) << "Failed to set \"load-scripts\" to \"true\".";
-    }
     if (!mpvSetProperty(QStringLiteral("screenshot-format"), QStringLiteral("png"))) {
         qCWarning(lcQMPMPV) << "Failed to set \"screenshot-format\" to \"png\".";
     }
@@ -112,16 +110,36 @@ void MPVPlayer::initialize()
     if (!mpvSetProperty(QStringLiteral("hwdec"), QStringLiteral("no"))) {
         qCWarning(lcQMPMPV) << "Failed to set \"hwdec\" to \"no\".";
     }
-
-    auto it = properties.constBegin();
-    while (it != properties.constEnd()) {
-        const QString propName = it.key();
-        if (!mpvObserveProperty(propName)) {
-            qCWarning(lcQMPMPV) << "Failed to observe property" << propName;
+    applyFrameCacheSize();
+    // Before "mpv_initialize()", which is the only point scripts are loaded at.
+    applyPerformanceProfile();
+    // The next entry of the playlist is opened while the current one still plays.
+    if (!mpvSetProperty(QStringLiteral("prefetch-playlist"), true)) {
+        qCWarning(lcQMPMPV) << "Failed to set \"prefetch-playlist\" to \"true\".";
+    }
+    // Compiled shaders and ICC profiles are cached on the disk, so only the very
+    // first launch has to pay for the shader compilation before the first frame.
+    const QString shaderCacheDir = Cache::directoryPath(QStringLiteral("mpv/shaders"));
+    if (shaderCacheDir.isEmpty()) {
+        qCWarning(lcQMPMPV) << "The shader cache directory is not available, shaders will be compiled from scratch.";
+    } else {
+        const bool warm = !Cache::isDirectoryEmpty(shaderCacheDir);
+        setShaderCacheWarm(warm);
+        qCDebug(lcQMPMPV) << "Shader cache directory:" << shaderCacheDir << (warm ? "(warm)" : "(cold)");
+        // Both options are only available since mpv 0.35, the failure can be ignored safely on older versions.
+        if (!mpvSetProperty(QStringLiteral("gpu-shader-cache-dir"), shaderCacheDir)) {
+            qCWarning(lcQMPMPV) << "Failed to set \"gpu-shader-cache-dir\" to" << shaderCacheDir;
+        }
+        if (!mpvSetProperty(QStringLiteral("icc-cache-dir"), shaderCacheDir)) {
+            qCWarning(lcQMPMPV) << "Failed to set \"icc-cache-dir\" to" << shaderCacheDir;
         }
-        ++it;
     }
 
+    // Only the properties something is bound to (and the few the player needs
+    // itself) are observed, mpv would send an event for every change of all the
+    // others as well. Connections made later on are picked up by "connectNotify()".
+    updateObservedProperties({});
+
     // From this point on, the wakeup function will be called. The callback
     // can come from any thread, so we use the QueuedConnection mechanism to
     // relay the wakeup in a thread-safe way.
@@ -133,29 +151,24 @@ void MPVPlayer::initialize()
         qFatal("Failed to initialize mpv player.");
     }
 
+    // Runs after the media was opened and before the decoders are created, the
+    // only point the codec is known and the decoder can still be chosen.
+    if (mpv_hook_add(m_mpv, 0, "on_preloaded", 0) < 0) {
+        qCWarning(lcQMPMPV) << "Failed to add the \"on_preloaded\" hook.";
+    }
+    // Runs before the media is closed, the last moment its position is still known.
+    if (mpv_hook_add(m_mpv, 0, "on_unload", 0) < 0) {
+        qCWarning(lcQMPMPV) << "Failed to add the \"on_unload\" hook.";
+    }
+
     connect(this, &MPVPlayer::onUpdate, this, &MPVPlayer::doUpdate, Qt::QueuedConnection);
 
-    connect(this, &MPVPlayer::playbackStateChanged, this, [this](){
-        if (isPlaying()) {
-            Q_EMIT playing();
-        }
-        if (isPaused()) {
-            Q_EMIT paused();
-        }
-        if (isStopped()) {
-            m_loaded = false;
-            const QUrl url = m_source;
-            const qint64 pos = m_lastPosition;
-            Q_EMIT stopped();
-            Q_EMIT stoppedWithPosition(url, pos);
-            m_source.clear();
-            Q_EMIT sourceChanged();
-            m_lastPosition = 0;
+    // The automatic display sync mode depends on the frame rate of the video.
+    connect(this, &MPVPlayer::loaded, this, [this](){
+        if (displaySync() == DisplaySync::Auto) {
+            applyDisplaySync();
         }
     });
-    connect(this, &MPVPlayer::positionChanged, this, [this](){
-        m_lastPosition = position();
-    });
 
     connect(this, &MPVPlayer::rendererReadyChanged, this, [this](){
         if (!m_rendererReady) {
@@ -291,15 +304,37 @@ void MPVPlayer::processMpvPropertyChange(void *event)
     if (!propertyBlackList.contains(name) && !m_livePreview) {
         qCDebug(lcQMPMPV) << name << "-->" << mpvGetProperty(name, true);
     }
-    if (properties.contains(name)) {
-        const QList<const char *> signalNames = properties.value(name);
-        if (!signalNames.isEmpty()) {
-            for (auto &&signalName : qAsConst(signalNames)) {
-                if (signalName) {
-                    QMetaObject::invokeMethod(this, signalName);
-                }
-            }
-        }
+    if ((name == QStringLiteral("pause")) || (name == QStringLiteral("idle-active"))) {
+        updatePlaybackState();
+    }
+    // Several properties share a signal, and "time-pos" changes with every
+    // frame: whatever arrives in one go is delivered as one batch.
+    notifyChanged(properties.value(name));
+}
+
+void MPVPlayer::updatePlaybackState()
+{
+    const PlaybackState state = playbackState();
+    if (m_playbackState == state) {
+        return;
+    }
+    m_playbackState = state;
+    switch (state) {
+    case PlaybackState::Playing:
+        Q_EMIT playing();
+        break;
+    case PlaybackState::Paused:
+        Q_EMIT paused();
+        break;
+    case PlaybackState::Stopped: {
+        m_loaded = false;
+        const QUrl url = m_source;
+        const qint64 pos = std::exchange(m_lastPosition, 0);
+        Q_EMIT stopped();
+        Q_EMIT stoppedWithPosition(url, pos);
+        m_source.clear();
+        Q_EMIT sourceChanged();
+    } break;
     }
 }
 
@@ -325,7 +360,7 @@ bool MPVPlayer::isStopped() const
 
 void MPVPlayer::videoReconfig()
 {
-    Q_EMIT videoSizeChanged();
+    notifyChanged(PropertyChange::VideoSize);
     // What else to do ?
 }
 
@@ -411,13 +446,84 @@ bool MPVPlayer::mpvObserveProperty(const QString &name)
     if (name.isEmpty()) {
         return false;
     }
-    const int errorCode = mpv_observe_property(m_mpv, 0, qUtf8Printable(name), MPV_FORMAT_NONE);
+    // Each observation gets its own reply user data, which is how mpv tells
+    // them apart when unobserving.
+    const quint64 id = ++m_lastObserverId;
+    const int errorCode = mpv_observe_property(m_mpv, id, qUtf8Printable(name), MPV_FORMAT_NONE);
+    if (errorCode < 0) {
+        if (!m_livePreview) {
+            qCWarning(lcQMPMPV) << "Failed to observe property" << name << ':' << mpv_error_string(errorCode);
+        }
+        return false;
+    }
+    m_observedProperties.insert(name, id);
+    return true;
+}
+
+bool MPVPlayer::mpvUnobserveProperty(const QString &name)
+{
+    Q_ASSERT(m_mpv);
+    if (!m_mpv) {
+        return false;
+    }
+    if (!m_observedProperties.contains(name)) {
+        return false;
+    }
+    const quint64 id = m_observedProperties.take(name);
+    const int errorCode = mpv_unobserve_property(m_mpv, id);
     if ((errorCode < 0) && !m_livePreview) {
-        qCWarning(lcQMPMPV) << "Failed to observe property" << name << ':' << mpv_error_string(errorCode);
+        qCWarning(lcQMPMPV) << "Failed to unobserve property" << name << ':' << mpv_error_string(errorCode);
     }
     return (errorCode >= 0);
 }
 
+void MPVPlayer::updateObservedProperties(const QMetaMethod &signal)
+{
+    if (!m_mpv) {
+        return;
+    }
+    const bool all = !signal.isValid();
+    const PropertyChanges changes = signalChange(signal);
+    if (!all && !changes) {
+        return;
+    }
+    // Connections can be made from any thread.
+    QMutexLocker locker(&m_observerMutex);
+    for (auto it = properties.constBegin(); it != properties.constEnd(); ++it) {
+        if (!all && !(it.value() & changes)) {
+            continue;
+        }
+        const QString &name = it.key();
+        const bool wanted = (internalProperties.contains(name) || hasChangeListeners(it.value()));
+        const bool observed = m_observedProperties.contains(name);
+        // mpv reports the current value of a new observation right away, so
+        // new listeners don't miss anything that changed in the meantime.
+        if (wanted && !observed) {
+            if (mpvObserveProperty(name) && !m_livePreview) {
+                qCDebug(lcQMPMPV) << "Observing" << name;
+            }
+        } else if (!wanted && observed) {
+            if (mpvUnobserveProperty(name) && !m_livePreview) {
+                qCDebug(lcQMPMPV) << "No longer observing" << name;
+            }
+        }
+    }
+}
+
+void MPVPlayer::connectNotify(const QMetaMethod &signal)
+{
+    MediaPlayer::connectNotify(signal);
+    updateObservedProperties(signal);
+}
+
+void MPVPlayer::disconnectNotify(const QMetaMethod &signal)
+{
+    MediaPlayer::disconnectNotify(signal);
+    // Called after the connection is gone. An invalid signal means everything
+    // was disconnected at once.
+    updateObservedProperties(signal);
+}
+
 QUrl MPVPlayer::source() const
 {
     return m_source;
@@ -481,12 +587,12 @@ LogLevel MPVPlayer::logLevel() const
 
 qint64 MPVPlayer::duration() const
 {
-    return isStopped() ? 0 : (mpvGetProperty(QStringLiteral("duration")).toLongLong() * 1000);
+    return isStopped() ? 0 : qRound64(mpvGetProperty(QStringLiteral("duration")).toReal() * 1000.0);
 }
 
 qint64 MPVPlayer::position() const
 {
-    return isStopped() ? 0 : (mpvGetProperty(QStringLiteral("time-pos")).toLongLong() * 1000);
+    return isStopped() ? 0 : qRound64(mpvGetProperty(QStringLiteral("time-pos")).toReal() * 1000.0);
 }
 
 qreal MPVPlayer::volume() const
@@ -519,7 +625,9 @@ qreal MPVPlayer::aspectRatio() const
 
 qreal MPVPlayer::playbackRate() const
 {
-    return mpvGetProperty(QStringLiteral("speed")).toReal();
+    const qreal speed = mpvGetProperty(QStringLiteral("speed")).toReal();
+    const bool backward = (mpvGetProperty(QStringLiteral("play-direction")).toString() == QStringLiteral("backward"));
+    return (backward ? -speed : speed);
 }
 
 QString MPVPlayer::snapshotFormat() const
@@ -792,26 +900,532 @@ void MPVPlayer::stop()
     }
 }
 
-void MPVPlayer::seek(const qint64 value)
+bool MPVPlayer::doSeek(const qint64 value, const bool exact)
 {
     if (isStopped() || (position() == value)) {
-        return;
+        return false;
     }
     if (value < 0) {
         qCWarning(lcQMPMPV) << "Media start time is 0, however, the user is trying to seek to" << value;
-        return;
+        return false;
     }
     const qint64 _duration = duration();
     if (value > _duration) {
         qCWarning(lcQMPMPV) << "Media duration is" << _duration
                             << ", however, the user is trying to seek to" << value;
-        return;
+        return false;
     }
     if (!mpvSendCommand(QVariantList{QStringLiteral("seek"),
-                                     qRound64(static_cast<qreal>(value) / 1000.0),
-                                     QStringLiteral("absolute")})) {
+                                     static_cast<qreal>(value) / 1000.0,
+                                     (exact ? QStringLiteral("absolute+exact") : QStringLiteral("absolute+keyframes"))})) {
         qCWarning(lcQMPMPV) << "Failed to send command \"seek\".";
+        return false;
+    }
+    return true;
+}
+
+bool MPVPlayer::canInterruptSeek() const
+{
+    // mpv only ever executes the latest of the queued seeks.
+    return true;
+}
+
+void MPVPlayer::stepForward()
+{
+    if (isStopped()) {
+        return;
+    }
+    // Pauses the playback by itself.
+    if (!mpvSendCommand(QVariantList{QStringLiteral("frame-step")})) {
+        qCWarning(lcQMPMPV) << "Failed to send command \"frame-step\".";
+    }
+}
+
+void MPVPlayer::stepBackward()
+{
+    if (isStopped()) {
+        return;
+    }
+    // Slow (a seek to the previous key frame and a decode up to the wanted frame)
+    // until the frames before got into the reversal buffer.
+    if (!mpvSendCommand(QVariantList{QStringLiteral("frame-back-step")})) {
+        qCWarning(lcQMPMPV) << "Failed to send command \"frame-back-step\".";
+    }
+}
+
+void MPVPlayer::applyFrameCacheSize()
+{
+    if (!m_mpv) {
+        return;
+    }
+    const QString size = QStringLiteral("%1MiB").arg(frameCacheSize());
+    if (!mpvSetProperty(QStringLiteral("video-reversal-buffer"), size)) {
+        qCWarning(lcQMPMPV) << "Failed to set \"video-reversal-buffer\" to" << size;
+    }
+}
+
+void MPVPlayer::applyTrickPlay()
+{
+    if (!m_mpv) {
+        return;
+    }
+    const bool active = trickPlay();
+    // Non key frames are discarded before they are decoded, and whatever is
+    // still too late is dropped by the decoder instead of the renderer.
+    const QString skipFrame = decodeShortcuts().skipFrame;
+    if (!mpvSetProperty(QStringLiteral("vd-lavc-skipframe"), skipFrame)) {
+        qCWarning(lcQMPMPV) << "Failed to set \"vd-lavc-skipframe\" to" << skipFrame;
+    }
+    const QString frameDrop = (active ? QStringLiteral("decoder+vo") : frameDropMode());
+    if (!mpvSetProperty(QStringLiteral("framedrop"), frameDrop)) {
+        qCWarning(lcQMPMPV) << "Failed to set \"framedrop\" to" << frameDrop;
+    }
+    // Plain resampling instead of scaletempo, the audio is hardly useful at such rates anyway.
+    if (!mpvSetProperty(QStringLiteral("audio-pitch-correction"), !active)) {
+        qCWarning(lcQMPMPV) << "Failed to set \"audio-pitch-correction\" to" << !active;
+    }
+}
+
+void MPVPlayer::applyLoopRange()
+{
+    if (!m_mpv) {
+        return;
+    }
+    const bool active = (loopStart() >= 0);
+    const QVariant a = (active ? QVariant(static_cast<qreal>(loopStart()) / 1000.0) : QVariant(QStringLiteral("no")));
+    const QVariant b = (active ? QVariant(static_cast<qreal>(loopEnd()) / 1000.0) : QVariant(QStringLiteral("no")));
+    if (!mpvSetProperty(QStringLiteral("ab-loop-a"), a) || !mpvSetProperty(QStringLiteral("ab-loop-b"), b)) {
+        qCWarning(lcQMPMPV) << "Failed to change the A-B loop to" << a << b;
+    }
+    applyCacheOptions();
+}
+
+void MPVPlayer::applyCacheOptions()
+{
+    if (!m_mpv) {
+        return;
     }
+    const bool loop = (loopStart() >= 0);
+    // The demuxer keeps the packets it already passed, so jumping back to the
+    // loop start is served from memory: no I/O and no demuxer seek at all.
+    // mpv only caches network streams by default, which excludes slow network
+    // shares mounted locally.
+    const QString cache = ((loop || diskCache()) ? QStringLiteral("yes") : QStringLiteral("auto"));
+    if (!mpvSetProperty(QStringLiteral("cache"), cache)) {
+        qCWarning(lcQMPMPV) << "Failed to set \"cache\" to" << cache;
+    }
+    if (!mpvSetProperty(QStringLiteral("demuxer-seekable-cache"), cache)) {
+        qCWarning(lcQMPMPV) << "Failed to set \"demuxer-seekable-cache\" to" << cache;
+    }
+    if (!mpvSetProperty(QStringLiteral("cache-on-disk"), diskCache())) {
+        qCWarning(lcQMPMPV) << "Failed to set \"cache-on-disk\" to" << diskCache();
+    }
+    // An active loop needs at least the loop cache. Otherwise the explicit size,
+    // a quarter of a limited cache, or mpv's default.
+    const int cacheSize = effectiveCacheSize();
+    int backSize = 50;
+    if (backBufferSize() > 0) {
+        backSize = backBufferSize();
+    } else if (cacheSize > 0) {
+        backSize = qMax(1, cacheSize / 4);
+    }
+    if (loop) {
+        backSize = qMax(backSize, loopCacheSize());
+    }
+    // A limited cache is the budget of both buffers together, the explicit
+    // sizes included: the back buffer gets what it asks for within it, the
+    // forward buffer the rest. Otherwise mpv's default for the forward buffer.
+    int forwardSize = 150;
+    if (cacheSize > 0) {
+        backSize = qMin(backSize, qMax(1, cacheSize - 1));
+        forwardSize = qMax(1, cacheSize - backSize);
+    }
+    const QString maxBytes = QStringLiteral("%1MiB").arg(forwardSize);
+    if (!mpvSetProperty(QStringLiteral("demuxer-max-bytes"), maxBytes)) {
+        qCWarning(lcQMPMPV) << "Failed to set \"demuxer-max-bytes\" to" << maxBytes;
+    }
+    const QString backBytes = QStringLiteral("%1MiB").arg(backSize);
+    if (!mpvSetProperty(QStringLiteral("demuxer-max-back-bytes"), backBytes)) {
+        qCWarning(lcQMPMPV) << "Failed to set \"demuxer-max-back-bytes\" to" << backBytes;
+    }
+}
+
+bool MPVPlayer::isPositionCached(const qint64 value) const
+{
+    if (!m_mpv || !isLoaded()) {
+        return false;
+    }
+    // Seeks into any of these ranges are served from the demuxer cache.
+    const QVariantMap state = mpvGetProperty(QStringLiteral("demuxer-cache-state"), true).toMap();
+    const QVariantList ranges = state.value(QStringLiteral("seekable-ranges")).toList();
+    const qreal seconds = (static_cast<qreal>(value) / 1000.0);
+    for (auto &&range : qAsConst(ranges)) {
+        const QVariantMap map = range.toMap();
+        if ((seconds >= map.value(QStringLiteral("start")).toReal())
+                && (seconds <= map.value(QStringLiteral("end")).toReal())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MPVPlayer::applyNextMedia()
+{
+    if (!m_mpv || m_livePreview || !m_source.isValid()) {
+        return;
+    }
+    // mpv's playlist only ever holds the current media and the preloaded one.
+    if (m_nextMedia.isValid()) {
+        const int count = mpvGetProperty(QStringLiteral("playlist-count")).toInt();
+        if ((count > 1) && !mpvSendCommand(QVariantList{QStringLiteral("playlist-remove"), count - 1})) {
+            qCWarning(lcQMPMPV) << "Failed to send command \"playlist-remove\".";
+        }
+        m_nextMedia.clear();
+    }
+    const QUrl next = nextMedia();
+    if (!next.isValid()) {
+        return;
+    }
+    const QString url = (next.isLocalFile() ? QDir::toNativeSeparators(next.toLocalFile()) : next.toString());
+    if (!mpvSendCommand(QVariantList{QStringLiteral("loadfile"), url, QStringLiteral("append")})) {
+        qCWarning(lcQMPMPV) << "Failed to append" << url << "to the playlist.";
+        return;
+    }
+    m_nextMedia = next;
+    qCDebug(lcQMPMPV) << "Next media -->" << url;
+}
+
+void MPVPlayer::applyResourceLimits()
+{
+    if (!m_mpv) {
+        return;
+    }
+    // Zero means "auto" for mpv as well. mpv applies it the next time it
+    // creates the decoder, the running one keeps its threads.
+    const int threads = effectiveDecoderThreads();
+    if (!mpvSetProperty(QStringLiteral("vd-lavc-threads"), threads)) {
+        qCWarning(lcQMPMPV) << "Failed to set \"vd-lavc-threads\" to" << threads;
+    }
+    // mpv's default is one second.
+    const qint64 readAheadTime = effectiveReadAheadTime();
+    const qreal readAhead = ((readAheadTime >= 0) ? (static_cast<qreal>(readAheadTime) / 1000.0) : 1.0);
+    if (!mpvSetProperty(QStringLiteral("demuxer-readahead-secs"), readAhead)) {
+        qCWarning(lcQMPMPV) << "Failed to set \"demuxer-readahead-secs\" to" << readAhead;
+    }
+    // The cache size is split between the forward and back buffers there.
+    applyCacheOptions();
+}
+
+qint64 MPVPlayer::queryMemoryUsage() const
+{
+    if (!m_mpv || !isLoaded()) {
+        return -1;
+    }
+    // "total-bytes" covers the back buffer as well, older mpv versions only
+    // report the forward part.
+    const QVariantMap state = mpvGetProperty(QStringLiteral("demuxer-cache-state"), true).toMap();
+    bool ok = false;
+    qint64 bytes = state.value(QStringLiteral("total-bytes")).toLongLong(&ok);
+    if (!ok) {
+        bytes = state.value(QStringLiteral("fw-bytes")).toLongLong(&ok);
+    }
+    return (ok ? bytes : -1);
+}
+
+CacheState MPVPlayer::queryCacheState()
+{
+    if (!m_mpv || !isLoaded()) {
+        return {};
+    }
+    const QVariantMap state = mpvGetProperty(QStringLiteral("demuxer-cache-state"), true).toMap();
+    CacheState result = {};
+    const QVariantList ranges = state.value(QStringLiteral("seekable-ranges")).toList();
+    for (auto &&range : qAsConst(ranges)) {
+        const QVariantMap map = range.toMap();
+        result.ranges.append(qMakePair(qRound64(map.value(QStringLiteral("start")).toReal() * 1000.0),
+                                       qRound64(map.value(QStringLiteral("end")).toReal() * 1000.0)));
+    }
+    bool ok = false;
+    const qint64 rate = state.value(QStringLiteral("raw-input-rate")).toLongLong(&ok);
+    result.inputRate = (ok ? rate : -1);
+    result.underrun = state.value(QStringLiteral("underrun")).toBool();
+    return result;
+}
+
+void MPVPlayer::applyPerformanceProfile()
+{
+    if (!m_mpv) {
+        return;
+    }
+    const PerformanceSettings settings = performanceSettings();
+    // Scripts are only loaded by "mpv_initialize()", later changes take effect
+    // for the youtube-dl hook only, which checks its option for every media.
+    if (!mpvSetProperty(QStringLiteral("load-scripts"), settings.scripts)) {
+        qCWarning(lcQMPMPV) << "Failed to set \"load-scripts\" to" << settings.scripts;
+    }
+    if (!mpvSetProperty(QStringLiteral("ytdl"), settings.scripts)) {
+        qCWarning(lcQMPMPV) << "Failed to set \"ytdl\" to" << settings.scripts;
+    }
+    const QString hrSeek = (m_livePreview ? QStringLiteral("yes") : QStringLiteral("default"));
+    if (!mpvSetProperty(QStringLiteral("hr-seek"), hrSeek)) {
+        qCWarning(lcQMPMPV) << "Failed to set \"hr-seek\" to" << hrSeek;
+    }
+    // The frame drop policy, the decoder threads and the read ahead are shared
+    // with trick play and the resource limits.
+    applyTrickPlay();
+    applyResourceLimits();
+    for (auto it = settings.backendOptions.constBegin(); it != settings.backendOptions.constEnd(); ++it) {
+        if (!mpvSetProperty(it.key(), it.value())) {
+            qCWarning(lcQMPMPV) << "Failed to set" << it.key() << "to" << it.value();
+        }
+    }
+}
+
+void MPVPlayer::applyVideoDecoding()
+{
+    if (!m_mpv) {
+        return;
+    }
+    if (suspended()) {
+        // All tracks are deselected already, only decide what resuming restores.
+        if (videoDecodingEnabled()) {
+            m_suspendedTracks.insert(QStringLiteral("vid"), (m_videoTrack.isValid() ? std::exchange(m_videoTrack, {}) : QVariant(QStringLiteral("auto"))));
+        } else {
+            m_videoTrack = m_suspendedTracks.take(QStringLiteral("vid"));
+        }
+        return;
+    }
+    if (!videoDecodingEnabled()) {
+        bool ok = false;
+        const QVariant track = mpvGetProperty(QStringLiteral("vid"), true, &ok);
+        m_videoTrack = (ok ? track : QVariant(QStringLiteral("auto")));
+        // Deselecting the track tears the whole video chain down, the decoder
+        // included, while the audio keeps playing. It stays that way for the
+        // following media too.
+        if (!mpvSetProperty(QStringLiteral("vid"), QStringLiteral("no"))) {
+            qCWarning(lcQMPMPV) << "Failed to set \"vid\" to \"no\".";
+        }
+        return;
+    }
+    const QVariant track = (m_videoTrack.isValid() ? std::exchange(m_videoTrack, {}) : QVariant(QStringLiteral("auto")));
+    // mpv re-syncs the new video chain with the audio by itself: it decodes from
+    // the previous key frame of the current position, no reload involved.
+    if (!mpvSetProperty(QStringLiteral("vid"), track)) {
+        qCWarning(lcQMPMPV) << "Failed to set \"vid\" to" << track;
+    }
+}
+
+void MPVPlayer::applySuspension()
+{
+    if (!m_mpv) {
+        return;
+    }
+    if (suspended()) {
+        m_suspendedTracks.clear();
+        QStringList names = {QStringLiteral("aid"), QStringLiteral("sid")};
+        // Without video decoding, the video track is deselected already.
+        if (videoDecodingEnabled()) {
+            names.append(QStringLiteral("vid"));
+        }
+        for (auto &&name : qAsConst(names)) {
+            bool ok = false;
+            const QVariant track = mpvGetProperty(name, true, &ok);
+            m_suspendedTracks.insert(name, (ok ? track : QVariant(QStringLiteral("auto"))));
+            // Deselecting a track destroys its decoder and its frame queue.
+            if (!mpvSetProperty(name, QStringLiteral("no"))) {
+                qCWarning(lcQMPMPV) << "Failed to set" << name << "to \"no\".";
+            }
+        }
+        // And this releases the packets buffered by the demuxer. The media itself stays open.
+        if (!mpvSendCommand(QVariantList{QStringLiteral("drop-buffers")})) {
+            qCWarning(lcQMPMPV) << "Failed to send command \"drop-buffers\".";
+        }
+        return;
+    }
+    for (auto it = m_suspendedTracks.constBegin(); it != m_suspendedTracks.constEnd(); ++it) {
+        if (!mpvSetProperty(it.key(), it.value())) {
+            qCWarning(lcQMPMPV) << "Failed to set" << it.key() << "to" << it.value();
+        }
+    }
+    m_suspendedTracks.clear();
+}
+
+void MPVPlayer::processMpvHook(void *event)
+{
+    Q_ASSERT(event);
+    if (!event) {
+        return;
+    }
+    const auto hook = static_cast<mpv_event_hook *>(event);
+    if (qstrcmp(hook->name, "on_preloaded") == 0) {
+        applyDecoderSelection();
+    } else if (qstrcmp(hook->name, "on_unload") == 0) {
+        // Nothing observes "time-pos" unless somebody listens to "positionChanged()".
+        m_lastPosition = qMax(qint64(0), qRound64(mpvGetProperty(QStringLiteral("time-pos"), true).toReal() * 1000.0));
+    }
+    // mpv waits for us, whatever happened.
+    mpv_hook_continue(m_mpv, hook->id);
+}
+
+void MPVPlayer::applyDecoderSelection()
+{
+    if (m_livePreview) {
+        return;
+    }
+    DecoderConfig config = {};
+    const QString codec = mpvGetProperty(QStringLiteral("current-tracks/video/codec"), true).toString();
+    const QUrl url = (m_switchingToNextMedia ? m_nextMedia : m_source);
+    const bool selected = selectDecoder(codec, url, &config);
+    if (!selected && !m_decoderSelected) {
+        return;
+    }
+    // An empty value restores mpv's default.
+    const QString decoder = (selected ? (QStringLiteral("lavc:") + config.decoder) : QString{});
+    if (!mpvSetProperty(QStringLiteral("vd"), decoder)) {
+        qCWarning(lcQMPMPV) << "Failed to set \"vd\" to" << decoder;
+    }
+    m_decoderSelected = selected;
+    m_sliceThreads = (selected && config.sliceThreads);
+    qCDebug(lcQMPMPV) << "Video decoder of" << codec << "-->" << decoder << (m_sliceThreads ? "(slice threads)" : "");
+    applyDecoderOptions();
+}
+
+void MPVPlayer::applyDecoderOptions()
+{
+    if (!m_mpv) {
+        return;
+    }
+    // Passed on to libavcodec as they are. "lowres" only works with a few old
+    // codecs, the others ignore it.
+    QStringList options = {};
+    if (m_sliceThreads) {
+        options.append(QStringLiteral("thread_type=slice"));
+    }
+    const int lowres = decodeShortcuts().lowres;
+    if (lowres > 0) {
+        options.append(QStringLiteral("lowres=%1").arg(lowres));
+    }
+    const QString value = options.join(u',');
+    if (!mpvSetProperty(QStringLiteral("vd-lavc-o"), value)) {
+        qCWarning(lcQMPMPV) << "Failed to set \"vd-lavc-o\" to" << value;
+    }
+}
+
+FrameStatistics MPVPlayer::queryFrameStatistics()
+{
+    if (!m_mpv || !isLoaded()) {
+        return {};
+    }
+    // The estimated frame number follows the playback position, it counts the
+    // dropped frames as well.
+    bool ok = false;
+    const qint64 frames = mpvGetProperty(QStringLiteral("estimated-frame-number"), true, &ok).toLongLong();
+    if (!ok) {
+        return {};
+    }
+    qint64 dropped = 0;
+    for (auto &&name : {QStringLiteral("frame-drop-count"), QStringLiteral("decoder-frame-drop-count"), QStringLiteral("vo-delayed-frame-count")}) {
+        dropped += mpvGetProperty(name, true).toLongLong();
+    }
+    FrameStatistics result = {};
+    result.presented = qMax(qint64(0), frames - dropped);
+    result.dropped = dropped;
+    return result;
+}
+
+void MPVPlayer::applyDecodeQuality()
+{
+    if (!m_mpv) {
+        return;
+    }
+    const DecodeShortcuts shortcuts = decodeShortcuts();
+    // The renderer's defaults are cheap already, only user settings get overridden.
+    static const std::pair<QString, QString> kFastRenderingOptions[] = {
+        {QStringLiteral("scale"), QStringLiteral("bilinear")},
+        {QStringLiteral("dscale"), QStringLiteral("bilinear")},
+        {QStringLiteral("cscale"), QStringLiteral("bilinear")},
+        {QStringLiteral("dither-depth"), QStringLiteral("no")},
+        {QStringLiteral("deband"), QStringLiteral("no")},
+        {QStringLiteral("deinterlace"), QStringLiteral("no")}
+    };
+    const bool fastRendering = shortcuts.fastRendering;
+    if (fastRendering && m_renderingOptions.isEmpty()) {
+        for (auto &&option : kFastRenderingOptions) {
+            bool ok = false;
+            const QVariant value = mpvGetProperty(option.first, true, &ok);
+            if (ok) {
+                m_renderingOptions.insert(option.first, value);
+            }
+            if (!mpvSetProperty(option.first, option.second)) {
+                qCWarning(lcQMPMPV) << "Failed to set" << option.first << "to" << option.second;
+            }
+        }
+    } else if (!fastRendering && !m_renderingOptions.isEmpty()) {
+        for (auto it = m_renderingOptions.constBegin(); it != m_renderingOptions.constEnd(); ++it) {
+            if (!mpvSetProperty(it.key(), it.value())) {
+                qCWarning(lcQMPMPV) << "Failed to set" << it.key() << "to" << it.value();
+            }
+        }
+        m_renderingOptions.clear();
+    }
+    if (!mpvSetProperty(QStringLiteral("vd-lavc-skiploopfilter"), shortcuts.skipLoopFilter)) {
+        qCWarning(lcQMPMPV) << "Failed to set \"vd-lavc-skiploopfilter\" to" << shortcuts.skipLoopFilter;
+    }
+    if (!mpvSetProperty(QStringLiteral("vd-lavc-fast"), shortcuts.fast)) {
+        qCWarning(lcQMPMPV) << "Failed to set \"vd-lavc-fast\" to" << shortcuts.fast;
+    }
+    applyDecoderOptions();
+    // The frame skipping is shared with trick play.
+    applyTrickPlay();
+}
+
+void MPVPlayer::applyAudioOutput()
+{
+    if (!m_mpv) {
+        return;
+    }
+    // An empty driver list lets mpv try all of them in its own order.
+    const QString output = audioOutput();
+    if (!mpvSetProperty(QStringLiteral("ao"), output)) {
+        qCWarning(lcQMPMPV) << "Failed to set \"ao\" to" << output;
+    }
+    // mpv queues 200 ms by default.
+    const int bufferSize = effectiveAudioBufferSize();
+    const qreal buffer = ((bufferSize > 0) ? (qreal(bufferSize) / 1000.0) : 0.2);
+    if (!mpvSetProperty(QStringLiteral("audio-buffer"), buffer)) {
+        qCWarning(lcQMPMPV) << "Failed to set \"audio-buffer\" to" << buffer;
+    }
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+    // ALSA takes the device buffer in microseconds and the number of periods in
+    // it, 100 ms in 4 periods by default.
+    const int bufferTime = ((bufferSize > 0) ? (bufferSize * 1000) : 100000);
+    const int periodSize = audioPeriodSize();
+    const int periods = ((periodSize > 0) ? qMax(2, qRound(qreal(bufferTime) / qreal(periodSize * 1000))) : 4);
+    if (!mpvSetProperty(QStringLiteral("alsa-buffer-time"), bufferTime)) {
+        qCWarning(lcQMPMPV) << "Failed to set \"alsa-buffer-time\" to" << bufferTime;
+    }
+    if (!mpvSetProperty(QStringLiteral("alsa-periods"), periods)) {
+        qCWarning(lcQMPMPV) << "Failed to set \"alsa-periods\" to" << periods;
+    }
+#endif
+    // The options are only read when the audio output is opened.
+    if (isLoaded() && !mpvSendCommand(QVariantList{QStringLiteral("ao-reload")})) {
+        qCWarning(lcQMPMPV) << "Failed to reload the audio output.";
+    }
+}
+
+DecoderBenchmarker *MPVPlayer::createDecoderBenchmarker() const
+{
+    return new MPVDecoderBenchmarker;
+}
+
+QString MPVPlayer::frameDropMode() const
+{
+    const PerformanceSettings settings = performanceSettings();
+    if (settings.decoderFrameDrop) {
+        return QStringLiteral("decoder+vo");
+    }
+    return (settings.frameDrop ? QStringLiteral("vo") : QStringLiteral("no"));
 }
 
 void MPVPlayer::snapshot()
@@ -827,8 +1441,10 @@ void MPVPlayer::snapshot()
 
 void MPVPlayer::setSource(const QUrl &value)
 {
+    const qint64 startPosition = qMax(takeStartPosition(), std::exchange(m_cachedStartPosition, 0));
     if (!m_rendererReady) {
         m_cachedUrl = value;
+        m_cachedStartPosition = startPosition;
         return;
     }
     if (value.isEmpty()) {
@@ -860,10 +1476,16 @@ void MPVPlayer::setSource(const QUrl &value)
         return;
     }
     stop();
-    const bool result = mpvSendCommand(QVariantList{QStringLiteral("loadfile"), value.isLocalFile()
-                                                        ? QDir::toNativeSeparators(value.toLocalFile())
-                                                        : value.toString()});
+    QVariantMap command = {};
+    command.insert(QStringLiteral("name"), QStringLiteral("loadfile"));
+    command.insert(QStringLiteral("url"), value.isLocalFile() ? QDir::toNativeSeparators(value.toLocalFile()) : value.toString());
+    // A per-file option, the demuxer starts right at the resume position.
+    if (startPosition > 0) {
+        command.insert(QStringLiteral("options"), QStringLiteral("start=%1").arg(QString::number(qreal(startPosition) / 1000.0, 'f', 3)));
+    }
+    const bool result = mpvSendCommand(command);
     if (result) {
+        startFirstFrameTimer();
         if (m_livePreview || !m_autoStart) {
             if (!mpvSetProperty(QStringLiteral("pause"), true)) {
                 qCWarning(lcQMPMPV) << "Failed to set \"pause\" to \"true\".";
@@ -871,6 +1493,10 @@ void MPVPlayer::setSource(const QUrl &value)
         }
         m_source = value;
         Q_EMIT sourceChanged();
+        // Loading a new file cleared the playlist.
+        m_nextMedia.clear();
+        m_switchingToNextMedia = false;
+        applyNextMedia();
     }
 }
 
@@ -946,7 +1572,7 @@ void MPVPlayer::setLogLevel(const LogLevel value)
 
 void MPVPlayer::setPosition(const qint64 value)
 {
-    seek(value);
+    seek(value, SeekMode::Exact);
 }
 
 void MPVPlayer::setVolume(const qreal value)
@@ -1020,13 +1646,20 @@ void MPVPlayer::setPlaybackRate(const qreal value)
     if (qFuzzyCompare(playbackRate(), value)) {
         return;
     }
-    if (value <= 0.0) {
+    if (qFuzzyIsNull(value)) {
         qCWarning(lcQMPMPV) << "The user is trying to change the playback rate to"
                             << value << ", which is not allowed.";
         return;
     }
-    if (!mpvSetProperty(QStringLiteral("speed"), value)) {
-        qCWarning(lcQMPMPV) << "Failed to set \"speed\" to" << value;
+    // Negative rates play backwards, mpv keeps the decoded frames of the
+    // previous GOPs in its reversal buffer for that.
+    const QString direction = ((value < 0.0) ? QStringLiteral("backward") : QStringLiteral("forward"));
+    if (!mpvSetProperty(QStringLiteral("play-direction"), direction)) {
+        qCWarning(lcQMPMPV) << "Failed to set \"play-direction\" to" << direction;
+        return;
+    }
+    if (!mpvSetProperty(QStringLiteral("speed"), qAbs(value))) {
+        qCWarning(lcQMPMPV) << "Failed to set \"speed\" to" << qAbs(value);
     }
 }
 
@@ -1074,16 +1707,12 @@ void MPVPlayer::setLivePreview(const bool value)
         if (!mpvSetProperty(QStringLiteral("mute"), true)) {
             qCWarning(lcQMPMPV) << "Failed to set \"mute\" to \"true\".";
         }
-        if (!mpvSetProperty(QStringLiteral("hr-seek"), QStringLiteral("yes"))) {
-            qCWarning(lcQMPMPV) << "Failed to set \"hr-seek\" to \"yes\".";
-        }
     } else {
-        if (!mpvSetProperty(QStringLiteral("hr-seek"), QStringLiteral("default"))) {
-            qCWarning(lcQMPMPV) << "Failed to set \"hr-seek\" to \"default\".";
-        }
         setLogLevel(LogLevel::Warning); // TODO: back to previous
     }
     m_livePreview = value;
+    // Live preview uses the preview profile.
+    applyPerformanceProfile();
     Q_EMIT livePreviewChanged();
 }
 
@@ -1179,21 +1808,31 @@ void MPVPlayer::handleMpvEvents()
         // loaded).
         case MPV_EVENT_START_FILE:
             m_mediaStatus = MediaStatusFlag::Loading;
-            Q_EMIT mediaStatusChanged();
+            notifyChanged(PropertyChange::MediaStatus);
             break;
         // Notification after playback end (after the file was unloaded).
         // See also mpv_event and mpv_event_end_file.
-        case MPV_EVENT_END_FILE:
+        case MPV_EVENT_END_FILE: {
+            const auto endFile = static_cast<mpv_event_end_file *>(event->data);
+            if (endFile && (endFile->reason == MPV_END_FILE_REASON_EOF) && m_nextMedia.isValid()) {
+                m_switchingToNextMedia = true;
+                startTransitionTimer();
+            }
             m_loaded = false;
             m_mediaStatus = (MediaStatusFlag::NoMedia | MediaStatusFlag::Unloaded | MediaStatusFlag::End);
-            Q_EMIT mediaStatusChanged();
-            break;
+            notifyChanged(PropertyChange::MediaStatus);
+        } break;
         // Notification when the file has been loaded (headers were read
         // etc.), and decoding starts.
         case MPV_EVENT_FILE_LOADED:
+            if (std::exchange(m_switchingToNextMedia, false)) {
+                m_source = std::exchange(m_nextMedia, QUrl{});
+                Q_EMIT sourceChanged();
+                advanceQueue();
+            }
             m_loaded = true;
             m_mediaStatus = (MediaStatusFlag::Loaded | MediaStatusFlag::Prepared | MediaStatusFlag::Buffering);
-            Q_EMIT mediaStatusChanged();
+            notifyChanged(PropertyChange::MediaStatus);
             Q_EMIT loaded();
             break;
         // Triggered by the script-message input command. The command uses the
@@ -1226,7 +1865,7 @@ void MPVPlayer::handleMpvEvents()
         case MPV_EVENT_SEEK:
             m_mediaStatus &= ~MediaStatus(MediaStatusFlag::Buffered);
             m_mediaStatus |= (MediaStatusFlag::Seeking | MediaStatusFlag::Buffering);
-            Q_EMIT mediaStatusChanged();
+            notifyChanged(PropertyChange::MediaStatus);
             break;
         // There was a discontinuity of some sort (like a seek), and playback
         // was reinitialized. Usually happens after seeking, or ordered chapter
@@ -1235,7 +1874,8 @@ void MPVPlayer::handleMpvEvents()
         case MPV_EVENT_PLAYBACK_RESTART:
             m_mediaStatus &= ~(MediaStatusFlag::Seeking | MediaStatusFlag::Buffering);
             m_mediaStatus |= MediaStatusFlag::Buffered;
-            Q_EMIT mediaStatusChanged();
+            notifyChanged(PropertyChange::MediaStatus);
+            seekFinished();
             break;
         // Event sent due to mpv_observe_property().
         // See also mpv_event and mpv_event_property.
@@ -1257,6 +1897,7 @@ void MPVPlayer::handleMpvEvents()
         // continue the hook with mpv_hook_continue().
         // See also mpv_event and mpv_event_hook.
         case MPV_EVENT_HOOK:
+            processMpvHook(event->data);
             break;
         default:
             break;
@@ -1273,6 +1914,13 @@ void MPVPlayer::handleMpvEvents()
 void MPVPlayer::invalidateSceneGraph() // Called on the render thread when the scenegraph is invalidated
 {
     m_node = nullptr;
+    // The render context is bound to the graphics context which is going away, it
+    // can't be reused any more. The OpenGL context is still current at this point.
+    if (m_mpv_gl) {
+        mpv_render_context_free(m_mpv_gl);
+        m_mpv_gl = nullptr;
+        QMetaObject::invokeMethod(this, "setRendererReady", Qt::QueuedConnection, Q_ARG(bool, false));
+    }
 }
 
 void MPVPlayer::setRendererReady(const bool value)
@@ -1284,8 +1932,46 @@ void MPVPlayer::setRendererReady(const bool value)
     Q_EMIT rendererReadyChanged();
 }
 
+void MPVPlayer::applyDisplaySync()
+{
+    if (!m_mpv) {
+        return;
+    }
+    const qreal refreshRate = displayRefreshRate();
+    // libmpv has no way to query the display by itself, but all the display-*
+    // sync modes need to know its refresh rate. The option got renamed in mpv 0.36.
+    if (refreshRate > 0.0) {
+        if (!mpvSetProperty(QStringLiteral("override-display-fps"), refreshRate)) {
+            if (!mpvSetProperty(QStringLiteral("display-fps"), refreshRate)) {
+                qCWarning(lcQMPMPV) << "Failed to tell mpv the display refresh rate.";
+            }
+        }
+    }
+    const qreal videoFrameRate = (isLoaded() ? mpvGetProperty(QStringLiteral("container-fps"), true).toReal() : 0.0);
+    QString videoSync = QStringLiteral("audio");
+    switch (effectiveDisplaySync(videoFrameRate)) {
+    case DisplaySync::Resample:
+        videoSync = QStringLiteral("display-resample");
+        break;
+    case DisplaySync::FrameDrop:
+        videoSync = QStringLiteral("display-vdrop");
+        break;
+    default:
+        break;
+    }
+    if (refreshRate <= 0.0) {
+        // Locking to an unknown refresh rate doesn't work.
+        videoSync = QStringLiteral("audio");
+    }
+    if (!mpvSetProperty(QStringLiteral("video-sync"), videoSync)) {
+        qCWarning(lcQMPMPV) << "Failed to change the video sync mode to" << videoSync;
+    }
+}
+
 void MPVPlayer::releaseResources() // Called on the gui thread if the item is removed from scene
 {
+    // Only the node (and its FBO) is gone, the render context is kept
+    // alive and will be reused when the item is shown again.
     m_node = nullptr;
 }
 
@@ -1321,4 +2007,15 @@ void MPVPlayer::geometryChanged(const QRectF &newGeometry, const QRectF &oldGeom
     }
 }
 
+MPVStreamSwitcher::MPVStreamSwitcher(QQuickItem *parent) : StreamSwitcher(parent)
+{
+}
+
+MPVStreamSwitcher::~MPVStreamSwitcher() = default;
+
+MediaPlayer *MPVStreamSwitcher::createPlayer() const
+{
+    return new MPVPlayer;
+}
+
 QTMEDIAPLAYER_END_NAMESPACE
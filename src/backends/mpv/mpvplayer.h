@@ -26,6 +26,8 @@
 
 #include "mpvbackend_global.h"
 #include "../../common/playerinterface.h"
+#include "../../common/streamswitcher.h"
+#include <QtCore/qmutex.h>
 
 struct mpv_handle;
 struct mpv_render_context;
@@ -137,7 +139,8 @@ public Q_SLOTS:
     void play() override;
     void pause() override;
     void stop() override;
-    void seek(const qint64 value) override;
+    void stepForward() override;
+    void stepBackward() override;
     void snapshot() override;
 
 public:
@@ -151,6 +154,26 @@ protected Q_SLOTS:
 
 protected:
     Q_NODISCARD QSGNode *updatePaintNode(QSGNode *node, UpdatePaintNodeData *data) override;
+    void applyDisplaySync() override;
+    bool doSeek(const qint64 value, const bool exact) override;
+    Q_NODISCARD bool canInterruptSeek() const override;
+    void applyFrameCacheSize() override;
+    void applyTrickPlay() override;
+    void applyLoopRange() override;
+    Q_NODISCARD bool isPositionCached(const qint64 value) const override;
+    void applyNextMedia() override;
+    void applyResourceLimits() override;
+    Q_NODISCARD qint64 queryMemoryUsage() const override;
+    Q_NODISCARD CacheState queryCacheState() override;
+    Q_NODISCARD DecoderBenchmarker *createDecoderBenchmarker() const override;
+    Q_NODISCARD FrameStatistics queryFrameStatistics() override;
+    void applyDecodeQuality() override;
+    void applyAudioOutput() override;
+    void applyPerformanceProfile() override;
+    void applyVideoDecoding() override;
+    void applySuspension() override;
+    void connectNotify(const QMetaMethod &signal) override;
+    void disconnectNotify(const QMetaMethod &signal) override;
 #if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
     void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) override;
 #else
@@ -159,7 +182,7 @@ protected:
 
 private Q_SLOTS:
     void doUpdate();
-    void invalidateSceneGraph();
+    void invalidateSceneGraph() override;
     void setRendererReady(const bool value);
 
 private:
@@ -172,13 +195,25 @@ private:
     Q_NODISCARD bool mpvSetProperty(const QString &name, const QVariant &value);
     Q_NODISCARD QVariant mpvGetProperty(const QString &name, const bool silent = false, bool *ok = nullptr) const;
     Q_NODISCARD bool mpvObserveProperty(const QString &name);
+    Q_NODISCARD bool mpvUnobserveProperty(const QString &name);
+    // Observes the properties behind the given NOTIFY signal if anything listens
+    // to it, stops observing them otherwise. An invalid signal means all of them.
+    void updateObservedProperties(const QMetaMethod &signal);
 
     void processMpvLogMessage(void *event);
     void processMpvPropertyChange(void *event);
+    void processMpvHook(void *event);
+    // Emits "playing()", "paused()" or "stopped()" if the state really changed.
+    void updatePlaybackState();
 
     void videoReconfig();
     void audioReconfig();
 
+    Q_NODISCARD QString frameDropMode() const;
+    void applyCacheOptions();
+    void applyDecoderSelection();
+    void applyDecoderOptions();
+
 Q_SIGNALS:
     void onUpdate();
     void hasMpvEvents();
@@ -191,40 +226,66 @@ private:
 
     QUrl m_source = {};
     QUrl m_cachedUrl = {};
+    qint64 m_cachedStartPosition = 0;
+    QUrl m_nextMedia = {}; // The entry appended to mpv's playlist.
+    bool m_switchingToNextMedia = false;
+    bool m_decoderSelected = false;
+    bool m_sliceThreads = false;
+    QVariantHash m_renderingOptions = {}; // The values to restore once the quality tier goes back up.
+    QVariant m_videoTrack = {}; // The selection to restore once video decoding is enabled again.
+    QVariantHash m_suspendedTracks = {}; // The selections to restore when resuming.
     MediaStatus m_mediaStatus = {};
     bool m_livePreview = false;
     bool m_autoStart = true;
-    qint64 m_lastPosition = 0;
+    qint64 m_lastPosition = 0; // Read when the media is unloaded, for "stoppedWithPosition()".
+    PlaybackState m_playbackState = PlaybackState::Stopped; // The last state announced.
     bool m_rendererReady = false;
     bool m_loaded = false;
 
-    static inline const QHash<QString, QList<const char *>> properties =
+    QMutex m_observerMutex;
+    QHash<QString, quint64> m_observedProperties = {}; // The reply user data of each observation.
+    quint64 m_lastObserverId = 0;
+
+    static inline const QHash<QString, PropertyChanges> properties =
+    {
+        {QStringLiteral("dwidth"), PropertyChange::VideoSize},
+        {QStringLiteral("dheight"), PropertyChange::VideoSize},
+        {QStringLiteral("duration"), PropertyChange::Duration},
+        {QStringLiteral("time-pos"), PropertyChange::Position},
+        {QStringLiteral("volume"), PropertyChange::Volume},
+        {QStringLiteral("mute"), PropertyChange::Mute},
+        {QStringLiteral("seekable"), PropertyChange::Seekable},
+        {QStringLiteral("hwdec"), PropertyChange::HardwareDecoding},
+        {QStringLiteral("video-out-params/aspect"), PropertyChange::AspectRatio},
+        {QStringLiteral("speed"), PropertyChange::PlaybackRate},
+        {QStringLiteral("play-direction"), PropertyChange::PlaybackRate},
+        {QStringLiteral("filename"), PropertyChange::FileName},
+        {QStringLiteral("screenshot-format"), PropertyChange::SnapshotFormat},
+        {QStringLiteral("screenshot-template"), PropertyChange::SnapshotTemplate},
+        {QStringLiteral("screenshot-directory"), PropertyChange::SnapshotDirectory},
+        {QStringLiteral("path"), PropertyChange::FilePath},
+        {QStringLiteral("pause"), PropertyChange::PlaybackState},
+        {QStringLiteral("idle-active"), PropertyChange::PlaybackState},
+        {QStringLiteral("track-list"), PropertyChange::MediaTracks},
+        {QStringLiteral("chapter-list"), PropertyChange::Chapters},
+        {QStringLiteral("metadata"), PropertyChange::MetaData},
+        {QStringLiteral("video-unscaled"), PropertyChange::FillMode},
+        {QStringLiteral("keepaspect"), PropertyChange::FillMode},
+        {QStringLiteral("vid"), PropertyChange::ActiveVideoTrack},
+        {QStringLiteral("aid"), PropertyChange::ActiveAudioTrack},
+        {QStringLiteral("sid"), PropertyChange::ActiveSubtitleTrack}
+    };
+
+    // Observed all the time, whether anybody listens or not: the player itself
+    // depends on them, and none of them changes during a steady playback.
+    static inline const QStringList internalProperties =
     {
-        {QStringLiteral("dwidth"), {"videoSizeChanged"}},
-        {QStringLiteral("dheight"), {"videoSizeChanged"}},
-        {QStringLiteral("duration"), {"durationChanged"}},
-        {QStringLiteral("time-pos"), {"positionChanged"}},
-        {QStringLiteral("volume"), {"volumeChanged"}},
-        {QStringLiteral("mute"), {"muteChanged"}},
-        {QStringLiteral("seekable"), {"seekableChanged"}},
-        {QStringLiteral("hwdec"), {"hardwareDecodingChanged"}},
-        {QStringLiteral("video-out-params/aspect"), {"aspectRatioChanged"}},
-        {QStringLiteral("speed"), {"playbackRateChanged"}},
-        {QStringLiteral("filename"), {"fileNameChanged"}},
-        {QStringLiteral("screenshot-format"), {"snapshotFormatChanged"}},
-        {QStringLiteral("screenshot-template"), {"snapshotTemplateChanged"}},
-        {QStringLiteral("screenshot-directory"), {"snapshotDirectoryChanged"}},
-        {QStringLiteral("path"), {"filePathChanged"}},
-        {QStringLiteral("pause"), {"playbackStateChanged"}},
-        {QStringLiteral("idle-active"), {"playbackStateChanged"}},
-        {QStringLiteral("track-list"), {"mediaTracksChanged"}},
-        {QStringLiteral("chapter-list"), {"chaptersChanged"}},
-        {QStringLiteral("metadata"), {"metaDataChanged"}},
-        {QStringLiteral("video-unscaled"), {"fillModeChanged"}},
-        {QStringLiteral("keepaspect"), {"fillModeChanged"}},
-        {QStringLiteral("vid"), {"activeVideoTrackChanged"}},
-        {QStringLiteral("aid"), {"activeAudioTrackChanged"}},
-        {QStringLiteral("sid"), {"activeSubtitleTrackChanged"}}
+        QStringLiteral("pause"),
+        QStringLiteral("idle-active"),
+        QStringLiteral("dwidth"),
+        QStringLiteral("dheight"),
+        QStringLiteral("speed"),
+        QStringLiteral("play-direction")
     };
 
     // These properties are changing all the time during the playback process.
@@ -242,4 +303,20 @@ private:
     };
 };
 
+class MPVStreamSwitcher final : public StreamSwitcher
+{
+    Q_OBJECT
+#ifdef QML_NAMED_ELEMENT
+    QML_NAMED_ELEMENT(StreamSwitcher)
+#endif
+    Q_DISABLE_COPY_MOVE(MPVStreamSwitcher)
+
+public:
+    explicit MPVStreamSwitcher(QQuickItem *parent = nullptr);
+    ~MPVStreamSwitcher() override;
+
+protected:
+    Q_NODISCARD MediaPlayer *createPlayer() const override;
+};
+
 QTMEDIAPLAYER_END_NAMESPACE
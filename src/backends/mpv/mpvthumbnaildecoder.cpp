@@ -0,0 +1,211 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "mpvthumbnaildecoder.h"
+#include "mpvqthelper.h"
+#include "include/mpv/render.h"
+#include <QtCore/qdebug.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qthread.h>
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+// Network sources may take a while, but a stuck worker must not block the GUI forever.
+static constexpr const int kOpenTimeout = 10000;
+static constexpr const int kSeekTimeout = 5000;
+static constexpr const int kFrameTimeout = 1000;
+
+static const char kSoftwareFormat[] = "rgb0";
+
+MPVThumbnailDecoder::MPVThumbnailDecoder() = default;
+
+MPVThumbnailDecoder::~MPVThumbnailDecoder()
+{
+    // The render context must be released before the mpv instance.
+    if (m_renderContext) {
+        mpv_render_context_free(m_renderContext);
+        m_renderContext = nullptr;
+    }
+    if (m_mpv) {
+        mpv_terminate_destroy(m_mpv);
+        m_mpv = nullptr;
+    }
+}
+
+qint64 MPVThumbnailDecoder::open(const QUrl &url)
+{
+    Q_ASSERT(url.isValid());
+    if (!url.isValid()) {
+        return -1;
+    }
+    if (!MPV::Qt::isLibmpvAvailable()) {
+        qCWarning(lcQMPMPV) << "libmpv is not available.";
+        return -1;
+    }
+    m_mpv = mpv_create();
+    if (!m_mpv) {
+        qCWarning(lcQMPMPV) << "Failed to create the mpv instance for thumbnails.";
+        return -1;
+    }
+    // Only the video track is needed, and only its key frames most of the time.
+    static const std::pair<const char *, const char *> options[] = {
+        {"vo", "libmpv"},
+        {"hwdec", "no"},
+        {"aid", "no"},
+        {"sid", "no"},
+        {"pause", "yes"},
+        {"keep-open", "always"},
+        {"load-scripts", "no"},
+        {"ytdl", "no"},
+        {"osc", "no"},
+        {"cache", "no"},
+        {"vd-lavc-fast", "yes"},
+        {"vd-lavc-skiploopfilter", "all"},
+        {"vd-lavc-threads", "1"},
+        {"audio-display", "no"},
+        {"terminal", "no"}
+    };
+    for (auto &&option : options) {
+        if (mpv_set_option_string(m_mpv, option.first, option.second) < 0) {
+            qCWarning(lcQMPMPV) << "Failed to set" << option.first << "to" << option.second;
+        }
+    }
+    if (mpv_initialize(m_mpv) < 0) {
+        qCWarning(lcQMPMPV) << "Failed to initialize the mpv instance for thumbnails.";
+        return -1;
+    }
+    mpv_render_param params[] = {
+        {MPV_RENDER_PARAM_API_TYPE, const_cast<char *>(MPV_RENDER_API_TYPE_SW)},
+        {MPV_RENDER_PARAM_INVALID, nullptr}
+    };
+    if (mpv_render_context_create(&m_renderContext, m_mpv, params) < 0) {
+        qCWarning(lcQMPMPV) << "Failed to create the software render context, libmpv may be too old.";
+        m_renderContext = nullptr;
+        return -1;
+    }
+    const QString path = (url.isLocalFile() ? QDir::toNativeSeparators(url.toLocalFile()) : url.toString());
+    if (MPV::Qt::is_error(MPV::Qt::command(m_mpv, QStringList{QStringLiteral("loadfile"), path}))) {
+        qCWarning(lcQMPMPV) << "Failed to load" << path << "for thumbnails.";
+        return -1;
+    }
+    if (!waitForEvent(MPV_EVENT_FILE_LOADED, kOpenTimeout)) {
+        qCWarning(lcQMPMPV) << "Timed out while loading" << path << "for thumbnails.";
+        return -1;
+    }
+    const QVariant duration = MPV::Qt::get_property(m_mpv, QStringLiteral("duration"));
+    if (MPV::Qt::is_error(duration)) {
+        return -1;
+    }
+    return qRound64(duration.toReal() * 1000.0);
+}
+
+QImage MPVThumbnailDecoder::decode(const qint64 position, const bool accurate, const QSize &size, qint64 *timestamp)
+{
+    Q_ASSERT(m_mpv);
+    Q_ASSERT(m_renderContext);
+    Q_ASSERT(!size.isEmpty());
+    if (timestamp) {
+        *timestamp = -1;
+    }
+    if (!m_mpv || !m_renderContext || size.isEmpty()) {
+        return {};
+    }
+    const QStringList command = {QStringLiteral("seek"), QString::number(qreal(position) / 1000.0, 'f', 3),
+        (accurate ? QStringLiteral("absolute+exact") : QStringLiteral("absolute+keyframes"))};
+    if (MPV::Qt::is_error(MPV::Qt::command(m_mpv, command))) {
+        return {};
+    }
+    if (!waitForEvent(MPV_EVENT_PLAYBACK_RESTART, kSeekTimeout)) {
+        qCDebug(lcQMPMPV) << "Timed out while seeking to" << position << "for a thumbnail.";
+        return {};
+    }
+    // The new frame reaches the renderer slightly after the seek has finished.
+    QElapsedTimer timer;
+    timer.start();
+    while (!(mpv_render_context_update(m_renderContext) & MPV_RENDER_UPDATE_FRAME)) {
+        if (timer.hasExpired(kFrameTimeout)) {
+            break;
+        }
+        QThread::msleep(2);
+    }
+    QImage image(size, QImage::Format_RGBX8888);
+    image.fill(Qt::black);
+    int softwareSize[2] = {image.width(), image.height()};
+    size_t softwareStride = image.bytesPerLine();
+    mpv_render_param params[] = {
+        {MPV_RENDER_PARAM_SW_SIZE, softwareSize},
+        {MPV_RENDER_PARAM_SW_FORMAT, const_cast<char *>(kSoftwareFormat)},
+        {MPV_RENDER_PARAM_SW_STRIDE, &softwareStride},
+        {MPV_RENDER_PARAM_SW_POINTER, image.bits()},
+        {MPV_RENDER_PARAM_INVALID, nullptr}
+    };
+    if (mpv_render_context_render(m_renderContext, params) < 0) {
+        return {};
+    }
+    if (timestamp) {
+        // The instance is paused, so the playback position is the time of the rendered frame.
+        const QVariant framePosition = MPV::Qt::get_property(m_mpv, QStringLiteral("time-pos"));
+        if (!MPV::Qt::is_error(framePosition)) {
+            *timestamp = qRound64(framePosition.toReal() * 1000.0);
+        }
+    }
+    return image;
+}
+
+bool MPVThumbnailDecoder::waitForEvent(const int event, const int timeout)
+{
+    Q_ASSERT(m_mpv);
+    if (!m_mpv) {
+        return false;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    while (!timer.hasExpired(timeout)) {
+        const mpv_event * const e = mpv_wait_event(m_mpv, qreal(timeout - timer.elapsed()) / 1000.0);
+        if (!e || (e->event_id == MPV_EVENT_NONE)) {
+            continue;
+        }
+        if (e->event_id == event) {
+            return true;
+        }
+        if ((e->event_id == MPV_EVENT_END_FILE) || (e->event_id == MPV_EVENT_SHUTDOWN)) {
+            return false;
+        }
+    }
+    return false;
+}
+
+MPVThumbnailIndex::MPVThumbnailIndex(QQuickItem *parent) : ThumbnailIndex(parent)
+{
+}
+
+MPVThumbnailIndex::~MPVThumbnailIndex() = default;
+
+ThumbnailDecoder *MPVThumbnailIndex::createDecoder() const
+{
+    return new MPVThumbnailDecoder;
+}
+
+QTMEDIAPLAYER_END_NAMESPACE
@@ -0,0 +1,72 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "mpvbackend_global.h"
+#include "../../common/thumbnailindex.h"
+
+struct mpv_handle;
+struct mpv_render_context;
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+// A headless mpv instance which renders single frames with the software renderer.
+class MPVThumbnailDecoder final : public ThumbnailDecoder
+{
+    Q_DISABLE_COPY_MOVE(MPVThumbnailDecoder)
+
+public:
+    explicit MPVThumbnailDecoder();
+    ~MPVThumbnailDecoder() override;
+
+    Q_NODISCARD qint64 open(const QUrl &url) override;
+    Q_NODISCARD QImage decode(const qint64 position, const bool accurate, const QSize &size,
+                              qint64 *timestamp = nullptr) override;
+
+private:
+    Q_NODISCARD bool waitForEvent(const int event, const int timeout);
+
+private:
+    mpv_handle *m_mpv = nullptr;
+    mpv_render_context *m_renderContext = nullptr;
+};
+
+class MPVThumbnailIndex final : public ThumbnailIndex
+{
+    Q_OBJECT
+#ifdef QML_NAMED_ELEMENT
+    QML_NAMED_ELEMENT(ThumbnailIndex)
+#endif
+    Q_DISABLE_COPY_MOVE(MPVThumbnailIndex)
+
+public:
+    explicit MPVThumbnailIndex(QQuickItem *parent = nullptr);
+    ~MPVThumbnailIndex() override;
+
+protected:
+    Q_NODISCARD ThumbnailDecoder *createDecoder() const override;
+};
+
+QTMEDIAPLAYER_END_NAMESPACE
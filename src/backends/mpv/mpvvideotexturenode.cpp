@@ -77,6 +77,8 @@ MPVVideoTextureNode::MPVVideoTextureNode(QQuickItem *item) : VideoTextureNode(it
     m_item = static_cast<MPVPlayer *>(item);
     m_window = m_item->window();
     connect(m_window, &QQuickWindow::beforeRendering, this, &MPVVideoTextureNode::render);
+    // Both signals are emitted on the render thread.
+    connect(m_window, &QQuickWindow::frameSwapped, this, &MPVVideoTextureNode::reportSwap, Qt::DirectConnection);
     connect(m_window, &QQuickWindow::screenChanged, this, [this](QScreen *screen){
         Q_UNUSED(screen);
         m_item->update();
@@ -99,6 +101,7 @@ void MPVVideoTextureNode::sync()
     if (!m_item || !m_window) {
         return;
     }
+    m_renderingEnabled = m_item->renderingEnabled();
     // effectiveDevicePixelRatio() will always give the correct result even if QQuickWindow is not available.
     const auto dpr = m_window->effectiveDevicePixelRatio();
 #if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
@@ -145,18 +148,44 @@ void MPVVideoTextureNode::render()
         return;
     }
 
-#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
-    QQuickOpenGLUtils::resetOpenGLState();
-#else
-    m_window->resetOpenGLState();
-#endif
-
     mpv_opengl_fbo mpvFBO = {};
     mpvFBO.fbo = static_cast<int>(fbo_gl->handle());
     mpvFBO.w = fbo_gl->width();
     mpvFBO.h = fbo_gl->height();
     mpvFBO.internal_format = 0;
 
+    // Nothing new to show, the texture keeps the last frame. A standby player
+    // may still be playing though, and mpv waits for every frame to be rendered
+    // before it queues the next one: let it drop them without drawing anything.
+    if (!m_renderingEnabled) {
+        if (mpv_render_context_update(m_item->m_mpv_gl) & MPV_RENDER_UPDATE_FRAME) {
+            int skip = 1;
+            mpv_render_param skipParams[] =
+            {
+                {
+                    MPV_RENDER_PARAM_OPENGL_FBO,
+                    &mpvFBO
+                },
+                {
+                    MPV_RENDER_PARAM_SKIP_RENDERING,
+                    &skip
+                },
+                {
+                    MPV_RENDER_PARAM_INVALID,
+                    nullptr
+                }
+            };
+            mpv_render_context_render(m_item->m_mpv_gl, skipParams);
+        }
+        return;
+    }
+
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+    QQuickOpenGLUtils::resetOpenGLState();
+#else
+    m_window->resetOpenGLState();
+#endif
+
     mpv_render_param params[] =
     {
         // Specify the default framebuffer (0) as target. This will
@@ -172,9 +201,15 @@ void MPVVideoTextureNode::render()
             nullptr
         }
     };
+    // Ask before rendering, the flag tells us whether a real video frame is drawn this time.
+    const bool hasNewFrame = (mpv_render_context_update(m_item->m_mpv_gl) & MPV_RENDER_UPDATE_FRAME);
     // See render_gl.h on what OpenGL environment mpv expects, and
     // other API details.
     mpv_render_context_render(m_item->m_mpv_gl, params);
+    if (hasNewFrame) {
+        m_item->reportFirstFrame();
+    }
+    m_swapPending = true;
 
 #if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
     QQuickOpenGLUtils::resetOpenGLState();
@@ -183,6 +218,21 @@ void MPVVideoTextureNode::render()
 #endif
 }
 
+// mpv's frame timing (and all the display-* video sync modes) needs to know when
+// the rendered frame actually reached the screen. Only report the swaps of frames
+// we have rendered into, the window may also swap because of other items.
+void MPVVideoTextureNode::reportSwap()
+{
+    if (!m_swapPending) {
+        return;
+    }
+    m_swapPending = false;
+    if (!m_item || !m_item->m_mpv_gl) {
+        return;
+    }
+    mpv_render_context_report_swap(m_item->m_mpv_gl);
+}
+
 QSGTexture* MPVVideoTextureNode::ensureTexture(void *player, const QSize &size)
 {
     Q_UNUSED(player);
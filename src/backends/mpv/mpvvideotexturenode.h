@@ -50,6 +50,9 @@ public:
 protected Q_SLOTS:
     void render() override;
 
+private Q_SLOTS:
+    void reportSwap();
+
 protected:
     Q_NODISCARD QSGTexture *ensureTexture(void *player, const QSize &size) override;
 
@@ -60,6 +63,8 @@ private:
     QQuickWindow *m_window = nullptr;
     MPVPlayer *m_item = nullptr;
     QSize m_size = {};
+    bool m_swapPending = false;
+    bool m_renderingEnabled = true; // Copied from the item while syncing.
 };
 
 QTMEDIAPLAYER_END_NAMESPACE
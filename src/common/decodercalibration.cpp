@@ -0,0 +1,322 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "decodercalibration.h"
+#include "mediacache.h"
+#include "resourcegovernor.h"
+#include <QtCore/qdebug.h>
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qthread.h>
+#include <QtCore/qtimer.h>
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+Q_LOGGING_CATEGORY(lcQMPCalibration, "wangwenx190.qtmediaplayer.calibration")
+
+Q_GLOBAL_STATIC(DecoderCalibration, decoderCalibration)
+
+// A few seconds of a typical video, enough to amortize opening the media.
+static constexpr const int kCalibrationFrameCount = 240;
+
+// Decoded once before the measurements, so that none of the candidates pays
+// for reading the media into the page cache.
+static constexpr const int kWarmUpFrameCount = 24;
+
+// Configurations this close to the fastest one (relative) are considered as
+// fast, the backend's default one wins among them.
+static constexpr const qreal kFpsTolerance = 0.05;
+
+// How often a deferred calibration checks whether the players are idle now.
+static constexpr const int kDeferInterval = 5000;
+
+[[nodiscard]] static inline QString calibrationFilePath()
+{
+    const QString directory = Cache::directoryPath(QStringLiteral("calibration"));
+    if (directory.isEmpty()) {
+        return {};
+    }
+    return (directory + QStringLiteral("/decoders.json"));
+}
+
+[[nodiscard]] static inline QList<DecoderBenchmark> runBenchmarks(DecoderBenchmarker *benchmarker,
+                                                                  const QString &codec, const QUrl &url)
+{
+    Q_ASSERT(benchmarker);
+    if (!benchmarker) {
+        return {};
+    }
+    const QList<DecoderConfig> candidates = benchmarker->candidates(codec);
+    if (candidates.isEmpty() || (benchmarker->decode(url, candidates.constFirst(), kWarmUpFrameCount) <= 0)) {
+        return {};
+    }
+    QList<DecoderBenchmark> results = {};
+    for (auto &&config : qAsConst(candidates)) {
+        QElapsedTimer timer;
+        timer.start();
+        const int frames = benchmarker->decode(url, config, kCalibrationFrameCount);
+        const qint64 elapsed = timer.nsecsElapsed();
+        if ((frames <= 0) || (elapsed <= 0)) {
+            qCDebug(lcQMPCalibration) << "Decoder" << config.decoder << "doesn't work for" << codec;
+            continue;
+        }
+        DecoderBenchmark result = {};
+        result.config = config;
+        result.fps = (qreal(frames) * 1000000000.0 / qreal(elapsed));
+        qCDebug(lcQMPCalibration) << codec << "with" << config.decoder << (config.sliceThreads ? "(slice threads):" : "(frame threads):")
+                                  << result.fps << "fps.";
+        results.append(result);
+    }
+    return results;
+}
+
+DecoderCalibration::DecoderCalibration(QObject *parent) : QObject(parent)
+{
+    m_deferTimer = new QTimer(this);
+    m_deferTimer->setSingleShot(true);
+    m_deferTimer->setInterval(kDeferInterval);
+    connect(m_deferTimer, &QTimer::timeout, this, &DecoderCalibration::startNext);
+}
+
+DecoderCalibration::~DecoderCalibration()
+{
+    m_queue.clear();
+    if (m_thread) {
+        // Every decode has a timeout, this doesn't block forever.
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+}
+
+DecoderCalibration *DecoderCalibration::instance()
+{
+    return decoderCalibration();
+}
+
+bool DecoderCalibration::bestConfig(const QString &backendName, const QString &backendVersion,
+                                    const QString &codec, DecoderConfig *config)
+{
+    Q_ASSERT(!backendName.isEmpty());
+    Q_ASSERT(!codec.isEmpty());
+    Q_ASSERT(config);
+    if (backendName.isEmpty() || codec.isEmpty() || !config) {
+        return false;
+    }
+    load();
+    if (m_versions.value(backendName) != backendVersion) {
+        return false;
+    }
+    const QHash<QString, DecoderBenchmark> results = m_results.value(backendName);
+    const auto it = results.constFind(codec);
+    if (it == results.constEnd()) {
+        return false;
+    }
+    *config = it->config;
+    return true;
+}
+
+QHash<QString, DecoderConfig> DecoderCalibration::bestConfigs(const QString &backendName, const QString &backendVersion)
+{
+    Q_ASSERT(!backendName.isEmpty());
+    if (backendName.isEmpty()) {
+        return {};
+    }
+    load();
+    if (m_versions.value(backendName) != backendVersion) {
+        return {};
+    }
+    QHash<QString, DecoderConfig> result = {};
+    const QHash<QString, DecoderBenchmark> results = m_results.value(backendName);
+    for (auto it = results.constBegin(); it != results.constEnd(); ++it) {
+        result.insert(it.key(), it->config);
+    }
+    return result;
+}
+
+void DecoderCalibration::calibrate(const QString &backendName, const QString &backendVersion,
+                                   const QString &codec, const QUrl &url, DecoderBenchmarker *benchmarker)
+{
+    Q_ASSERT(benchmarker);
+    // The benchmarker is ours from now on, whatever happens.
+    const QSharedPointer<DecoderBenchmarker> guard(benchmarker);
+    Q_ASSERT(!backendName.isEmpty());
+    Q_ASSERT(!codec.isEmpty());
+    Q_ASSERT(url.isValid());
+    if (!benchmarker || backendName.isEmpty() || codec.isEmpty() || !url.isValid()) {
+        return;
+    }
+    // Network sources measure the network, not the decoders.
+    if (!url.isLocalFile()) {
+        return;
+    }
+    DecoderConfig config = {};
+    if (bestConfig(backendName, backendVersion, codec, &config)) {
+        return;
+    }
+    const QString key = (backendName + u'/' + codec);
+    if (m_pending.contains(key)) {
+        return;
+    }
+    m_pending.insert(key);
+    m_queue.append({backendName, backendVersion, codec, url, guard});
+    startNext();
+}
+
+void DecoderCalibration::startNext()
+{
+    if (m_thread || m_queue.isEmpty()) {
+        return;
+    }
+    const ResourceGovernor * const governor = ResourceGovernor::instance();
+    if (governor && governor->isAnyPlayerDecoding()) {
+        if (!m_deferTimer->isActive()) {
+            m_deferTimer->start();
+        }
+        return;
+    }
+    const Job job = m_queue.takeFirst();
+    qCDebug(lcQMPCalibration) << "Calibrating the decoders of" << job.codec << "for" << job.backendName << "with" << job.url;
+    m_thread = QThread::create([job](){
+        const QList<DecoderBenchmark> results = runBenchmarks(job.benchmarker.data(), job.codec, job.url);
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [job, results](){
+            if (DecoderCalibration * const calibration = instance()) {
+                calibration->store(job.backendName, job.backendVersion, job.codec, results);
+            }
+        }, Qt::QueuedConnection);
+    });
+    connect(m_thread, &QThread::finished, this, [this](){
+        m_thread->deleteLater();
+        m_thread = nullptr;
+        startNext();
+    });
+    // Players may start while it runs, the measuring thread must not get in their way.
+    m_thread->start(QThread::LowestPriority);
+}
+
+void DecoderCalibration::store(const QString &backendName, const QString &backendVersion,
+                               const QString &codec, const QList<DecoderBenchmark> &results)
+{
+    m_pending.remove(backendName + u'/' + codec);
+    if (results.isEmpty()) {
+        // Probably the media, not the decoders. The next one will try again.
+        qCWarning(lcQMPCalibration) << "Failed to calibrate the decoders of" << codec << "for" << backendName;
+        return;
+    }
+    qreal fastest = 0.0;
+    for (auto &&result : qAsConst(results)) {
+        fastest = qMax(fastest, result.fps);
+    }
+    // The results are in the order of the candidates, the backend's default first:
+    // a measurably faster configuration is needed to replace it.
+    const qreal threshold = (fastest * (1.0 - kFpsTolerance));
+    DecoderBenchmark best = results.constFirst();
+    for (auto &&result : qAsConst(results)) {
+        if (result.fps >= threshold) {
+            best = result;
+            break;
+        }
+    }
+    if (m_versions.value(backendName) != backendVersion) {
+        m_versions.insert(backendName, backendVersion);
+        m_results.remove(backendName);
+    }
+    m_results[backendName].insert(codec, best);
+    qCDebug(lcQMPCalibration) << "Best decoder of" << codec << "for" << backendName << "-->" << best.config.decoder
+                              << (best.config.sliceThreads ? "(slice threads)" : "(frame threads)");
+    save();
+    Q_EMIT calibrated(backendName, codec);
+}
+
+void DecoderCalibration::load()
+{
+    if (m_loaded) {
+        return;
+    }
+    m_loaded = true;
+    const QString filePath = calibrationFilePath();
+    if (filePath.isEmpty()) {
+        return;
+    }
+    QFile file(filePath);
+    if (!file.exists()) {
+        return;
+    }
+    if (!file.open(QFile::ReadOnly)) {
+        qCWarning(lcQMPCalibration) << "Failed to open" << filePath << "for reading:" << file.errorString();
+        return;
+    }
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    for (auto it = root.constBegin(); it != root.constEnd(); ++it) {
+        const QJsonObject backend = it.value().toObject();
+        m_versions.insert(it.key(), backend.value(QStringLiteral("version")).toString());
+        const QJsonObject codecs = backend.value(QStringLiteral("codecs")).toObject();
+        QHash<QString, DecoderBenchmark> results = {};
+        for (auto codec = codecs.constBegin(); codec != codecs.constEnd(); ++codec) {
+            const QJsonObject object = codec.value().toObject();
+            DecoderBenchmark result = {};
+            result.config.decoder = object.value(QStringLiteral("decoder")).toString();
+            result.config.sliceThreads = object.value(QStringLiteral("sliceThreads")).toBool();
+            result.fps = object.value(QStringLiteral("fps")).toDouble();
+            if (!result.config.decoder.isEmpty()) {
+                results.insert(codec.key(), result);
+            }
+        }
+        m_results.insert(it.key(), results);
+    }
+}
+
+void DecoderCalibration::save() const
+{
+    const QString filePath = calibrationFilePath();
+    if (filePath.isEmpty()) {
+        return;
+    }
+    QJsonObject root = {};
+    for (auto it = m_results.constBegin(); it != m_results.constEnd(); ++it) {
+        QJsonObject codecs = {};
+        for (auto codec = it->constBegin(); codec != it->constEnd(); ++codec) {
+            codecs.insert(codec.key(), QJsonObject{
+                {QStringLiteral("decoder"), codec->config.decoder},
+                {QStringLiteral("sliceThreads"), codec->config.sliceThreads},
+                {QStringLiteral("fps"), codec->fps}
+            });
+        }
+        root.insert(it.key(), QJsonObject{
+            {QStringLiteral("version"), m_versions.value(it.key())},
+            {QStringLiteral("codecs"), codecs}
+        });
+    }
+    QFile file(filePath);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+        qCWarning(lcQMPCalibration) << "Failed to open" << filePath << "for writing:" << file.errorString();
+        return;
+    }
+    file.write(QJsonDocument(root).toJson());
+}
+
+QTMEDIAPLAYER_END_NAMESPACE
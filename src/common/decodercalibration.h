@@ -0,0 +1,138 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "../loader/qtmediaplayer_global.h"
+#include <QtCore/qobject.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qset.h>
+#include <QtCore/qurl.h>
+#include <QtCore/qsharedpointer.h>
+
+QT_BEGIN_NAMESPACE
+QT_FORWARD_DECLARE_CLASS(QThread)
+QT_FORWARD_DECLARE_CLASS(QTimer)
+QT_END_NAMESPACE
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(lcQMPCalibration)
+
+// One way of decoding a codec in software.
+struct DecoderConfig
+{
+    QString decoder = {};      // Backend specific name of the decoder implementation.
+    bool sliceThreads = false; // Slice threading instead of frame threading.
+};
+
+struct DecoderBenchmark
+{
+    DecoderConfig config = {};
+    qreal fps = 0.0; // Frames delivered by the decoder per second, untimed.
+};
+
+// Decodes the beginning of a media as fast as possible with a given decoder
+// configuration. Every backend provides its own implementation. All functions
+// are called on a worker thread.
+class DecoderBenchmarker
+{
+    Q_DISABLE_COPY_MOVE(DecoderBenchmarker)
+
+public:
+    explicit DecoderBenchmarker() = default;
+    virtual ~DecoderBenchmarker() = default;
+
+    // The software decoder configurations worth trying for the given codec,
+    // the backend's default one first.
+    Q_NODISCARD virtual QList<DecoderConfig> candidates(const QString &codec) = 0;
+
+    // Decodes at most "frameCount" frames, returns how many the decoder actually
+    // delivered. Zero means the configuration doesn't work for this media at all.
+    Q_NODISCARD virtual int decode(const QUrl &url, const DecoderConfig &config, const int frameCount) = 0;
+};
+
+// The fastest software decoder configuration per codec differs between machines
+// and builds, so it's measured once: the first local media of every codec is
+// decoded untimed with every candidate on a low priority thread, and the results
+// are kept in the disk cache. They become stale with another version of the
+// backend. The measurements wait until no player is playing, so that they don't
+// compete with the playback (and the playback doesn't skew them). Lives on the
+// GUI thread.
+class DecoderCalibration : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY_MOVE(DecoderCalibration)
+
+public:
+    explicit DecoderCalibration(QObject *parent = nullptr);
+    ~DecoderCalibration() override;
+
+    // Null once the application is shutting down.
+    Q_NODISCARD static DecoderCalibration *instance();
+
+    // False if the codec wasn't calibrated for this backend yet.
+    Q_NODISCARD bool bestConfig(const QString &backendName, const QString &backendVersion,
+                                const QString &codec, DecoderConfig *config);
+
+    // Codec --> fastest configuration, for all the codecs calibrated for this backend.
+    Q_NODISCARD QHash<QString, DecoderConfig> bestConfigs(const QString &backendName, const QString &backendVersion);
+
+    // Calibrates the codec with the given media, unless it's calibrated or being
+    // calibrated already. Only local files are used. Takes the ownership of the
+    // benchmarker.
+    void calibrate(const QString &backendName, const QString &backendVersion,
+                   const QString &codec, const QUrl &url, DecoderBenchmarker *benchmarker);
+
+Q_SIGNALS:
+    void calibrated(const QString &backendName, const QString &codec);
+
+private:
+    struct Job
+    {
+        QString backendName = {};
+        QString backendVersion = {};
+        QString codec = {};
+        QUrl url = {};
+        QSharedPointer<DecoderBenchmarker> benchmarker = nullptr;
+    };
+
+    void load();
+    void save() const;
+    void startNext();
+    void store(const QString &backendName, const QString &backendVersion,
+               const QString &codec, const QList<DecoderBenchmark> &results);
+
+private:
+    bool m_loaded = false;
+    // Backend name --> backend version and codec --> fastest configuration.
+    QHash<QString, QString> m_versions = {};
+    QHash<QString, QHash<QString, DecoderBenchmark>> m_results = {};
+    QSet<QString> m_pending = {};
+    QList<Job> m_queue = {};
+    QThread *m_thread = nullptr;
+    QTimer *m_deferTimer = nullptr;
+};
+
+QTMEDIAPLAYER_END_NAMESPACE
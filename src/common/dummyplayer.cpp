@@ -332,9 +332,19 @@ void DummyPlayer::stop()
 {
 }
 
-void DummyPlayer::seek(const qint64 value)
+bool DummyPlayer::doSeek(const qint64 value, const bool exact)
 {
     Q_UNUSED(value);
+    Q_UNUSED(exact);
+    return false;
+}
+
+void DummyPlayer::stepForward()
+{
+}
+
+void DummyPlayer::stepBackward()
+{
 }
 
 void DummyPlayer::snapshot()
@@ -127,7 +127,8 @@ public Q_SLOTS:
     void play() override;
     void pause() override;
     void stop() override;
-    void seek(const qint64 value) override;
+    void stepForward() override;
+    void stepBackward() override;
     void snapshot() override;
 
 public:
@@ -135,6 +136,9 @@ public:
     Q_NODISCARD Q_INVOKABLE bool isPlaying() const override;
     Q_NODISCARD Q_INVOKABLE bool isPaused() const override;
     Q_NODISCARD Q_INVOKABLE bool isStopped() const override;
+
+protected:
+    bool doSeek(const qint64 value, const bool exact) override;
 };
 
 QTMEDIAPLAYER_END_NAMESPACE
@@ -0,0 +1,266 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "framebackcache.h"
+#include "thumbnailindex.h"
+#include "playerinterface.h"
+#include <QtCore/qdebug.h>
+#include <QtCore/qthread.h>
+#include <QtCore/qscopedpointer.h>
+#include <algorithm>
+#include <limits>
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+// How many frames a GOP walk may decode beyond the requested ones, in case the
+// decoder delivers frames which are not in the index (or none with a timestamp).
+static constexpr const int kMaxExtraFrames = 8;
+
+// Used when a GOP has a single frame and the spacing can't be told.
+static constexpr const qint64 kDefaultMatchTolerance = 20;
+
+// Half the smallest distance between two frames of the GOP.
+[[nodiscard]] static inline qint64 matchTolerance(const QVector<qint64> &frames)
+{
+    if (frames.size() < 2) {
+        return kDefaultMatchTolerance;
+    }
+    QVector<qint64> sorted = frames;
+    std::sort(sorted.begin(), sorted.end());
+    qint64 spacing = std::numeric_limits<qint64>::max();
+    for (int i = 1; i != sorted.size(); ++i) {
+        if (sorted.at(i) > sorted.at(i - 1)) {
+            spacing = qMin(spacing, sorted.at(i) - sorted.at(i - 1));
+        }
+    }
+    if (spacing == std::numeric_limits<qint64>::max()) {
+        return kDefaultMatchTolerance;
+    }
+    return qMax(qint64(1), spacing / 2);
+}
+
+// Returns the requested frame the decoded timestamp belongs to, or -1.
+[[nodiscard]] static inline qint64 matchFrame(const QVector<qint64> &frames, const qint64 timestamp, const qint64 tolerance)
+{
+    if (timestamp < 0) {
+        return -1;
+    }
+    qint64 result = -1;
+    qint64 distance = tolerance;
+    for (auto &&frame : qAsConst(frames)) {
+        const qint64 difference = qAbs(frame - timestamp);
+        if (difference <= distance) {
+            result = frame;
+            distance = difference;
+        }
+    }
+    return result;
+}
+
+FrameBackCache::FrameBackCache(const DecoderFactory &factory, QObject *parent) : QObject(parent), m_factory(factory)
+{
+    Q_ASSERT(m_factory);
+}
+
+FrameBackCache::~FrameBackCache()
+{
+    close();
+}
+
+void FrameBackCache::open(const QUrl &url)
+{
+    // Only the GUI thread ever changes the URL.
+    if (m_thread && (url == m_url)) {
+        return;
+    }
+    close();
+    if (!url.isValid() || !m_factory) {
+        return;
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        m_url = url;
+        m_stopRequested = false;
+    }
+    m_thread = QThread::create([this](){
+        run();
+    });
+    // Never compete with the actual playback.
+    m_thread->start(QThread::LowPriority);
+}
+
+void FrameBackCache::close()
+{
+    if (m_thread) {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_stopRequested = true;
+            m_condition.wakeAll();
+        }
+        // Blocks until the frame being decoded right now is done.
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    QMutexLocker locker(&m_mutex);
+    m_url.clear();
+    m_requests.clear();
+    m_frames.clear();
+    m_bytes = 0;
+}
+
+void FrameBackCache::setMemoryLimit(const int value)
+{
+    Q_ASSERT(value > 0);
+    if (value <= 0) {
+        return;
+    }
+    QMutexLocker locker(&m_mutex);
+    m_memoryLimit = (qint64(value) * 1024 * 1024);
+}
+
+void FrameBackCache::setFrameSize(const QSize &value)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_frameSize == value) {
+        return;
+    }
+    m_frameSize = value;
+    // Frames of the old size would look blurry or waste memory.
+    m_frames.clear();
+    m_bytes = 0;
+}
+
+void FrameBackCache::request(const QVector<qint64> &frames)
+{
+    if (frames.isEmpty()) {
+        return;
+    }
+    QMutexLocker locker(&m_mutex);
+    m_requests.removeAll(frames);
+    m_requests.append(frames);
+    m_focus = frames.constLast();
+    m_condition.wakeAll();
+}
+
+qint64 FrameBackCache::memoryUsage() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_bytes;
+}
+
+bool FrameBackCache::contains(const qint64 timestamp) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_frames.contains(timestamp);
+}
+
+QImage FrameBackCache::frame(const qint64 timestamp) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_frames.value(timestamp);
+}
+
+void FrameBackCache::run()
+{
+    const QScopedPointer<ThumbnailDecoder> decoder(m_factory());
+    QUrl url = {};
+    {
+        QMutexLocker locker(&m_mutex);
+        url = m_url;
+    }
+    if (!decoder || (decoder->open(url) < 0)) {
+        qCWarning(lcQMPPlayer) << "Failed to open" << url << "for the frame back cache.";
+        return;
+    }
+    while (true) {
+        QVector<qint64> frames = {};
+        QSize size = {};
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_stopRequested && m_requests.isEmpty()) {
+                m_condition.wait(&m_mutex);
+            }
+            if (m_stopRequested) {
+                return;
+            }
+            frames = m_requests.takeLast();
+            size = m_frameSize;
+            const bool complete = std::all_of(frames.cbegin(), frames.cend(), [this](const qint64 timestamp){
+                return m_frames.contains(timestamp);
+            });
+            if (complete || size.isEmpty()) {
+                continue;
+            }
+        }
+        const qint64 tolerance = matchTolerance(frames);
+        const qint64 lastFrame = *std::max_element(frames.cbegin(), frames.cend());
+        // Seek once, then walk through the GOP frame by frame. Decoders may skip or
+        // repeat frames, so each image is keyed by its presentation time, never by
+        // its position in the sequence.
+        qint64 timestamp = -1;
+        QImage image = decoder->decode(frames.constFirst(), true, size, &timestamp);
+        for (int i = 0; !image.isNull(); ) {
+            const qint64 frame = matchFrame(frames, timestamp, tolerance);
+            if (frame >= 0) {
+                store(frame, image);
+            } else {
+                qCDebug(lcQMPPlayer) << "Discarded a decoded frame at" << timestamp << "which is not part of the requested GOP.";
+            }
+            if ((timestamp >= (lastFrame - tolerance)) || (++i >= (frames.size() + kMaxExtraFrames))) {
+                break;
+            }
+            {
+                QMutexLocker locker(&m_mutex);
+                if (m_stopRequested) {
+                    return;
+                }
+                if (m_frameSize != size) {
+                    break;
+                }
+            }
+            image = decoder->decodeNext(size, &timestamp);
+        }
+        Q_EMIT framesAdded();
+    }
+}
+
+void FrameBackCache::store(const qint64 timestamp, const QImage &image)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_frames.contains(timestamp)) {
+        m_bytes -= m_frames.value(timestamp).sizeInBytes();
+    }
+    m_frames.insert(timestamp, image);
+    m_bytes += image.sizeInBytes();
+    while ((m_bytes > m_memoryLimit) && !m_frames.isEmpty()) {
+        // Both ends of the map are the candidates, drop the one further away.
+        const auto victim = ((qAbs(m_frames.firstKey() - m_focus) > qAbs(m_frames.lastKey() - m_focus))
+                                 ? m_frames.begin() : std::prev(m_frames.end()));
+        m_bytes -= victim.value().sizeInBytes();
+        m_frames.erase(victim);
+    }
+}
+
+QTMEDIAPLAYER_END_NAMESPACE
@@ -0,0 +1,103 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "../loader/qtmediaplayer_global.h"
+#include <QtCore/qobject.h>
+#include <QtCore/qurl.h>
+#include <QtCore/qmap.h>
+#include <QtCore/qvector.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qwaitcondition.h>
+#include <QtGui/qimage.h>
+#include <functional>
+
+QT_BEGIN_NAMESPACE
+QT_FORWARD_DECLARE_CLASS(QThread)
+QT_END_NAMESPACE
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+class ThumbnailDecoder;
+
+// Decoded frames around the current position, for stepping and playing backwards
+// without decoding the whole GOP again for every single frame. Each requested GOP
+// is decoded once, forwards from its key frame, on a worker thread with its own
+// decoder. The most recent request is served first, so asking for the current GOP
+// and then the one before fills the cache in reverse order.
+class FrameBackCache : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY_MOVE(FrameBackCache)
+
+public:
+    using DecoderFactory = std::function<ThumbnailDecoder *()>;
+
+    explicit FrameBackCache(const DecoderFactory &factory, QObject *parent = nullptr);
+    ~FrameBackCache() override;
+
+    // Drops everything cached so far.
+    void open(const QUrl &url);
+    void close();
+
+    // In megabytes. Frames furthest away from the latest request are dropped first.
+    void setMemoryLimit(const int value);
+
+    void setFrameSize(const QSize &value);
+
+    // Timestamps (in milliseconds) of all frames of a GOP, starting with its key frame.
+    void request(const QVector<qint64> &frames);
+
+    // Bytes held by the cached frames.
+    Q_NODISCARD qint64 memoryUsage() const;
+
+    Q_NODISCARD bool contains(const qint64 timestamp) const;
+    Q_NODISCARD QImage frame(const qint64 timestamp) const;
+
+Q_SIGNALS:
+    // Emitted on the worker thread.
+    void framesAdded();
+
+private:
+    void run();
+    void store(const qint64 timestamp, const QImage &image);
+
+private:
+    const DecoderFactory m_factory = nullptr;
+    QThread *m_thread = nullptr;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_condition;
+    QUrl m_url = {};
+    QSize m_frameSize = {};
+    QList<QVector<qint64>> m_requests = {};
+    QMap<qint64, QImage> m_frames = {};
+    qint64 m_bytes = 0;
+    qint64 m_memoryLimit = 256 * 1024 * 1024;
+    qint64 m_focus = 0;
+    bool m_stopRequested = false;
+};
+
+QTMEDIAPLAYER_END_NAMESPACE
@@ -0,0 +1,755 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "keyframeindex.h"
+#include "mediacache.h"
+#include <QtCore/qdebug.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qsavefile.h>
+#include <QtCore/qdatastream.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qendian.h>
+#include <algorithm>
+#include <iterator>
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+Q_LOGGING_CATEGORY(lcQMPKeyframeIndex, "wangwenx190.qtmediaplayer.keyframeindex")
+
+static constexpr const quint32 kIndexFileMagic = 0x514D4B49; // "QMKI"
+static constexpr const quint32 kIndexFileVersion = 1;
+
+// Sanity limit, about 11 days of 60 fps video.
+static constexpr const qint64 kMaximumSampleCount = 60 * 60 * 60 * 24 * 11;
+
+// Matroska element IDs, see https://www.matroska.org/technical/elements.html
+static constexpr const quint32 kEbmlHeaderId = 0x1A45DFA3;
+static constexpr const quint32 kSegmentId = 0x18538067;
+static constexpr const quint32 kInfoId = 0x1549A966;
+static constexpr const quint32 kTimestampScaleId = 0x2AD7B1;
+static constexpr const quint32 kTracksId = 0x1654AE6B;
+static constexpr const quint32 kTrackEntryId = 0xAE;
+static constexpr const quint32 kTrackNumberId = 0xD7;
+static constexpr const quint32 kTrackTypeId = 0x83;
+static constexpr const quint32 kClusterId = 0x1F43B675;
+static constexpr const quint32 kClusterTimestampId = 0xE7;
+static constexpr const quint32 kSimpleBlockId = 0xA3;
+static constexpr const quint32 kBlockGroupId = 0xA0;
+static constexpr const quint32 kBlockId = 0xA1;
+static constexpr const quint32 kReferenceBlockId = 0xFB;
+static constexpr const quint64 kVideoTrackType = 1;
+
+struct Sample
+{
+    qint64 timestamp = 0; // Presentation timestamp, in microseconds.
+    bool keyframe = false;
+};
+
+[[nodiscard]] static constexpr inline quint32 fourCC(const char (&value)[5])
+{
+    return ((quint32(uchar(value[0])) << 24) | (quint32(uchar(value[1])) << 16)
+            | (quint32(uchar(value[2])) << 8) | quint32(uchar(value[3])));
+}
+
+// Bounds checked big endian reader of an in-memory box/element payload.
+class ByteReader
+{
+public:
+    explicit ByteReader(const QByteArray &data) : m_data(data) {}
+
+    Q_NODISCARD bool ok() const
+    {
+        return m_ok;
+    }
+
+    Q_NODISCARD bool atEnd() const
+    {
+        return (!m_ok || (m_pos >= m_data.size()));
+    }
+
+    Q_NODISCARD int position() const
+    {
+        return m_pos;
+    }
+
+    Q_NODISCARD quint64 read(const int bytes)
+    {
+        if (!m_ok || (bytes > 8) || ((m_data.size() - m_pos) < bytes)) {
+            m_ok = false;
+            return 0;
+        }
+        quint64 value = 0;
+        for (int i = 0; i != bytes; ++i) {
+            value = ((value << 8) | quint64(uchar(m_data.at(m_pos + i))));
+        }
+        m_pos += bytes;
+        return value;
+    }
+
+    void skip(const qint64 bytes)
+    {
+        if (!m_ok || (bytes < 0) || ((m_data.size() - m_pos) < bytes)) {
+            m_ok = false;
+            return;
+        }
+        m_pos += int(bytes);
+    }
+
+    // EBML variable size integer. IDs keep their length marker, sizes don't.
+    Q_NODISCARD quint64 readVint(const bool keepMarker, bool *unknown = nullptr)
+    {
+        const quint64 first = read(1);
+        if (!m_ok || (first == 0)) {
+            m_ok = false;
+            return 0;
+        }
+        int length = 1;
+        while (!(first & (0x80 >> (length - 1)))) {
+            ++length;
+        }
+        quint64 value = (keepMarker ? first : (first & (0xFF >> length)));
+        for (int i = 1; i != length; ++i) {
+            value = ((value << 8) | read(1));
+        }
+        if (unknown) {
+            *unknown = (!keepMarker && (value == ((quint64(1) << (7 * length)) - 1)));
+        }
+        return value;
+    }
+
+private:
+    const QByteArray &m_data;
+    int m_pos = 0;
+    bool m_ok = true;
+};
+
+////////////////////////////////////////////////////
+/////         MP4/MOV
+///////////////////////////////////////////////////
+
+struct Box
+{
+    quint32 type = 0;
+    qint64 payload = 0; // Offset of the payload.
+    qint64 end = 0;
+};
+
+[[nodiscard]] static inline bool readBox(QIODevice *device, const qint64 limit, Box *box)
+{
+    Q_ASSERT(device);
+    Q_ASSERT(box);
+    if (!device || !box) {
+        return false;
+    }
+    const qint64 start = device->pos();
+    if ((limit - start) < 8) {
+        return false;
+    }
+    uchar header[8] = {};
+    if (device->read(reinterpret_cast<char *>(header), 8) != 8) {
+        return false;
+    }
+    quint64 size = qFromBigEndian<quint32>(header);
+    box->type = qFromBigEndian<quint32>(header + 4);
+    qint64 headerSize = 8;
+    if (size == 1) {
+        if (device->read(reinterpret_cast<char *>(header), 8) != 8) {
+            return false;
+        }
+        size = qFromBigEndian<quint64>(header);
+        headerSize = 16;
+    } else if (size == 0) {
+        // The box extends to the end of its parent.
+        size = quint64(limit - start);
+    }
+    if ((size < quint64(headerSize)) || (size > quint64(limit - start))) {
+        return false;
+    }
+    box->payload = (start + headerSize);
+    box->end = (start + qint64(size));
+    return true;
+}
+
+[[nodiscard]] static inline bool findBox(QIODevice *device, const qint64 begin, const qint64 end, const quint32 type, Box *box)
+{
+    Q_ASSERT(device);
+    Q_ASSERT(box);
+    if (!device || !box || !device->seek(begin)) {
+        return false;
+    }
+    while (readBox(device, end, box)) {
+        if (box->type == type) {
+            return true;
+        }
+        if (!device->seek(box->end)) {
+            return false;
+        }
+    }
+    return false;
+}
+
+[[nodiscard]] static inline QByteArray readPayload(QIODevice *device, const Box &box)
+{
+    Q_ASSERT(device);
+    if (!device || !device->seek(box.payload)) {
+        return {};
+    }
+    return device->read(box.end - box.payload);
+}
+
+[[nodiscard]] static inline bool isVideoTrack(QIODevice *device, const Box &mdia)
+{
+    Box hdlr = {};
+    if (!findBox(device, mdia.payload, mdia.end, fourCC("hdlr"), &hdlr)) {
+        return false;
+    }
+    const QByteArray data = readPayload(device, hdlr);
+    ByteReader reader(data);
+    reader.skip(8); // Version, flags and pre_defined.
+    return (reader.read(4) == fourCC("vide")) && reader.ok();
+}
+
+[[nodiscard]] static inline bool parseVideoTrack(QIODevice *device, const Box &trak, const Box &mdia, QVector<Sample> *samples)
+{
+    Q_ASSERT(samples);
+    if (!samples) {
+        return false;
+    }
+    Box mdhd = {}, minf = {}, stbl = {}, stts = {};
+    if (!findBox(device, mdia.payload, mdia.end, fourCC("mdhd"), &mdhd)
+        || !findBox(device, mdia.payload, mdia.end, fourCC("minf"), &minf)
+        || !findBox(device, minf.payload, minf.end, fourCC("stbl"), &stbl)
+        || !findBox(device, stbl.payload, stbl.end, fourCC("stts"), &stts)) {
+        return false;
+    }
+
+    quint64 timeScale = 0;
+    {
+        const QByteArray data = readPayload(device, mdhd);
+        ByteReader reader(data);
+        const quint64 version = reader.read(1);
+        reader.skip((version == 1) ? (3 + 8 + 8) : (3 + 4 + 4));
+        timeScale = reader.read(4);
+        if (!reader.ok() || (timeScale == 0)) {
+            return false;
+        }
+    }
+
+    // Decoding timestamps.
+    QVector<qint64> timestamps = {};
+    {
+        const QByteArray data = readPayload(device, stts);
+        ByteReader reader(data);
+        reader.skip(4);
+        const quint64 entryCount = reader.read(4);
+        qint64 dts = 0;
+        for (quint64 entry = 0; (entry != entryCount) && reader.ok(); ++entry) {
+            const quint64 count = reader.read(4);
+            const quint64 delta = reader.read(4);
+            if ((quint64(timestamps.size()) + count) > quint64(kMaximumSampleCount)) {
+                return false;
+            }
+            for (quint64 i = 0; i != count; ++i) {
+                timestamps.append(dts);
+                dts += qint64(delta);
+            }
+        }
+        if (!reader.ok() || timestamps.isEmpty()) {
+            return false;
+        }
+    }
+
+    // Composition offsets turn them into presentation timestamps.
+    Box ctts = {};
+    if (findBox(device, stbl.payload, stbl.end, fourCC("ctts"), &ctts)) {
+        const QByteArray data = readPayload(device, ctts);
+        ByteReader reader(data);
+        reader.skip(4);
+        const quint64 entryCount = reader.read(4);
+        int sample = 0;
+        for (quint64 entry = 0; (entry != entryCount) && reader.ok(); ++entry) {
+            const quint64 count = reader.read(4);
+            // Version 0 is unsigned by the spec, but plenty of muxers write negative offsets anyway.
+            const auto offset = qint32(quint32(reader.read(4)));
+            for (quint64 i = 0; (i != count) && (sample < timestamps.size()); ++i, ++sample) {
+                timestamps[sample] += offset;
+            }
+        }
+    }
+
+    // The edit list tells which media time is presented first.
+    Box edts = {}, elst = {};
+    if (findBox(device, trak.payload, trak.end, fourCC("edts"), &edts)
+        && findBox(device, edts.payload, edts.end, fourCC("elst"), &elst)) {
+        const QByteArray data = readPayload(device, elst);
+        ByteReader reader(data);
+        const quint64 version = reader.read(1);
+        reader.skip(3);
+        const quint64 entryCount = reader.read(4);
+        for (quint64 entry = 0; (entry != entryCount) && reader.ok(); ++entry) {
+            reader.skip((version == 1) ? 8 : 4); // Segment duration.
+            const qint64 mediaTime = ((version == 1) ? qint64(reader.read(8)) : qint64(qint32(quint32(reader.read(4)))));
+            reader.skip(4); // Media rate.
+            if (reader.ok() && (mediaTime >= 0)) {
+                for (auto &&timestamp : timestamps) {
+                    timestamp -= mediaTime;
+                }
+                break;
+            }
+        }
+    }
+
+    // Without a sync sample box every sample is a key frame.
+    QVector<bool> keyframes(timestamps.size(), true);
+    Box stss = {};
+    if (findBox(device, stbl.payload, stbl.end, fourCC("stss"), &stss)) {
+        keyframes.fill(false);
+        const QByteArray data = readPayload(device, stss);
+        ByteReader reader(data);
+        reader.skip(4);
+        const quint64 entryCount = reader.read(4);
+        for (quint64 entry = 0; (entry != entryCount) && reader.ok(); ++entry) {
+            const quint64 sampleNumber = reader.read(4); // One based.
+            if ((sampleNumber > 0) && (sampleNumber <= quint64(timestamps.size()))) {
+                keyframes[int(sampleNumber - 1)] = true;
+            }
+        }
+    }
+
+    samples->reserve(timestamps.size());
+    for (int i = 0; i != timestamps.size(); ++i) {
+        samples->append({(timestamps.at(i) * 1000000 / qint64(timeScale)), keyframes.at(i)});
+    }
+    return true;
+}
+
+[[nodiscard]] static inline bool parseMP4(QIODevice *device, QVector<Sample> *samples)
+{
+    Box moov = {};
+    if (!findBox(device, 0, device->size(), fourCC("moov"), &moov)) {
+        return false;
+    }
+    // Use the first video track.
+    qint64 next = moov.payload;
+    Box trak = {};
+    while (findBox(device, next, moov.end, fourCC("trak"), &trak)) {
+        next = trak.end;
+        Box mdia = {};
+        if (!findBox(device, trak.payload, trak.end, fourCC("mdia"), &mdia) || !isVideoTrack(device, mdia)) {
+            continue;
+        }
+        // Fragmented files have (almost) no samples here, they can't be indexed this way.
+        return parseVideoTrack(device, trak, mdia, samples);
+    }
+    return false;
+}
+
+////////////////////////////////////////////////////
+/////         Matroska/WebM
+///////////////////////////////////////////////////
+
+struct Element
+{
+    quint32 id = 0;
+    qint64 payload = 0; // Offset of the payload.
+    qint64 end = 0; // The end of the file if the size is unknown.
+    bool unknownSize = false;
+};
+
+[[nodiscard]] static inline bool readElement(QIODevice *device, Element *element)
+{
+    Q_ASSERT(device);
+    Q_ASSERT(element);
+    if (!device || !element) {
+        return false;
+    }
+    const qint64 start = device->pos();
+    // The longest ID has 4 bytes, the longest size has 8 bytes.
+    const QByteArray header = device->peek(12);
+    ByteReader reader(header);
+    const quint64 id = reader.readVint(true);
+    bool unknownSize = false;
+    const quint64 size = reader.readVint(false, &unknownSize);
+    if (!reader.ok() || (id > 0xFFFFFFFF)) {
+        return false;
+    }
+    element->id = quint32(id);
+    element->payload = (start + reader.position());
+    element->unknownSize = unknownSize;
+    const qint64 fileSize = device->size();
+    // Truncated files are fine, whatever is there still counts.
+    element->end = (unknownSize ? fileSize : qMin(fileSize, element->payload + qint64(qMin(size, quint64(fileSize)))));
+    return device->seek(element->payload);
+}
+
+[[nodiscard]] static inline quint64 readUnsigned(const QByteArray &data)
+{
+    ByteReader reader(data);
+    return reader.read(qMin(int(data.size()), 8));
+}
+
+// Reads the track number, relative timestamp and flags of a (Simple)Block.
+[[nodiscard]] static inline bool readBlockHeader(QIODevice *device, quint64 *track, qint16 *timestamp, quint8 *flags)
+{
+    Q_ASSERT(device);
+    const QByteArray header = device->peek(11);
+    ByteReader reader(header);
+    *track = reader.readVint(false);
+    *timestamp = qint16(quint16(reader.read(2)));
+    *flags = quint8(reader.read(1));
+    return reader.ok();
+}
+
+// Elements are visited in file order. The containers leading to the blocks are
+// entered instead of being parsed recursively, so clusters of unknown size
+// (live recordings) work as well: their children simply follow them.
+[[nodiscard]] static inline bool parseMatroska(QIODevice *device, QVector<Sample> *samples, const std::atomic_bool *cancelled)
+{
+    Q_ASSERT(device);
+    Q_ASSERT(samples);
+    if (!device || !samples) {
+        return false;
+    }
+    quint64 timestampScale = 1000000; // In nanoseconds.
+    quint64 videoTrack = 0;
+    qint64 clusterTimestamp = 0;
+    const auto addBlock = [&](const qint16 relativeTimestamp, const bool keyframe) -> bool {
+        if (samples->size() >= kMaximumSampleCount) {
+            return false;
+        }
+        const qint64 timestamp = ((clusterTimestamp + relativeTimestamp) * qint64(timestampScale) / 1000);
+        samples->append({timestamp, keyframe});
+        return true;
+    };
+    Element element = {};
+    if (!device->seek(0) || !readElement(device, &element) || (element.id != kEbmlHeaderId)) {
+        return false;
+    }
+    if (!device->seek(element.end)) {
+        return false;
+    }
+    while (!device->atEnd() && readElement(device, &element)) {
+        if (cancelled && cancelled->load()) {
+            return false;
+        }
+        switch (element.id) {
+        case kSegmentId:
+        case kClusterId:
+        case kTracksId:
+            continue; // Enter.
+        case kInfoId: {
+            const QByteArray data = device->read(element.end - element.payload);
+            ByteReader reader(data);
+            while (!reader.atEnd()) {
+                const quint64 id = reader.readVint(true);
+                const quint64 size = reader.readVint(false);
+                if (!reader.ok()) {
+                    break;
+                }
+                if ((id != kTimestampScaleId) || (size > 8)) {
+                    reader.skip(qint64(size));
+                    continue;
+                }
+                const quint64 value = reader.read(int(size));
+                if (value > 0) {
+                    timestampScale = value;
+                }
+            }
+        } break;
+        case kTrackEntryId: {
+            const QByteArray data = device->read(element.end - element.payload);
+            ByteReader reader(data);
+            quint64 number = 0, type = 0;
+            while (!reader.atEnd()) {
+                const quint64 id = reader.readVint(true);
+                const quint64 size = reader.readVint(false);
+                if (!reader.ok()) {
+                    break;
+                }
+                if ((id == kTrackNumberId) || (id == kTrackTypeId)) {
+                    const quint64 value = reader.read(int(qMin(size, quint64(8))));
+                    ((id == kTrackNumberId) ? number : type) = value;
+                } else {
+                    reader.skip(qint64(size));
+                }
+            }
+            if ((videoTrack == 0) && (type == kVideoTrackType)) {
+                videoTrack = number;
+            }
+        } break;
+        case kClusterTimestampId:
+            clusterTimestamp = qint64(readUnsigned(device->read(element.end - element.payload)));
+            break;
+        case kSimpleBlockId: {
+            quint64 track = 0;
+            qint16 timestamp = 0;
+            quint8 flags = 0;
+            if (readBlockHeader(device, &track, &timestamp, &flags) && (videoTrack != 0) && (track == videoTrack)) {
+                if (!addBlock(timestamp, (flags & 0x80))) {
+                    return false;
+                }
+            }
+        } break;
+        case kBlockGroupId: {
+            bool isVideo = false, keyframe = true;
+            qint16 timestamp = 0;
+            Element child = {};
+            while ((device->pos() < element.end) && readElement(device, &child)) {
+                if (child.id == kBlockId) {
+                    quint64 track = 0;
+                    quint8 flags = 0;
+                    isVideo = (readBlockHeader(device, &track, &timestamp, &flags) && (videoTrack != 0) && (track == videoTrack));
+                } else if (child.id == kReferenceBlockId) {
+                    // Only blocks which don't reference any other block are key frames.
+                    keyframe = false;
+                }
+                if (child.unknownSize || !device->seek(child.end)) {
+                    break;
+                }
+            }
+            if (isVideo && !addBlock(timestamp, keyframe)) {
+                return false;
+            }
+        } break;
+        default:
+            break;
+        }
+        // Everything else (cues, tags, attachments, block payloads ...) is skipped.
+        if (element.unknownSize || !device->seek(element.end)) {
+            break;
+        }
+    }
+    return !samples->isEmpty();
+}
+
+////////////////////////////////////////////////////
+/////         KeyframeIndex
+///////////////////////////////////////////////////
+
+[[nodiscard]] static inline QString indexFilePath(const QUrl &url)
+{
+    const QString key = Cache::mediaKey(url);
+    if (key.isEmpty()) {
+        return {};
+    }
+    const QString dirPath = Cache::directoryPath(QStringLiteral("keyframes"));
+    if (dirPath.isEmpty()) {
+        return {};
+    }
+    return (dirPath + u'/' + key + QStringLiteral(".idx"));
+}
+
+QSharedPointer<const KeyframeIndex> KeyframeIndex::load(const QUrl &url, const std::atomic_bool *cancelled)
+{
+    Q_ASSERT(url.isValid());
+    if (!url.isValid() || !url.isLocalFile()) {
+        return nullptr;
+    }
+    const auto index = QSharedPointer<KeyframeIndex>::create();
+    const QString cacheFilePath = indexFilePath(url);
+    if (!cacheFilePath.isEmpty() && QFile::exists(cacheFilePath) && index->read(cacheFilePath)) {
+        Cache::touch(cacheFilePath);
+        return index;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    if (!index->build(url.toLocalFile(), cancelled)) {
+        return nullptr;
+    }
+    qCDebug(lcQMPKeyframeIndex) << "Indexed" << index->frameCount() << "frames and" << index->keyframeCount()
+                         << "key frames of" << url << "in" << timer.elapsed() << "ms.";
+    if (!cacheFilePath.isEmpty()) {
+        if (index->write(cacheFilePath)) {
+            Cache::addFile(cacheFilePath);
+        } else {
+            qCWarning(lcQMPKeyframeIndex) << "Failed to save the key frame index to" << cacheFilePath;
+        }
+    }
+    return index;
+}
+
+bool KeyframeIndex::isEmpty() const
+{
+    return m_frameTimes.isEmpty();
+}
+
+int KeyframeIndex::frameCount() const
+{
+    return m_frameTimes.size();
+}
+
+int KeyframeIndex::keyframeCount() const
+{
+    return m_keyframes.size();
+}
+
+qint64 KeyframeIndex::frameToTimestamp(const int frame) const
+{
+    if ((frame < 0) || (frame >= m_frameTimes.size())) {
+        return -1;
+    }
+    // Round up, so that the frame displayed at the returned time is this very frame.
+    return ((m_frameTimes.at(frame) + 999) / 1000);
+}
+
+int KeyframeIndex::timestampToFrame(const qint64 timestamp) const
+{
+    if (m_frameTimes.isEmpty()) {
+        return -1;
+    }
+    const auto it = std::upper_bound(m_frameTimes.cbegin(), m_frameTimes.cend(), (timestamp * 1000));
+    return qMax(0, int(std::distance(m_frameTimes.cbegin(), it)) - 1);
+}
+
+qint64 KeyframeIndex::keyframeBefore(const qint64 timestamp) const
+{
+    const int frame = timestampToFrame(timestamp);
+    if ((frame < 0) || m_keyframes.isEmpty()) {
+        return -1;
+    }
+    const auto it = std::upper_bound(m_keyframes.cbegin(), m_keyframes.cend(), frame);
+    if (it == m_keyframes.cbegin()) {
+        return -1;
+    }
+    return frameToTimestamp(*std::prev(it));
+}
+
+qint64 KeyframeIndex::keyframeAfter(const qint64 timestamp) const
+{
+    if (m_frameTimes.isEmpty() || m_keyframes.isEmpty()) {
+        return -1;
+    }
+    const auto frameIt = std::lower_bound(m_frameTimes.cbegin(), m_frameTimes.cend(), (timestamp * 1000));
+    const int frame = int(std::distance(m_frameTimes.cbegin(), frameIt));
+    const auto it = std::lower_bound(m_keyframes.cbegin(), m_keyframes.cend(), frame);
+    if (it == m_keyframes.cend()) {
+        return -1;
+    }
+    return frameToTimestamp(*it);
+}
+
+QVector<qint64> KeyframeIndex::gopFrames(const qint64 timestamp) const
+{
+    const int frame = timestampToFrame(timestamp);
+    if ((frame < 0) || m_keyframes.isEmpty()) {
+        return {};
+    }
+    const auto it = std::upper_bound(m_keyframes.cbegin(), m_keyframes.cend(), frame);
+    const int first = ((it == m_keyframes.cbegin()) ? 0 : *std::prev(it));
+    const int last = ((it == m_keyframes.cend()) ? m_frameTimes.size() : *it);
+    QVector<qint64> frames = {};
+    frames.reserve(last - first);
+    for (int i = first; i != last; ++i) {
+        frames.append(frameToTimestamp(i));
+    }
+    return frames;
+}
+
+bool KeyframeIndex::build(const QString &filePath, const std::atomic_bool *cancelled)
+{
+    Q_ASSERT(!filePath.isEmpty());
+    if (filePath.isEmpty()) {
+        return false;
+    }
+    QFile file(filePath);
+    if (!file.open(QFile::ReadOnly)) {
+        return false;
+    }
+    QVector<Sample> samples = {};
+    const QByteArray magic = file.peek(8);
+    if ((magic.size() == 8) && (qFromBigEndian<quint32>(magic.constData()) == kEbmlHeaderId)) {
+        if (!parseMatroska(&file, &samples, cancelled)) {
+            return false;
+        }
+    } else if (!parseMP4(&file, &samples)) {
+        return false;
+    }
+    if (samples.isEmpty() || (cancelled && cancelled->load())) {
+        return false;
+    }
+    // Containers store the packets in decoding order.
+    std::stable_sort(samples.begin(), samples.end(), [](const Sample &lhs, const Sample &rhs){
+        return (lhs.timestamp < rhs.timestamp);
+    });
+    const qint64 startTime = samples.constFirst().timestamp;
+    m_frameTimes.clear();
+    m_frameTimes.reserve(samples.size());
+    m_keyframes.clear();
+    for (int i = 0; i != samples.size(); ++i) {
+        m_frameTimes.append(samples.at(i).timestamp - startTime);
+        if (samples.at(i).keyframe) {
+            m_keyframes.append(i);
+        }
+    }
+    // A stream always starts with a key frame, whatever the container claims.
+    if (m_keyframes.isEmpty() || (m_keyframes.constFirst() != 0)) {
+        m_keyframes.prepend(0);
+    }
+    return true;
+}
+
+bool KeyframeIndex::read(const QString &filePath)
+{
+    Q_ASSERT(!filePath.isEmpty());
+    if (filePath.isEmpty()) {
+        return false;
+    }
+    QFile file(filePath);
+    if (!file.open(QFile::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_15);
+    quint32 magic = 0, version = 0;
+    stream >> magic >> version;
+    if ((magic != kIndexFileMagic) || (version != kIndexFileVersion)) {
+        return false;
+    }
+    stream >> m_frameTimes >> m_keyframes;
+    if ((stream.status() != QDataStream::Ok) || m_frameTimes.isEmpty()) {
+        m_frameTimes.clear();
+        m_keyframes.clear();
+        return false;
+    }
+    return true;
+}
+
+bool KeyframeIndex::write(const QString &filePath) const
+{
+    Q_ASSERT(!filePath.isEmpty());
+    if (filePath.isEmpty()) {
+        return false;
+    }
+    // Never leave a half written index behind.
+    QSaveFile file(filePath);
+    if (!file.open(QFile::WriteOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_15);
+    stream << kIndexFileMagic << kIndexFileVersion << m_frameTimes << m_keyframes;
+    return ((stream.status() == QDataStream::Ok) && file.commit());
+}
+
+QTMEDIAPLAYER_END_NAMESPACE
@@ -0,0 +1,81 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "../loader/qtmediaplayer_global.h"
+#include <QtCore/qvector.h>
+#include <QtCore/qurl.h>
+#include <QtCore/qsharedpointer.h>
+#include <atomic>
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(lcQMPKeyframeIndex)
+
+// Presentation timestamps of every video frame and the positions of the key
+// frames among them. It's built from the packet headers of the container only,
+// nothing is decoded. Currently MP4/MOV (non-fragmented) and Matroska/WebM are
+// understood, other formats simply have no index.
+class KeyframeIndex
+{
+public:
+    explicit KeyframeIndex() = default;
+    ~KeyframeIndex() = default;
+
+    // Loads the index of the given local file from the cache, or builds (and caches)
+    // it if there's none yet. Blocks, so don't call it on the GUI thread. Returns
+    // null if the file can't be indexed or "cancelled" becomes true meanwhile.
+    Q_NODISCARD static QSharedPointer<const KeyframeIndex> load(const QUrl &url, const std::atomic_bool *cancelled = nullptr);
+
+    Q_NODISCARD bool isEmpty() const;
+    Q_NODISCARD int frameCount() const;
+    Q_NODISCARD int keyframeCount() const;
+
+    // All timestamps are in milliseconds, relative to the first frame.
+    Q_NODISCARD qint64 frameToTimestamp(const int frame) const;
+
+    // The frame being displayed at the given time.
+    Q_NODISCARD int timestampToFrame(const qint64 timestamp) const;
+
+    // Timestamp of the closest key frame at or before/after the given time,
+    // or -1 if there's none.
+    Q_NODISCARD qint64 keyframeBefore(const qint64 timestamp) const;
+    Q_NODISCARD qint64 keyframeAfter(const qint64 timestamp) const;
+
+    // Timestamps of all frames of the GOP containing the given time, starting
+    // with its key frame.
+    Q_NODISCARD QVector<qint64> gopFrames(const qint64 timestamp) const;
+
+private:
+    Q_NODISCARD bool build(const QString &filePath, const std::atomic_bool *cancelled);
+    Q_NODISCARD bool read(const QString &filePath);
+    Q_NODISCARD bool write(const QString &filePath) const;
+
+private:
+    QVector<qint64> m_frameTimes = {}; // In microseconds, ascending.
+    QVector<int> m_keyframes = {}; // Frame numbers, ascending.
+};
+
+QTMEDIAPLAYER_END_NAMESPACE
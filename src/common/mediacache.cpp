@@ -0,0 +1,261 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "mediacache.h"
+#include <QtCore/qdir.h>
+#include <QtCore/qstandardpaths.h>
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qdatetime.h>
+#include <QtCore/qcryptographichash.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qdiriterator.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qset.h>
+#include <QtCore/qdebug.h>
+#include <algorithm>
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+Q_LOGGING_CATEGORY(lcQMPCache, "wangwenx190.qtmediaplayer.cache")
+
+static constexpr const char _qmp_cache_dir_envVar[] = "QTMEDIAPLAYER_CACHE_DIR";
+
+static constexpr const char _qmp_cache_size_envVar[] = "QTMEDIAPLAYER_CACHE_SIZE";
+
+static constexpr const qint64 kPrefetchChunkSize = 256 * 1024;
+
+static constexpr const qint64 kDefaultMaximumSize = 512 * 1024 * 1024;
+
+// Pruning goes a bit below the cap, so the next few writes don't trigger it again.
+static constexpr const qreal kPruneTarget = 0.9;
+
+[[nodiscard]] static inline qint64 initialMaximumSize()
+{
+    bool ok = false;
+    const qint64 sizeInMiB = qEnvironmentVariable(_qmp_cache_size_envVar).toLongLong(&ok);
+    return (ok ? (sizeInMiB * 1024 * 1024) : kDefaultMaximumSize);
+}
+
+static std::atomic<qint64> g_maximumSize = initialMaximumSize();
+
+// Approximate total size of the cache, -1 until the first scan.
+static std::atomic<qint64> g_totalSize = -1;
+
+// Only one thread scans or prunes the cache at a time.
+static QMutex g_pruneMutex;
+
+namespace Cache
+{
+
+QString rootDirectoryPath()
+{
+    static const QString path = []() -> QString {
+        const QString pathFromEnvVar = qEnvironmentVariable(_qmp_cache_dir_envVar);
+        if (!pathFromEnvVar.isEmpty()) {
+            return QDir::cleanPath(pathFromEnvVar);
+        }
+        const QString location = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+        if (location.isEmpty()) {
+            return {};
+        }
+        return QDir::cleanPath(location + QStringLiteral("/QtMediaPlayer"));
+    }();
+    return path;
+}
+
+QString directoryPath(const QString &name)
+{
+    Q_ASSERT(!name.isEmpty());
+    if (name.isEmpty()) {
+        return {};
+    }
+    const QString root = rootDirectoryPath();
+    if (root.isEmpty()) {
+        return {};
+    }
+    const QString path = QDir::cleanPath(root + u'/' + name);
+    if (!QDir().mkpath(path)) {
+        return {};
+    }
+    return QDir::toNativeSeparators(path);
+}
+
+bool isDirectoryEmpty(const QString &path)
+{
+    Q_ASSERT(!path.isEmpty());
+    if (path.isEmpty()) {
+        return true;
+    }
+    return QDir(path).isEmpty(QDir::AllEntries | QDir::NoDotAndDotDot);
+}
+
+qint64 maximumSize()
+{
+    return g_maximumSize.load();
+}
+
+void setMaximumSize(const qint64 value)
+{
+    g_maximumSize.store(value);
+}
+
+void addFile(const QString &filePath)
+{
+    Q_ASSERT(!filePath.isEmpty());
+    if (filePath.isEmpty()) {
+        return;
+    }
+    const qint64 maximum = g_maximumSize.load();
+    if (maximum <= 0) {
+        return;
+    }
+    qint64 total = g_totalSize.load();
+    if (total >= 0) {
+        total = (g_totalSize += QFileInfo(filePath).size());
+    }
+    // Unknown total: the first write of the session pays for one scan of the cache.
+    if ((total < 0) || (total > maximum)) {
+        prune();
+    }
+}
+
+void touch(const QString &filePath)
+{
+    Q_ASSERT(!filePath.isEmpty());
+    if (filePath.isEmpty()) {
+        return;
+    }
+    // The access time is not reliable (noatime mounts etc), so the modification time doubles as the "last used" time.
+    QFile file(filePath);
+    if (file.open(QFile::Append)) {
+        file.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+    }
+}
+
+qint64 prune()
+{
+    const QString root = rootDirectoryPath();
+    if (root.isEmpty() || !QDir(root).exists()) {
+        return 0;
+    }
+    // Somebody else is already at it.
+    if (!g_pruneMutex.tryLock()) {
+        return 0;
+    }
+    struct Entry
+    {
+        QString filePath = {};
+        qint64 size = 0;
+        QDateTime lastUsed = {};
+    };
+    QList<Entry> entries = {};
+    qint64 total = 0;
+    QDirIterator it(root, QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        const QFileInfo fileInfo = it.fileInfo();
+        entries.append({fileInfo.filePath(), fileInfo.size(), fileInfo.lastModified()});
+        total += fileInfo.size();
+    }
+    const qint64 maximum = g_maximumSize.load();
+    qint64 freed = 0;
+    if ((maximum > 0) && (total > maximum)) {
+        std::sort(entries.begin(), entries.end(), [](const Entry &lhs, const Entry &rhs){
+            return (lhs.lastUsed < rhs.lastUsed);
+        });
+        const auto target = qint64(qreal(maximum) * kPruneTarget);
+        QSet<QString> touchedDirs = {};
+        for (auto &&entry : qAsConst(entries)) {
+            if ((total - freed) <= target) {
+                break;
+            }
+            if (QFile::remove(entry.filePath)) {
+                freed += entry.size;
+                touchedDirs.insert(QFileInfo(entry.filePath).absolutePath());
+            }
+        }
+        // Per media directories that became empty are useless now.
+        for (auto &&dirPath : qAsConst(touchedDirs)) {
+            if ((QDir::cleanPath(dirPath) != root) && isDirectoryEmpty(dirPath)) {
+                QDir().rmdir(dirPath);
+            }
+        }
+        qCDebug(lcQMPCache) << "Pruned" << freed << "bytes from the disk cache, it's" << (total - freed) << "bytes now.";
+    }
+    g_totalSize.store(total - freed);
+    g_pruneMutex.unlock();
+    return freed;
+}
+
+QString mediaKey(const QUrl &url)
+{
+    Q_ASSERT(url.isValid());
+    if (!url.isValid()) {
+        return {};
+    }
+    QString identity = {};
+    if (url.isLocalFile()) {
+        const QFileInfo fileInfo(url.toLocalFile());
+        if (!fileInfo.exists()) {
+            return {};
+        }
+        identity = fileInfo.canonicalFilePath() + u'|' + QString::number(fileInfo.size())
+                   + u'|' + QString::number(fileInfo.lastModified().toMSecsSinceEpoch());
+    } else {
+        identity = url.toString(QUrl::FullyEncoded);
+    }
+    return QString::fromLatin1(QCryptographicHash::hash(identity.toUtf8(), QCryptographicHash::Sha1).toHex());
+}
+
+qint64 prefetch(const QString &filePath, const qint64 offset, const qint64 length, const std::atomic_bool *cancelled)
+{
+    Q_ASSERT(!filePath.isEmpty());
+    Q_ASSERT(offset >= 0);
+    Q_ASSERT(length > 0);
+    if (filePath.isEmpty() || (offset < 0) || (length <= 0)) {
+        return 0;
+    }
+    QFile file(filePath);
+    if (!file.open(QFile::ReadOnly | QFile::Unbuffered) || !file.seek(offset)) {
+        return 0;
+    }
+    QByteArray buffer(kPrefetchChunkSize, Qt::Uninitialized);
+    qint64 total = 0;
+    while (total < length) {
+        // Checked between the chunks, a replaced prefetch stops right away.
+        if (cancelled && cancelled->load()) {
+            break;
+        }
+        const qint64 bytesRead = file.read(buffer.data(), qMin(kPrefetchChunkSize, length - total));
+        if (bytesRead <= 0) {
+            break;
+        }
+        total += bytesRead;
+    }
+    return total;
+}
+
+} // namespace Cache
+
+QTMEDIAPLAYER_END_NAMESPACE
@@ -0,0 +1,81 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "../loader/qtmediaplayer_global.h"
+#include <QtCore/qstring.h>
+#include <QtCore/qurl.h>
+#include <QtCore/qloggingcategory.h>
+#include <atomic>
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(lcQMPCache)
+
+namespace Cache
+{
+
+// All the persistent data of the library (shader caches, indexes, etc) lives
+// under one root directory: "QTMEDIAPLAYER_CACHE_DIR" if it's set, otherwise
+// a "QtMediaPlayer" folder inside the application's cache location.
+Q_NODISCARD QString rootDirectoryPath();
+
+// Returns the native path of the given sub directory of the cache root and
+// creates it if it doesn't exist yet. An empty string means the directory
+// is not usable and the caller should run without a disk cache.
+Q_NODISCARD QString directoryPath(const QString &name);
+
+Q_NODISCARD bool isDirectoryEmpty(const QString &path);
+
+// The disk cache is capped: once its total size grows beyond the maximum, the least
+// recently used files are deleted until it's back below. The default is 512 MiB,
+// "QTMEDIAPLAYER_CACHE_SIZE" (in MiB) overrides it. Zero or less disables the cap.
+Q_NODISCARD qint64 maximumSize();
+void setMaximumSize(const qint64 value);
+
+// Call after writing a file into the cache, deletes old files if the cap is exceeded.
+// May block on the file system, don't call from the GUI thread.
+void addFile(const QString &filePath);
+
+// Marks a cached file as recently used, so pruning deletes it last.
+void touch(const QString &filePath);
+
+// Deletes the least recently used files until the cache fits into "maximumSize".
+// Blocks, returns the number of bytes freed.
+qint64 prune();
+
+// A short, file system friendly identifier of the given media. Local files are
+// identified by their path, size and modification time, so the data cached for
+// them becomes stale automatically once the file changes.
+Q_NODISCARD QString mediaKey(const QUrl &url);
+
+// Reads the given byte range of a local file and throws the data away, which
+// leaves it in the page cache of the OS. Blocks, returns the number of bytes read.
+qint64 prefetch(const QString &filePath, const qint64 offset, const qint64 length,
+                const std::atomic_bool *cancelled = nullptr);
+
+} // namespace Cache
+
+QTMEDIAPLAYER_END_NAMESPACE
@@ -0,0 +1,100 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "performanceprofile.h"
+#include "playerinterface.h"
+#include <QtCore/qdebug.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qmetaobject.h>
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+PerformanceSettings presetPerformanceSettings(const PerformanceProfile profile)
+{
+    PerformanceSettings settings = {};
+    switch (profile) {
+    case PerformanceProfile::Default:
+    case PerformanceProfile::Custom:
+        break;
+    case PerformanceProfile::LowLatency:
+        settings.readAheadTime = 100;
+        settings.decoderFrameDrop = true;
+        settings.scripts = false;
+        settings.exactSeek = false;
+        break;
+    case PerformanceProfile::LowPower:
+        settings.readAheadTime = 10000;
+        settings.decoderFrameDrop = true;
+        settings.scripts = false;
+        settings.decoderThreads = 2;
+        settings.exactSeek = false;
+        break;
+    case PerformanceProfile::Throughput:
+        settings.readAheadTime = 30000;
+        settings.scripts = false;
+        break;
+    case PerformanceProfile::Preview:
+        settings.readAheadTime = 0;
+        settings.frameDrop = false;
+        settings.scripts = false;
+        settings.decoderThreads = 1;
+        break;
+    case PerformanceProfile::Quality:
+        settings.readAheadTime = 5000;
+        settings.frameDrop = false;
+        break;
+    }
+    return settings;
+}
+
+bool parsePerformanceSettings(const QJsonObject &object, const QString &backendName, PerformanceSettings *settings)
+{
+    Q_ASSERT(settings);
+    if (!settings) {
+        return false;
+    }
+    PerformanceProfile base = PerformanceProfile::Default;
+    const QString baseName = object.value(QStringLiteral("base")).toString();
+    if (!baseName.isEmpty()) {
+        bool ok = false;
+        const int value = QMetaEnum::fromType<PerformanceProfile>().keyToValue(qUtf8Printable(baseName), &ok);
+        if (!ok || (value == static_cast<int>(PerformanceProfile::Custom))) {
+            qCWarning(lcQMPPlayer) << "Unknown base performance profile:" << baseName;
+            return false;
+        }
+        base = static_cast<PerformanceProfile>(value);
+    }
+    PerformanceSettings result = presetPerformanceSettings(base);
+    result.readAheadTime = qint64(object.value(QStringLiteral("readAheadTime")).toDouble(result.readAheadTime));
+    result.frameDrop = object.value(QStringLiteral("frameDrop")).toBool(result.frameDrop);
+    result.decoderFrameDrop = object.value(QStringLiteral("decoderFrameDrop")).toBool(result.decoderFrameDrop);
+    result.scripts = object.value(QStringLiteral("scripts")).toBool(result.scripts);
+    result.decoderThreads = qMax(0, object.value(QStringLiteral("decoderThreads")).toInt(result.decoderThreads));
+    result.exactSeek = object.value(QStringLiteral("exactSeek")).toBool(result.exactSeek);
+    result.backendOptions = object.value(backendName.toLower()).toObject().toVariantHash();
+    *settings = result;
+    return true;
+}
+
+QTMEDIAPLAYER_END_NAMESPACE
@@ -0,0 +1,64 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "playertypes.h"
+#include <QtCore/qvariant.h>
+
+QT_BEGIN_NAMESPACE
+QT_FORWARD_DECLARE_CLASS(QJsonObject)
+QT_END_NAMESPACE
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+// The tuning knobs shared by all backends. Every performance profile is a set
+// of these, backends translate them into their own options in one go.
+struct PerformanceSettings
+{
+    // Media buffered ahead of the playback position, in milliseconds. A negative
+    // value lets the backend decide.
+    qint64 readAheadTime = -1;
+    // Late frames are dropped instead of delaying the video.
+    bool frameDrop = true;
+    // Frames are also dropped before decoding them when the decoder falls behind.
+    bool decoderFrameDrop = false;
+    // User scripts and the youtube-dl hook, if the backend has them.
+    bool scripts = true;
+    // Zero lets the backend decide. The "decoderThreads" property takes precedence.
+    int decoderThreads = 0;
+    // Precision of automatic seeks outside of scrubbing.
+    bool exactSeek = true;
+    // Raw options of the backend which loaded the profile, applied last.
+    QVariantHash backendOptions = {};
+};
+
+Q_NODISCARD PerformanceSettings presetPerformanceSettings(const PerformanceProfile profile);
+
+// Reads a custom profile. All keys are optional, "base" names the preset the
+// missing ones are taken from, and the object named after the backend (in lower
+// case, for example "mpv") holds its raw options.
+Q_NODISCARD bool parsePerformanceSettings(const QJsonObject &object, const QString &backendName, PerformanceSettings *settings);
+
+QTMEDIAPLAYER_END_NAMESPACE
@@ -23,17 +23,70 @@
  */
 
 #include "playerinterface.h"
+#include "keyframeindex.h"
+#include "seekscheduler.h"
+#include "mediacache.h"
+#include "resourcegovernor.h"
+#include "decodercalibration.h"
+#include "qualitycontroller.h"
 #include <QtCore/qdebug.h>
 #include <QtCore/qmimedatabase.h>
 #include <QtCore/qmimetype.h>
 #include <QtCore/qdatetime.h>
 #include <QtCore/qfileinfo.h>
+#include <QtCore/qdeadlinetimer.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qthreadpool.h>
+#include <QtCore/qrunnable.h>
+#include <QtCore/qtimer.h>
+#include <QtCore/qmetaobject.h>
+#include <QtCore/qalgorithms.h>
 #include <QtGui/qguiapplication.h>
 #include <QtGui/qscreen.h>
 #include <QtQuick/qquickwindow.h>
+#include <cmath>
+#include <utility>
 
 QTMEDIAPLAYER_BEGIN_NAMESPACE
 
+Q_LOGGING_CATEGORY(lcQMPPlayer, "wangwenx190.qtmediaplayer.player")
+
+// How far (relative) the display refresh rate may be from a multiple of the video
+// frame rate to still be matched by slightly changing the playback speed. This is
+// also the default of mpv's "video-sync-max-video-change".
+static constexpr const qreal kMaximumRefreshRateDeviation = 0.01;
+
+// The hovered position keeps changing while the mouse moves, only prefetch
+// once it rests for a moment.
+static constexpr const int kPrefetchDelay = 100;
+
+// Swaps further apart than this many refresh periods mean nothing was rendered in
+// between, which says nothing about frame pacing.
+static constexpr const qreal kMaximumSwapGap = 4.0;
+static constexpr const int kSwapSampleCount = 120;
+static constexpr const int kSwapPublishInterval = 30;
+
+// The backends free their decoders and buffers asynchronously, the memory
+// reclaimed by a suspension is only measured after this many milliseconds.
+static constexpr const int kSuspendMeasureDelay = 1000;
+
+// How often the debug statistics of the change notifications are logged.
+static constexpr const int kChangeStatsInterval = 1000;
+
+// Decoded pictures alive per video decoder: the reference frames of a typical
+// H.264/HEVC stream plus the presentation queue.
+static constexpr const int kEstimatedQueuedFrames = 8;
+
+// The cache state changes with every demuxed packet, it's only published this
+// often (in milliseconds).
+static constexpr const int kCacheStateInterval = 500;
+
+// The audio queued for the device in low latency mode (in milliseconds), deep
+// enough to survive a missed scheduler tick.
+static constexpr const int kLowLatencyAudioBufferSize = 30;
+
 #ifndef QT_NO_DEBUG_STREAM
 [[nodiscard]] QDebug operator<<(QDebug d, const ChapterInfo &info)
 {
@@ -103,9 +156,85 @@ MediaPlayer::MediaPlayer(QQuickItem *parent) : QQuickItem(parent)
     // Re-calculate the recommended window size and position everytime when the videoSize changes.
     connect(this, &MediaPlayer::videoSizeChanged, this, &MediaPlayer::recommendedWindowSizeChanged);
     connect(this, &MediaPlayer::recommendedWindowSizeChanged, this, &MediaPlayer::recommendedWindowPositionChanged);
+
+    connect(this, &MediaPlayer::sourceChanged, this, &MediaPlayer::rebuildKeyframeIndex);
+    connect(this, &MediaPlayer::playbackRateChanged, this, &MediaPlayer::updateTrickPlay);
+
+    m_seekScheduler = new SeekScheduler([this](const qint64 position, const bool exact){
+        return doSeek(position, exact);
+    }, this);
+    m_seekScheduler->setStepIssuer([this](const int frames){
+        return doStep(frames);
+    });
+    connect(m_seekScheduler, &SeekScheduler::finished, this, [this](const qint64 position, const qreal latency){
+        Q_UNUSED(position);
+        m_seekLatency = latency;
+        Q_EMIT seekLatencyChanged();
+    });
+    // Pending seeks belong to the previous media.
+    connect(this, &MediaPlayer::sourceChanged, m_seekScheduler, &SeekScheduler::reset);
+
+    m_prefetchTimer = new QTimer(this);
+    m_prefetchTimer->setSingleShot(true);
+    m_prefetchTimer->setInterval(kPrefetchDelay);
+    connect(m_prefetchTimer, &QTimer::timeout, this, &MediaPlayer::startPrefetch);
+    connect(this, &MediaPlayer::sourceChanged, this, &MediaPlayer::cancelPrefetch);
+
+    m_idleTimer = new QTimer(this);
+    m_idleTimer->setSingleShot(true);
+    connect(m_idleTimer, &QTimer::timeout, this, &MediaPlayer::suspend);
+    // Backends may report state changes from their own threads.
+    connect(this, &MediaPlayer::playbackStateChanged, this, &MediaPlayer::updateIdleTimer, Qt::QueuedConnection);
+    // A suspension belongs to the media it was made for.
+    connect(this, &MediaPlayer::sourceChanged, this, [this](){
+        if (!m_suspended) {
+            return;
+        }
+        m_suspended = false;
+        Q_EMIT suspendedChanged();
+        applySuspension();
+    });
+
+    m_cacheTimer = new QTimer(this);
+    m_cacheTimer->setTimerType(Qt::CoarseTimer);
+    m_cacheTimer->setInterval(kCacheStateInterval);
+    connect(m_cacheTimer, &QTimer::timeout, this, &MediaPlayer::updateCacheState);
+    connect(this, &MediaPlayer::playbackStateChanged, this, &MediaPlayer::updateCacheTimer, Qt::QueuedConnection);
+    // The statistics belong to the media they were collected for.
+    connect(this, &MediaPlayer::sourceChanged, this, [this](){
+        m_underrun = false;
+        if (m_underrunCount == 0) {
+            return;
+        }
+        m_underrunCount = 0;
+        Q_EMIT cacheStatisticsChanged();
+    });
+
+    m_qualityController = new QualityController([this](){
+        return queryFrameStatistics();
+    }, this);
+    connect(m_qualityController, &QualityController::tierChanged, this, [this](){
+        Q_EMIT qualityTierChanged();
+        applyDecodeQuality();
+    });
+    connect(this, &MediaPlayer::playbackStateChanged, this, &MediaPlayer::updateQualityController, Qt::QueuedConnection);
+
+    ResourceGovernor::instance()->registerPlayer(this);
 }
 
-MediaPlayer::~MediaPlayer() = default;
+MediaPlayer::~MediaPlayer()
+{
+    // The governor may be gone already if the player outlives the application.
+    if (ResourceGovernor * const governor = ResourceGovernor::instance()) {
+        governor->unregisterPlayer(this);
+    }
+    if (m_keyframeIndexCancelled) {
+        m_keyframeIndexCancelled->store(true);
+    }
+    if (m_prefetchCancelled) {
+        m_prefetchCancelled->store(true);
+    }
+}
 
 QString MediaPlayer::qtRHIBackendName() const
 {
@@ -219,6 +348,16 @@ bool MediaPlayer::isPlayingAudio() const
     return isAudioFile(fileName());
 }
 
+qint64 MediaPlayer::presentedFrames()
+{
+    return queryFrameStatistics().presented;
+}
+
+qint64 MediaPlayer::droppedFrames()
+{
+    return queryFrameStatistics().dropped;
+}
+
 QSizeF MediaPlayer::recommendedWindowSize() const
 {
     const QSizeF pictureSize = videoSize();
@@ -295,13 +434,1425 @@ void MediaPlayer::play(const QUrl &url)
     play(); // Start playing regardless of the value of AutoStart.
 }
 
-void MediaPlayer::open(const QUrl &url)
+void MediaPlayer::open(const QUrl &url, const qint64 startPosition)
+{
+    Q_ASSERT(url.isValid());
+    if (!url.isValid()) {
+        return;
+    }
+    // The media is there already, nothing will be loaded.
+    if ((url == source()) && isLoaded()) {
+        if (startPosition > 0) {
+            seek(startPosition, SeekMode::Exact);
+        }
+        play();
+        return;
+    }
+    m_startPosition = qMax(qint64(0), startPosition);
+    play(url);
+    // Don't leak into the next media if the backend refused this one.
+    m_startPosition = 0;
+}
+
+void MediaPlayer::seek(const qint64 value, const SeekMode mode)
+{
+    bool exact = true;
+    switch (mode) {
+    case SeekMode::Auto:
+        exact = ((!m_scrubbing && performanceSettings().exactSeek) || livePreview());
+        break;
+    case SeekMode::Keyframe:
+        exact = false;
+        break;
+    case SeekMode::Exact:
+        exact = true;
+        break;
+    }
+    if (m_scrubbing) {
+        m_scrubbingPosition = (exact ? -1 : value);
+    }
+    m_seekScheduler->request(value, exact, canInterruptSeek());
+}
+
+void MediaPlayer::seekFinished()
+{
+    m_seekScheduler->finish();
+}
+
+void MediaPlayer::requestStep(const int frames)
+{
+    m_seekScheduler->requestStep(frames);
+}
+
+bool MediaPlayer::doStep(const int frames)
+{
+    Q_UNUSED(frames);
+    return false;
+}
+
+bool MediaPlayer::canInterruptSeek() const
+{
+    return false;
+}
+
+bool MediaPlayer::scrubbing() const
+{
+    return m_scrubbing;
+}
+
+void MediaPlayer::setScrubbing(const bool value)
+{
+    if (m_scrubbing == value) {
+        return;
+    }
+    m_scrubbing = value;
+    // The key frame we landed on is close, but not exactly where the user let go.
+    if (!m_scrubbing && (m_scrubbingPosition >= 0)) {
+        seek(m_scrubbingPosition, SeekMode::Exact);
+    }
+    m_scrubbingPosition = -1;
+    Q_EMIT scrubbingChanged();
+}
+
+qreal MediaPlayer::seekLatency() const
+{
+    return m_seekLatency;
+}
+
+void MediaPlayer::seekToKeyframe(const qint64 value)
+{
+    const qint64 before = keyframeBefore(value);
+    const qint64 after = keyframeAfter(value);
+    if ((before < 0) && (after < 0)) {
+        seek(value, SeekMode::Keyframe);
+        return;
+    }
+    // Seeking exactly to a key frame costs no more than a key frame seek, but is deterministic.
+    if ((before < 0) || ((after >= 0) && ((after - value) < (value - before)))) {
+        seek(after, SeekMode::Exact);
+    } else {
+        seek(before, SeekMode::Exact);
+    }
+}
+
+void MediaPlayer::seekToFrame(const int frame)
+{
+    const qint64 timestamp = frameToTimestamp(frame);
+    if (timestamp < 0) {
+        qCWarning(lcQMPPlayer) << "Can't seek to frame" << frame << "without a key frame index.";
+        return;
+    }
+    seek(timestamp, SeekMode::Exact);
+}
+
+qint64 MediaPlayer::frameToTimestamp(const int frame) const
+{
+    return (m_keyframeIndex ? m_keyframeIndex->frameToTimestamp(frame) : -1);
+}
+
+int MediaPlayer::timestampToFrame(const qint64 value) const
+{
+    return (m_keyframeIndex ? m_keyframeIndex->timestampToFrame(value) : -1);
+}
+
+qint64 MediaPlayer::keyframeBefore(const qint64 value) const
+{
+    return (m_keyframeIndex ? m_keyframeIndex->keyframeBefore(value) : -1);
+}
+
+qint64 MediaPlayer::keyframeAfter(const qint64 value) const
+{
+    return (m_keyframeIndex ? m_keyframeIndex->keyframeAfter(value) : -1);
+}
+
+QSharedPointer<const KeyframeIndex> MediaPlayer::keyframeIndex() const
+{
+    return m_keyframeIndex;
+}
+
+int MediaPlayer::frameCacheSize() const
+{
+    return m_frameCacheSize;
+}
+
+void MediaPlayer::setFrameCacheSize(const int value)
+{
+    Q_ASSERT(value > 0);
+    if ((value <= 0) || (m_frameCacheSize == value)) {
+        return;
+    }
+    m_frameCacheSize = value;
+    qCDebug(lcQMPPlayer) << "Frame cache size -->" << m_frameCacheSize << "MB";
+    Q_EMIT frameCacheSizeChanged();
+    applyFrameCacheSize();
+}
+
+void MediaPlayer::applyFrameCacheSize()
+{
+}
+
+qreal MediaPlayer::trickPlayThreshold() const
+{
+    return m_trickPlayThreshold;
+}
+
+void MediaPlayer::setTrickPlayThreshold(const qreal value)
+{
+    Q_ASSERT(value >= 0.0);
+    if ((value < 0.0) || qFuzzyCompare(m_trickPlayThreshold, value)) {
+        return;
+    }
+    m_trickPlayThreshold = value;
+    qCDebug(lcQMPPlayer) << "Trick play threshold -->" << m_trickPlayThreshold;
+    Q_EMIT trickPlayThresholdChanged();
+    updateTrickPlay();
+}
+
+bool MediaPlayer::trickPlay() const
+{
+    return m_trickPlay;
+}
+
+void MediaPlayer::applyTrickPlay()
+{
+}
+
+qint64 MediaPlayer::loopStart() const
+{
+    return m_loopStart;
+}
+
+qint64 MediaPlayer::loopEnd() const
+{
+    return m_loopEnd;
+}
+
+void MediaPlayer::setLoopRange(const qint64 start, const qint64 end)
+{
+    if ((start < 0) || (end <= start)) {
+        qCWarning(lcQMPPlayer) << "Invalid loop range:" << start << "-->" << end;
+        return;
+    }
+    if ((m_loopStart == start) && (m_loopEnd == end)) {
+        return;
+    }
+    m_loopStart = start;
+    m_loopEnd = end;
+    qCDebug(lcQMPPlayer) << "Loop range -->" << m_loopStart << m_loopEnd;
+    Q_EMIT loopRangeChanged();
+    applyLoopRange();
+}
+
+void MediaPlayer::clearLoopRange()
+{
+    if (m_loopStart < 0) {
+        return;
+    }
+    m_loopStart = -1;
+    m_loopEnd = -1;
+    qCDebug(lcQMPPlayer) << "Loop range cleared.";
+    Q_EMIT loopRangeChanged();
+    applyLoopRange();
+}
+
+int MediaPlayer::loopCacheSize() const
+{
+    return m_loopCacheSize;
+}
+
+void MediaPlayer::setLoopCacheSize(const int value)
+{
+    Q_ASSERT(value > 0);
+    if ((value <= 0) || (m_loopCacheSize == value)) {
+        return;
+    }
+    m_loopCacheSize = value;
+    qCDebug(lcQMPPlayer) << "Loop cache size -->" << m_loopCacheSize << "MB";
+    Q_EMIT loopCacheSizeChanged();
+    applyLoopRange();
+}
+
+void MediaPlayer::applyLoopRange()
+{
+}
+
+int MediaPlayer::prefetchSize() const
+{
+    return m_prefetchSize;
+}
+
+void MediaPlayer::setPrefetchSize(const int value)
+{
+    Q_ASSERT(value > 0);
+    if ((value <= 0) || (m_prefetchSize == value)) {
+        return;
+    }
+    m_prefetchSize = value;
+    qCDebug(lcQMPPlayer) << "Prefetch size -->" << m_prefetchSize << "MB";
+    Q_EMIT prefetchSizeChanged();
+}
+
+bool MediaPlayer::isPositionCached(const qint64 value) const
+{
+    Q_UNUSED(value);
+    return false;
+}
+
+void MediaPlayer::prefetchAt(const qint64 value)
+{
+    if ((value < 0) || !isLoaded()) {
+        return;
+    }
+    m_prefetchPosition = value;
+    m_prefetchTimer->start();
+}
+
+void MediaPlayer::cancelPrefetch()
+{
+    m_prefetchTimer->stop();
+    m_prefetchPosition = -1;
+    if (m_prefetchCancelled) {
+        m_prefetchCancelled->store(true);
+        m_prefetchCancelled.reset();
+    }
+}
+
+void MediaPlayer::startPrefetch()
+{
+    const qint64 position = std::exchange(m_prefetchPosition, -1);
+    if (m_prefetchCancelled) {
+        m_prefetchCancelled->store(true);
+        m_prefetchCancelled.reset();
+    }
+    if ((position < 0) || isPositionCached(position)) {
+        return;
+    }
+    const QUrl url = source();
+    // Remote media can only be cached by the backends themselves.
+    if (!url.isValid() || !url.isLocalFile()) {
+        return;
+    }
+    const qint64 _duration = duration();
+    const QString filePath = url.toLocalFile();
+    const qint64 fileSize = QFileInfo(filePath).size();
+    if ((_duration <= 0) || (fileSize <= 0)) {
+        return;
+    }
+    // Without knowing the byte offset of every frame, a constant bit rate is the
+    // best guess. Most of the window lies after it: a seek lands on the key frame
+    // before the position and decodes forward from there.
+    const qint64 length = qMin(fileSize, qint64(m_prefetchSize) * 1024 * 1024);
+    const qint64 estimate = qint64(qreal(fileSize) * qreal(qMin(position, _duration)) / qreal(_duration));
+    const qint64 offset = qBound(qint64(0), estimate - (length / 4), fileSize - length);
+    const auto cancelled = QSharedPointer<std::atomic_bool>::create(false);
+    m_prefetchCancelled = cancelled;
+    QThreadPool::globalInstance()->start(QRunnable::create([filePath, offset, length, cancelled, position](){
+        QElapsedTimer timer;
+        timer.start();
+        const qint64 bytes = Cache::prefetch(filePath, offset, length, cancelled.data());
+        qCDebug(lcQMPPlayer) << "Prefetched" << bytes << "bytes around" << position << "ms in" << timer.elapsed() << "ms.";
+    }));
+}
+
+QList<QUrl> MediaPlayer::queue() const
+{
+    return m_queue;
+}
+
+void MediaPlayer::setQueue(const QList<QUrl> &value)
+{
+    if (m_queue == value) {
+        return;
+    }
+    const QUrl next = nextMedia();
+    m_queue = value;
+    m_queue.removeAll(QUrl());
+    qCDebug(lcQMPPlayer) << "Queue -->" << m_queue;
+    Q_EMIT queueChanged();
+    if (nextMedia() != next) {
+        applyNextMedia();
+    }
+}
+
+void MediaPlayer::enqueue(const QUrl &url)
 {
     Q_ASSERT(url.isValid());
     if (!url.isValid()) {
         return;
     }
+    QList<QUrl> list = m_queue;
+    list.append(url);
+    setQueue(list);
+}
+
+void MediaPlayer::clearQueue()
+{
+    setQueue({});
+}
+
+void MediaPlayer::playNext()
+{
+    if (m_queue.isEmpty()) {
+        return;
+    }
+    QList<QUrl> list = m_queue;
+    const QUrl url = list.takeFirst();
+    setQueue(list);
     play(url);
 }
 
+qreal MediaPlayer::transitionGap() const
+{
+    return m_transitionGap;
+}
+
+QUrl MediaPlayer::nextMedia() const
+{
+    return (m_queue.isEmpty() ? QUrl{} : m_queue.constFirst());
+}
+
+void MediaPlayer::applyNextMedia()
+{
+}
+
+void MediaPlayer::advanceQueue()
+{
+    if (m_queue.isEmpty()) {
+        return;
+    }
+    QList<QUrl> list = m_queue;
+    list.removeFirst();
+    setQueue(list);
+}
+
+int MediaPlayer::decoderThreads() const
+{
+    return m_decoderThreads;
+}
+
+void MediaPlayer::setDecoderThreads(const int value)
+{
+    Q_ASSERT(value >= 0);
+    if ((value < 0) || (m_decoderThreads == value)) {
+        return;
+    }
+    m_decoderThreads = value;
+    qCDebug(lcQMPPlayer) << "Decoder threads -->" << m_decoderThreads;
+    Q_EMIT decoderThreadsChanged();
+    applyResourceLimits();
+}
+
+int MediaPlayer::cacheSize() const
+{
+    return m_cacheSize;
+}
+
+void MediaPlayer::setCacheSize(const int value)
+{
+    Q_ASSERT(value >= 0);
+    if ((value < 0) || (m_cacheSize == value)) {
+        return;
+    }
+    m_cacheSize = value;
+    qCDebug(lcQMPPlayer) << "Cache size -->" << m_cacheSize << "MB";
+    Q_EMIT cacheSizeChanged();
+    applyResourceLimits();
+}
+
+int MediaPlayer::readAheadTime() const
+{
+    return m_readAheadTime;
+}
+
+void MediaPlayer::setReadAheadTime(const int value)
+{
+    Q_ASSERT(value >= -1);
+    if ((value < -1) || (m_readAheadTime == value)) {
+        return;
+    }
+    m_readAheadTime = value;
+    qCDebug(lcQMPPlayer) << "Read ahead time -->" << m_readAheadTime << "ms";
+    Q_EMIT readAheadTimeChanged();
+    applyResourceLimits();
+}
+
+int MediaPlayer::backBufferSize() const
+{
+    return m_backBufferSize;
+}
+
+void MediaPlayer::setBackBufferSize(const int value)
+{
+    Q_ASSERT(value >= 0);
+    if ((value < 0) || (m_backBufferSize == value)) {
+        return;
+    }
+    m_backBufferSize = value;
+    qCDebug(lcQMPPlayer) << "Back buffer size -->" << m_backBufferSize << "MB";
+    Q_EMIT backBufferSizeChanged();
+    applyResourceLimits();
+}
+
+bool MediaPlayer::diskCache() const
+{
+    return m_diskCache;
+}
+
+void MediaPlayer::setDiskCache(const bool value)
+{
+    if (m_diskCache == value) {
+        return;
+    }
+    m_diskCache = value;
+    qCDebug(lcQMPPlayer) << "Disk cache -->" << m_diskCache;
+    Q_EMIT diskCacheChanged();
+    applyResourceLimits();
+}
+
+QVariantList MediaPlayer::bufferedRanges() const
+{
+    return m_bufferedRanges;
+}
+
+qint64 MediaPlayer::inputRate() const
+{
+    return m_inputRate;
+}
+
+int MediaPlayer::underrunCount() const
+{
+    return m_underrunCount;
+}
+
+void MediaPlayer::applyResourceLimits()
+{
+}
+
+qint64 MediaPlayer::effectiveReadAheadTime() const
+{
+    return ((m_readAheadTime >= 0) ? qint64(m_readAheadTime) : performanceSettings().readAheadTime);
+}
+
+CacheState MediaPlayer::queryCacheState()
+{
+    return {};
+}
+
+void MediaPlayer::updateCacheTimer()
+{
+    if (!isStopped()) {
+        if (!m_cacheTimer->isActive()) {
+            m_cacheTimer->start();
+        }
+        return;
+    }
+    m_cacheTimer->stop();
+    m_underrun = false;
+    if (!m_bufferedRanges.isEmpty()) {
+        m_bufferedRanges.clear();
+        Q_EMIT bufferedRangesChanged();
+    }
+    if (m_inputRate >= 0) {
+        m_inputRate = -1;
+        Q_EMIT cacheStatisticsChanged();
+    }
+}
+
+void MediaPlayer::updateCacheState()
+{
+    const CacheState state = queryCacheState();
+    QVariantList ranges = {};
+    for (auto &&range : qAsConst(state.ranges)) {
+        ranges.append(QVariantMap{{QStringLiteral("start"), range.first}, {QStringLiteral("end"), range.second}});
+    }
+    if (m_bufferedRanges != ranges) {
+        m_bufferedRanges = ranges;
+        Q_EMIT bufferedRangesChanged();
+    }
+    bool statisticsChanged = false;
+    if (m_inputRate != state.inputRate) {
+        m_inputRate = state.inputRate;
+        statisticsChanged = true;
+    }
+    // Only count each underrun once, and not the buffering while paused.
+    const bool underrun = (state.underrun && isPlaying());
+    if (underrun && !m_underrun) {
+        ++m_underrunCount;
+        qCDebug(lcQMPPlayer) << "Cache underrun at" << position() << "ms.";
+        statisticsChanged = true;
+    }
+    m_underrun = underrun;
+    if (statisticsChanged) {
+        Q_EMIT cacheStatisticsChanged();
+    }
+}
+
+int MediaPlayer::effectiveDecoderThreads() const
+{
+    // A preview frame is decoded in no time anyway, more threads only add latency.
+    if (m_decodeQuality == DecodeQuality::Preview) {
+        return 1;
+    }
+    if (m_decoderThreads > 0) {
+        return m_decoderThreads;
+    }
+    const int governed = ResourceGovernor::instance()->decoderThreads(this);
+    const int profile = performanceSettings().decoderThreads;
+    if ((governed > 0) && (profile > 0)) {
+        return qMin(governed, profile);
+    }
+    return ((governed > 0) ? governed : profile);
+}
+
+int MediaPlayer::effectiveCacheSize() const
+{
+    const int governed = ResourceGovernor::instance()->cacheSize(this);
+    if ((governed > 0) && (m_cacheSize > 0)) {
+        return qMin(governed, m_cacheSize);
+    }
+    return ((governed > 0) ? governed : m_cacheSize);
+}
+
+PerformanceProfile MediaPlayer::performanceProfile() const
+{
+    return m_performanceProfile;
+}
+
+void MediaPlayer::setPerformanceProfile(const PerformanceProfile value)
+{
+    Q_ASSERT(value != PerformanceProfile::Custom);
+    if ((value == PerformanceProfile::Custom) || (m_performanceProfile == value)) {
+        return;
+    }
+    m_performanceProfile = value;
+    m_performanceSettings = presetPerformanceSettings(m_performanceProfile);
+    qCDebug(lcQMPPlayer) << "Performance profile -->" << m_performanceProfile;
+    Q_EMIT performanceProfileChanged();
+    applyPerformanceProfile();
+}
+
+bool MediaPlayer::loadPerformanceProfile(const QUrl &url)
+{
+    Q_ASSERT(url.isValid());
+    if (!url.isValid()) {
+        return false;
+    }
+    QString filePath = {};
+    if (url.isLocalFile()) {
+        filePath = url.toLocalFile();
+    } else if (QString::compare(url.scheme(), QStringLiteral("qrc"), Qt::CaseInsensitive) == 0) {
+        filePath = u':' + url.path();
+    } else {
+        qCWarning(lcQMPPlayer) << "Performance profiles can only be loaded from local files or resources.";
+        return false;
+    }
+    QFile file(filePath);
+    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+        qCWarning(lcQMPPlayer) << "Failed to open the performance profile" << filePath << ':' << file.errorString();
+        return false;
+    }
+    QJsonParseError error = {};
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+    if (!doc.isObject()) {
+        qCWarning(lcQMPPlayer) << "Failed to parse the performance profile" << filePath << ':' << error.errorString();
+        return false;
+    }
+    PerformanceSettings settings = {};
+    if (!parsePerformanceSettings(doc.object(), backendName(), &settings)) {
+        return false;
+    }
+    m_performanceSettings = settings;
+    qCDebug(lcQMPPlayer) << "Performance profile -->" << filePath;
+    if (m_performanceProfile != PerformanceProfile::Custom) {
+        m_performanceProfile = PerformanceProfile::Custom;
+        Q_EMIT performanceProfileChanged();
+    }
+    applyPerformanceProfile();
+    return true;
+}
+
+PerformanceSettings MediaPlayer::performanceSettings() const
+{
+    return (livePreview() ? presetPerformanceSettings(PerformanceProfile::Preview) : m_performanceSettings);
+}
+
+void MediaPlayer::applyPerformanceProfile()
+{
+}
+
+bool MediaPlayer::videoDecodingEnabled() const
+{
+    return m_videoDecodingEnabled;
+}
+
+void MediaPlayer::setVideoDecodingEnabled(const bool value)
+{
+    if (m_videoDecodingEnabled == value) {
+        return;
+    }
+    m_videoDecodingEnabled = value;
+    qCDebug(lcQMPPlayer) << "Video decoding -->" << m_videoDecodingEnabled;
+    Q_EMIT videoDecodingEnabledChanged();
+    applyVideoDecoding();
+    // The texture node picks the new state up while syncing.
+    update();
+}
+
+void MediaPlayer::applyVideoDecoding()
+{
+}
+
+bool MediaPlayer::suspended() const
+{
+    return m_suspended;
+}
+
+bool MediaPlayer::standby() const
+{
+    return m_standby;
+}
+
+void MediaPlayer::setStandby(const bool value)
+{
+    if (m_standby == value) {
+        return;
+    }
+    m_standby = value;
+    qCDebug(lcQMPPlayer) << "Standby -->" << m_standby;
+    Q_EMIT standbyChanged();
+    // The texture node picks the new state up while syncing.
+    update();
+}
+
+bool MediaPlayer::renderingEnabled() const
+{
+    return (m_videoDecodingEnabled && !m_suspended && !m_standby);
+}
+
+int MediaPlayer::idleSuspendTimeout() const
+{
+    return m_idleSuspendTimeout;
+}
+
+void MediaPlayer::setIdleSuspendTimeout(const int value)
+{
+    Q_ASSERT(value >= 0);
+    if ((value < 0) || (m_idleSuspendTimeout == value)) {
+        return;
+    }
+    m_idleSuspendTimeout = value;
+    qCDebug(lcQMPPlayer) << "Idle suspend timeout -->" << m_idleSuspendTimeout << "ms";
+    Q_EMIT idleSuspendTimeoutChanged();
+    updateIdleTimer();
+}
+
+qint64 MediaPlayer::memoryBeforeSuspend() const
+{
+    return m_memoryBeforeSuspend;
+}
+
+qint64 MediaPlayer::memoryAfterSuspend() const
+{
+    return m_memoryAfterSuspend;
+}
+
+PlayerPriority MediaPlayer::priority() const
+{
+    return m_priority;
+}
+
+void MediaPlayer::setPriority(const PlayerPriority value)
+{
+    if (m_priority == value) {
+        return;
+    }
+    m_priority = value;
+    qCDebug(lcQMPPlayer) << "Priority -->" << m_priority;
+    Q_EMIT priorityChanged();
+}
+
+bool MediaPlayer::autoSelectDecoder() const
+{
+    return m_autoSelectDecoder;
+}
+
+void MediaPlayer::setAutoSelectDecoder(const bool value)
+{
+    if (m_autoSelectDecoder == value) {
+        return;
+    }
+    m_autoSelectDecoder = value;
+    qCDebug(lcQMPPlayer) << "Automatic decoder selection -->" << m_autoSelectDecoder;
+    Q_EMIT autoSelectDecoderChanged();
+}
+
+DecoderBenchmarker *MediaPlayer::createDecoderBenchmarker() const
+{
+    return nullptr;
+}
+
+bool MediaPlayer::selectDecoder(const QString &codec, const QUrl &url, DecoderConfig *config)
+{
+    Q_ASSERT(config);
+    if (!config || codec.isEmpty() || !m_autoSelectDecoder || hardwareDecoding()) {
+        return false;
+    }
+    DecoderCalibration * const calibration = DecoderCalibration::instance();
+    if (!calibration) {
+        return false;
+    }
+    if (calibration->bestConfig(backendName(), backendVersion(), codec, config)) {
+        return true;
+    }
+    if (!url.isValid()) {
+        return false;
+    }
+    DecoderBenchmarker * const benchmarker = createDecoderBenchmarker();
+    if (benchmarker) {
+        calibration->calibrate(backendName(), backendVersion(), codec, url, benchmarker);
+    }
+    return false;
+}
+
+bool MediaPlayer::adaptiveQuality() const
+{
+    return m_adaptiveQuality;
+}
+
+void MediaPlayer::setAdaptiveQuality(const bool value)
+{
+    if (m_adaptiveQuality == value) {
+        return;
+    }
+    m_adaptiveQuality = value;
+    qCDebug(lcQMPPlayer) << "Adaptive quality -->" << m_adaptiveQuality;
+    Q_EMIT adaptiveQualityChanged();
+    if (!m_adaptiveQuality) {
+        m_qualityController->reset();
+    }
+    updateQualityController();
+}
+
+QualityTier MediaPlayer::qualityTier() const
+{
+    return m_qualityController->tier();
+}
+
+FrameStatistics MediaPlayer::queryFrameStatistics()
+{
+    return {};
+}
+
+DecodeQuality MediaPlayer::decodeQuality() const
+{
+    return m_decodeQuality;
+}
+
+void MediaPlayer::setDecodeQuality(const DecodeQuality value)
+{
+    if (m_decodeQuality == value) {
+        return;
+    }
+    m_decodeQuality = value;
+    qCDebug(lcQMPPlayer) << "Decode quality -->" << m_decodeQuality;
+    Q_EMIT decodeQualityChanged();
+    applyDecodeQuality();
+    // The decoder threads depend on it as well.
+    applyResourceLimits();
+}
+
+DecodeShortcuts MediaPlayer::decodeShortcuts() const
+{
+    const QualityTier tier = qualityTier();
+    const bool fast = (m_decodeQuality >= DecodeQuality::Fast);
+    const bool preview = (m_decodeQuality == DecodeQuality::Preview);
+    DecodeShortcuts result = {};
+    result.fast = fast;
+    result.fastRendering = (fast || (tier >= QualityTier::FastRendering));
+    if (fast) {
+        result.skipLoopFilter = QStringLiteral("all");
+    } else if (tier >= QualityTier::SkipLoopFilter) {
+        result.skipLoopFilter = QStringLiteral("nonref");
+    }
+    if (preview) {
+        result.lowres = 2;
+    } else if (tier >= QualityTier::ReducedResolution) {
+        result.lowres = 1;
+    }
+    // Trick play only needs the key frames anyway.
+    if (trickPlay()) {
+        result.skipFrame = QStringLiteral("nonkey");
+    } else if (preview || (tier >= QualityTier::ReducedFrameRate)) {
+        result.skipFrame = QStringLiteral("nonref");
+    }
+    return result;
+}
+
+void MediaPlayer::applyDecodeQuality()
+{
+}
+
+QString MediaPlayer::audioOutput() const
+{
+    return m_audioOutput;
+}
+
+void MediaPlayer::setAudioOutput(const QString &value)
+{
+    if (m_audioOutput == value) {
+        return;
+    }
+    m_audioOutput = value;
+    qCDebug(lcQMPPlayer) << "Audio output -->" << m_audioOutput;
+    Q_EMIT audioOutputChanged();
+    applyAudioOutput();
+}
+
+int MediaPlayer::audioBufferSize() const
+{
+    return m_audioBufferSize;
+}
+
+void MediaPlayer::setAudioBufferSize(const int value)
+{
+    Q_ASSERT(value >= 0);
+    if ((value < 0) || (m_audioBufferSize == value)) {
+        return;
+    }
+    m_audioBufferSize = value;
+    qCDebug(lcQMPPlayer) << "Audio buffer size -->" << m_audioBufferSize << "ms";
+    Q_EMIT audioBufferSizeChanged();
+    applyAudioOutput();
+}
+
+int MediaPlayer::audioPeriodSize() const
+{
+    return m_audioPeriodSize;
+}
+
+void MediaPlayer::setAudioPeriodSize(const int value)
+{
+    Q_ASSERT(value >= 0);
+    if ((value < 0) || (m_audioPeriodSize == value)) {
+        return;
+    }
+    m_audioPeriodSize = value;
+    qCDebug(lcQMPPlayer) << "Audio period size -->" << m_audioPeriodSize << "ms";
+    Q_EMIT audioPeriodSizeChanged();
+    applyAudioOutput();
+}
+
+bool MediaPlayer::lowLatencyAudio() const
+{
+    return m_lowLatencyAudio;
+}
+
+void MediaPlayer::setLowLatencyAudio(const bool value)
+{
+    if (m_lowLatencyAudio == value) {
+        return;
+    }
+    m_lowLatencyAudio = value;
+    qCDebug(lcQMPPlayer) << "Low latency audio -->" << m_lowLatencyAudio;
+    Q_EMIT lowLatencyAudioChanged();
+    applyAudioOutput();
+}
+
+void MediaPlayer::applyAudioOutput()
+{
+}
+
+int MediaPlayer::effectiveAudioBufferSize() const
+{
+    if (m_audioBufferSize > 0) {
+        return m_audioBufferSize;
+    }
+    return (m_lowLatencyAudio ? kLowLatencyAudioBufferSize : 0);
+}
+
+void MediaPlayer::updateQualityController()
+{
+    // Nothing gets dropped while paused, and live previews only show single frames.
+    m_qualityController->setActive(m_adaptiveQuality && isPlaying() && !livePreview());
+}
+
+qint64 MediaPlayer::memoryUsage() const
+{
+    return m_memoryUsage;
+}
+
+qint64 MediaPlayer::queryMemoryUsage() const
+{
+    return -1;
+}
+
+qint64 MediaPlayer::queryFrameMemoryUsage() const
+{
+    // Suspended players have no decoders, and nothing is decoded without video decoding.
+    if (m_suspended || !m_videoDecodingEnabled || !isLoaded()) {
+        return 0;
+    }
+    const QSize size = videoSize().toSize();
+    if (size.isEmpty()) {
+        return -1;
+    }
+    // 8 bit 4:2:0, the most common decoder output by far.
+    return (qint64(size.width()) * qint64(size.height()) * 3 / 2 * kEstimatedQueuedFrames);
+}
+
+qint64 MediaPlayer::estimatedFrameMemory() const
+{
+    return m_estimatedFrameMemory;
+}
+
+void MediaPlayer::updateMemoryUsage()
+{
+    updateEstimatedFrameMemory();
+    const qint64 usage = (isStopped() ? 0 : queryMemoryUsage());
+    if (m_memoryUsage == usage) {
+        return;
+    }
+    m_memoryUsage = usage;
+    Q_EMIT memoryUsageChanged();
+}
+
+void MediaPlayer::updateEstimatedFrameMemory()
+{
+    const qint64 estimate = (isStopped() ? 0 : queryFrameMemoryUsage());
+    if (m_estimatedFrameMemory == estimate) {
+        return;
+    }
+    m_estimatedFrameMemory = estimate;
+    Q_EMIT estimatedFrameMemoryChanged();
+}
+
+void MediaPlayer::suspend()
+{
+    if (m_suspended || !isLoaded()) {
+        return;
+    }
+    m_idleTimer->stop();
+    m_resumePlaying = isPlaying();
+    if (m_resumePlaying) {
+        pause();
+    }
+    m_memoryBeforeSuspend = queryMemoryUsage();
+    m_memoryAfterSuspend = -1;
+    Q_EMIT suspensionMemoryChanged();
+    const qint64 frameMemory = queryFrameMemoryUsage();
+    m_suspended = true;
+    qCDebug(lcQMPPlayer) << "Suspended at" << position() << "ms.";
+    Q_EMIT suspendedChanged();
+    applySuspension();
+    updateEstimatedFrameMemory();
+    // The texture node keeps the last frame from now on.
+    update();
+    QTimer::singleShot(kSuspendMeasureDelay, this, [this, frameMemory](){
+        if (!m_suspended) {
+            return;
+        }
+        m_memoryAfterSuspend = queryMemoryUsage();
+        qCDebug(lcQMPPlayer) << "Player memory reported before/after the suspension:"
+                             << m_memoryBeforeSuspend << m_memoryAfterSuspend << "bytes, decoder frames"
+                             << "released (estimated):" << frameMemory << "bytes";
+        Q_EMIT suspensionMemoryChanged();
+    });
+}
+
+void MediaPlayer::resume()
+{
+    if (!m_suspended) {
+        return;
+    }
+    m_suspended = false;
+    qCDebug(lcQMPPlayer) << "Resuming at" << position() << "ms.";
+    Q_EMIT suspendedChanged();
+    // Backends set the decoders up again in the background and re-sync them at
+    // the exact position. The last frame stays on the screen until then.
+    applySuspension();
+    updateEstimatedFrameMemory();
+    if (m_resumePlaying) {
+        play();
+    }
+    update();
+    updateIdleTimer();
+}
+
+void MediaPlayer::applySuspension()
+{
+}
+
+void MediaPlayer::updateIdleTimer()
+{
+    if ((m_idleSuspendTimeout > 0) && !m_suspended && isPaused()) {
+        m_idleTimer->start(m_idleSuspendTimeout);
+    } else {
+        m_idleTimer->stop();
+    }
+}
+
+void MediaPlayer::updateTrickPlay()
+{
+    const bool active = ((m_trickPlayThreshold > 0.0) && (qAbs(playbackRate()) >= m_trickPlayThreshold));
+    if (m_trickPlay == active) {
+        return;
+    }
+    m_trickPlay = active;
+    qCDebug(lcQMPPlayer) << "Trick play -->" << m_trickPlay;
+    Q_EMIT trickPlayChanged();
+    applyTrickPlay();
+}
+
+bool MediaPlayer::keyframeIndexReady() const
+{
+    return !m_keyframeIndex.isNull();
+}
+
+int MediaPlayer::frameCount() const
+{
+    return (m_keyframeIndex ? m_keyframeIndex->frameCount() : 0);
+}
+
+void MediaPlayer::rebuildKeyframeIndex()
+{
+    if (m_keyframeIndexCancelled) {
+        m_keyframeIndexCancelled->store(true);
+        m_keyframeIndexCancelled.reset();
+    }
+    if (m_keyframeIndex) {
+        m_keyframeIndex.reset();
+        Q_EMIT keyframeIndexChanged();
+    }
+    const QUrl url = source();
+    // Only local files can be scanned without downloading them entirely.
+    if (!url.isValid() || !url.isLocalFile() || livePreview() || !isVideoFile(url.fileName())) {
+        return;
+    }
+    const auto cancelled = QSharedPointer<std::atomic_bool>::create(false);
+    m_keyframeIndexCancelled = cancelled;
+    const QPointer<MediaPlayer> guard = this;
+    QThreadPool::globalInstance()->start(QRunnable::create([url, cancelled, guard](){
+        const QSharedPointer<const KeyframeIndex> index = KeyframeIndex::load(url, cancelled.data());
+        if (!index || cancelled->load()) {
+            return;
+        }
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [index, cancelled, guard](){
+            if (!guard || cancelled->load()) {
+                return;
+            }
+            guard->m_keyframeIndex = index;
+            Q_EMIT guard->keyframeIndexChanged();
+        }, Qt::QueuedConnection);
+    }));
+}
+
+void MediaPlayer::invalidateSceneGraph()
+{
+}
+
+DisplaySync MediaPlayer::displaySync() const
+{
+    return m_displaySync;
+}
+
+void MediaPlayer::setDisplaySync(const DisplaySync value)
+{
+    if (m_displaySync == value) {
+        return;
+    }
+    m_displaySync = value;
+    qCDebug(lcQMPPlayer) << "Display sync -->" << m_displaySync;
+    Q_EMIT displaySyncChanged();
+    applyDisplaySync();
+}
+
+qreal MediaPlayer::displayRefreshRate() const
+{
+    return m_displayRefreshRate;
+}
+
+qreal MediaPlayer::vsyncJitter() const
+{
+    return m_vsyncJitter;
+}
+
+void MediaPlayer::applyDisplaySync()
+{
+}
+
+DisplaySync MediaPlayer::effectiveDisplaySync(const qreal videoFrameRate) const
+{
+    if (m_displaySync != DisplaySync::Auto) {
+        return m_displaySync;
+    }
+    if ((m_displayRefreshRate <= 0.0) || (videoFrameRate <= 0.0)) {
+        return DisplaySync::Off;
+    }
+    // The display can't show every frame anyway, locking to it makes no sense.
+    if (videoFrameRate > (m_displayRefreshRate * (1.0 + kMaximumRefreshRateDeviation))) {
+        return DisplaySync::Off;
+    }
+    // Each frame is shown for the same number of refreshes (24 fps on 120 Hz, 60 fps
+    // on 60 Hz, 23.976 fps on 24 Hz etc), a tiny speed change makes the timing perfect.
+    const qreal repeatCount = std::round(m_displayRefreshRate / videoFrameRate);
+    const qreal deviation = qAbs(m_displayRefreshRate - (repeatCount * videoFrameRate)) / m_displayRefreshRate;
+    if (deviation <= kMaximumRefreshRateDeviation) {
+        return DisplaySync::Resample;
+    }
+    // Uneven cadence (24 fps on 60 Hz etc), keep the audio untouched and repeat frames instead.
+    return DisplaySync::FrameDrop;
+}
+
+void MediaPlayer::updateDisplayRefreshRate()
+{
+    QScreen *screen = (m_sceneWindow ? getCurrentScreen(m_sceneWindow) : nullptr);
+    if (m_refreshRateScreen != screen) {
+        if (m_refreshRateScreen) {
+            disconnect(m_refreshRateScreen, &QScreen::refreshRateChanged, this, &MediaPlayer::updateDisplayRefreshRate);
+        }
+        m_refreshRateScreen = screen;
+        if (m_refreshRateScreen) {
+            connect(m_refreshRateScreen, &QScreen::refreshRateChanged, this, &MediaPlayer::updateDisplayRefreshRate);
+        }
+    }
+    const qreal refreshRate = (screen ? screen->refreshRate() : 0.0);
+    if (qFuzzyCompare(m_displayRefreshRate, refreshRate)) {
+        return;
+    }
+    m_displayRefreshRate = refreshRate;
+    m_swapPeriod.store((refreshRate > 0.0) ? (1000.0 / refreshRate) : 0.0);
+    qCDebug(lcQMPPlayer) << "Display refresh rate -->" << m_displayRefreshRate << "Hz";
+    Q_EMIT displayRefreshRateChanged();
+    applyDisplaySync();
+}
+
+void MediaPlayer::measureFrameSwap()
+{
+    if (!m_swapTimer.isValid()) {
+        m_swapTimer.start();
+    }
+    const qint64 now = m_swapTimer.nsecsElapsed();
+    const qint64 lastSwapTime = std::exchange(m_lastSwapTime, now);
+    const qreal period = m_swapPeriod.load();
+    if ((lastSwapTime < 0) || (period <= 0.0)) {
+        return;
+    }
+    const qreal interval = qreal(now - lastSwapTime) / 1000000.0;
+    if (interval > (period * kMaximumSwapGap)) {
+        return;
+    }
+    // Presenting every second refresh is fine, only the distance from the vsync grid matters.
+    const qreal deviation = interval - (qMax(qreal(1.0), std::round(interval / period)) * period);
+    if (m_swapDeviations.size() < kSwapSampleCount) {
+        m_swapDeviations.append(deviation);
+    } else {
+        m_swapDeviations[m_swapDeviationIndex] = deviation;
+        m_swapDeviationIndex = ((m_swapDeviationIndex + 1) % kSwapSampleCount);
+    }
+    if (++m_swapsSincePublish < kSwapPublishInterval) {
+        return;
+    }
+    m_swapsSincePublish = 0;
+    qreal sum = 0.0;
+    qreal squareSum = 0.0;
+    for (auto &&value : qAsConst(m_swapDeviations)) {
+        sum += value;
+        squareSum += (value * value);
+    }
+    const qreal count = m_swapDeviations.size();
+    const qreal mean = (sum / count);
+    const qreal jitter = std::sqrt(qMax(qreal(0.0), (squareSum / count) - (mean * mean)));
+    QMetaObject::invokeMethod(this, [this, jitter](){
+        // Don't flood the bindings with meaningless changes.
+        if (qAbs(m_vsyncJitter - jitter) < 0.01) {
+            return;
+        }
+        m_vsyncJitter = jitter;
+        Q_EMIT vsyncJitterChanged();
+    }, Qt::QueuedConnection);
+}
+
+void MediaPlayer::itemChange(const ItemChange change, const ItemChangeData &value)
+{
+    QQuickItem::itemChange(change, value);
+    if (change != ItemSceneChange) {
+        return;
+    }
+    // Only our own connections, the window may be connected to this item for
+    // other reasons as well.
+    for (auto &&connection : qAsConst(m_sceneWindowConnections)) {
+        disconnect(connection);
+    }
+    m_sceneWindowConnections.clear();
+    m_sceneWindow = value.window;
+    updateDisplayRefreshRate();
+    if (!m_sceneWindow) {
+        return;
+    }
+    // Whether the graphics resources and the scene graph survive a hidden window
+    // is up to the application, the window is shared with everything else in it.
+    m_sceneWindowConnections.append(connect(m_sceneWindow, &QQuickWindow::sceneGraphInvalidated,
+        this, &MediaPlayer::invalidateSceneGraph, Qt::DirectConnection));
+    // Emitted on the render thread.
+    m_sceneWindowConnections.append(connect(m_sceneWindow, &QQuickWindow::frameSwapped, this, [this](){
+        measureFrameSwap();
+    }, Qt::DirectConnection));
+    m_sceneWindowConnections.append(connect(m_sceneWindow, &QQuickWindow::screenChanged,
+        this, &MediaPlayer::updateDisplayRefreshRate));
+}
+
+// The NOTIFY signal of each change, in the order they are delivered in: the
+// media first, its content next, the state of the playback last.
+static const std::pair<PropertyChange, void (MediaPlayer::*)()> kChangeSignals[] = {
+    {PropertyChange::Source, &MediaPlayer::sourceChanged},
+    {PropertyChange::FileName, &MediaPlayer::fileNameChanged},
+    {PropertyChange::FilePath, &MediaPlayer::filePathChanged},
+    {PropertyChange::Duration, &MediaPlayer::durationChanged},
+    {PropertyChange::Seekable, &MediaPlayer::seekableChanged},
+    {PropertyChange::VideoSize, &MediaPlayer::videoSizeChanged},
+    {PropertyChange::AspectRatio, &MediaPlayer::aspectRatioChanged},
+    {PropertyChange::Chapters, &MediaPlayer::chaptersChanged},
+    {PropertyChange::MetaData, &MediaPlayer::metaDataChanged},
+    {PropertyChange::MediaTracks, &MediaPlayer::mediaTracksChanged},
+    {PropertyChange::ActiveVideoTrack, &MediaPlayer::activeVideoTrackChanged},
+    {PropertyChange::ActiveAudioTrack, &MediaPlayer::activeAudioTrackChanged},
+    {PropertyChange::ActiveSubtitleTrack, &MediaPlayer::activeSubtitleTrackChanged},
+    {PropertyChange::HardwareDecoding, &MediaPlayer::hardwareDecodingChanged},
+    {PropertyChange::Volume, &MediaPlayer::volumeChanged},
+    {PropertyChange::Mute, &MediaPlayer::muteChanged},
+    {PropertyChange::PlaybackRate, &MediaPlayer::playbackRateChanged},
+    {PropertyChange::FillMode, &MediaPlayer::fillModeChanged},
+    {PropertyChange::SnapshotDirectory, &MediaPlayer::snapshotDirectoryChanged},
+    {PropertyChange::SnapshotFormat, &MediaPlayer::snapshotFormatChanged},
+    {PropertyChange::SnapshotTemplate, &MediaPlayer::snapshotTemplateChanged},
+    {PropertyChange::MediaStatus, &MediaPlayer::mediaStatusChanged},
+    {PropertyChange::PlaybackState, &MediaPlayer::playbackStateChanged},
+    {PropertyChange::Position, &MediaPlayer::positionChanged}
+};
+
+void MediaPlayer::notifyChanged(const PropertyChanges changes)
+{
+    if (!changes) {
+        return;
+    }
+    // Without the batching, every reported change would have been a signal of its own.
+    if (lcQMPPlayer().isDebugEnabled()) {
+        m_reportedChanges.fetch_add(qPopulationCount(quint32(changes)));
+    }
+    // Only the first change of a batch schedules its delivery, the others just
+    // join it. A change racing with the delivery starts the next batch.
+    const quint32 previous = m_pendingChanges.fetch_or(quint32(changes));
+    if (previous == 0) {
+        QMetaObject::invokeMethod(this, &MediaPlayer::flushChanges, Qt::QueuedConnection);
+    }
+}
+
+void MediaPlayer::flushChanges()
+{
+    const PropertyChanges changes = PropertyChanges(m_pendingChanges.exchange(0));
+    if (!changes) {
+        return;
+    }
+    for (auto &&entry : kChangeSignals) {
+        if (changes.testFlag(entry.first)) {
+            Q_EMIT (this->*entry.second)();
+        }
+    }
+    if (!lcQMPPlayer().isDebugEnabled()) {
+        return;
+    }
+    m_emittedChanges += qPopulationCount(quint32(changes));
+    if (!m_changeStatsTimer.isValid()) {
+        m_changeStatsTimer.start();
+        return;
+    }
+    const qint64 elapsed = m_changeStatsTimer.elapsed();
+    if (elapsed < kChangeStatsInterval) {
+        return;
+    }
+    const qreal reported = (qreal(m_reportedChanges.exchange(0)) * 1000.0 / qreal(elapsed));
+    const qreal emitted = (qreal(std::exchange(m_emittedChanges, 0)) * 1000.0 / qreal(elapsed));
+    qCDebug(lcQMPPlayer) << "Change notifications per second:" << reported << "reported by the backend,"
+                         << emitted << "signals emitted.";
+    m_changeStatsTimer.restart();
+}
+
+PropertyChanges MediaPlayer::signalChange(const QMetaMethod &signal)
+{
+    for (auto &&entry : kChangeSignals) {
+        if (signal == QMetaMethod::fromSignal(entry.second)) {
+            return entry.first;
+        }
+    }
+    return {};
+}
+
+bool MediaPlayer::hasChangeListeners(const PropertyChanges changes) const
+{
+    for (auto &&entry : kChangeSignals) {
+        if (changes.testFlag(entry.first) && isSignalConnected(QMetaMethod::fromSignal(entry.second))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MediaPlayer::startFirstFrameTimer()
+{
+    m_transitionPending.store(false);
+    m_firstFrameWarmPending.store(rendererReady() || m_shaderCacheWarm);
+    m_firstFrameStartTime.store(QDeadlineTimer::current().deadline());
+}
+
+void MediaPlayer::setShaderCacheWarm(const bool value)
+{
+    m_shaderCacheWarm = value;
+}
+
+bool MediaPlayer::firstFrameWarm() const
+{
+    return m_firstFrameWarm;
+}
+
+void MediaPlayer::startTransitionTimer()
+{
+    m_transitionPending.store(true);
+    m_firstFrameStartTime.store(QDeadlineTimer::current().deadline());
+}
+
+void MediaPlayer::reportFirstFrame()
+{
+    const qint64 startTime = m_firstFrameStartTime.exchange(-1);
+    if (startTime < 0) {
+        return;
+    }
+    const qreal latency = qreal(QDeadlineTimer::current().deadline() - startTime);
+    if (m_transitionPending.exchange(false)) {
+        qCDebug(lcQMPPlayer) << "Switched to the next media in" << latency << "ms.";
+        QMetaObject::invokeMethod(this, [this, latency](){
+            m_transitionGap = latency;
+            Q_EMIT transitionGapChanged();
+        }, Qt::QueuedConnection);
+        return;
+    }
+    const bool warm = m_firstFrameWarmPending.load();
+    qCDebug(lcQMPPlayer) << "First frame rendered in" << latency << "ms" << (warm ? "(warm)." : "(cold).");
+    // May be called on the render thread.
+    QMetaObject::invokeMethod(this, [this, latency, warm](){
+        m_firstFrameLatency = latency;
+        m_firstFrameWarm = warm;
+        Q_EMIT firstFrameLatencyChanged();
+    }, Qt::QueuedConnection);
+}
+
+qint64 MediaPlayer::takeStartPosition()
+{
+    return std::exchange(m_startPosition, 0);
+}
+
+qreal MediaPlayer::firstFrameLatency() const
+{
+    return m_firstFrameLatency;
+}
+
 QTMEDIAPLAYER_END_NAMESPACE
@@ -25,10 +25,28 @@
 #pragma once
 
 #include "playertypes.h"
+#include "performanceprofile.h"
+#include <QtCore/qpointer.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qsharedpointer.h>
 #include <QtQuick/qquickitem.h>
+#include <atomic>
+
+QT_BEGIN_NAMESPACE
+QT_FORWARD_DECLARE_CLASS(QScreen)
+QT_FORWARD_DECLARE_CLASS(QTimer)
+QT_END_NAMESPACE
 
 QTMEDIAPLAYER_BEGIN_NAMESPACE
 
+Q_DECLARE_LOGGING_CATEGORY(lcQMPPlayer)
+
+class KeyframeIndex;
+class SeekScheduler;
+class QualityController;
+class DecoderBenchmarker;
+struct DecoderConfig;
+
 static const QString hardwareDecodingWarningText =
     QStringLiteral("ATTENTION! You are trying to enable hardware decoding. "
                    "While enabling hardware decoding MAY reduce resource consumption, "
@@ -39,6 +57,7 @@ class MediaPlayer : public QQuickItem
 {
     Q_OBJECT
     Q_DISABLE_COPY_MOVE(MediaPlayer)
+    friend class ResourceGovernor;
 #ifdef QML_NAMED_ELEMENT
     QML_NAMED_ELEMENT(MediaPlayer)
 #endif
@@ -88,6 +107,50 @@ class MediaPlayer : public QQuickItem
     Q_PROPERTY(QSizeF recommendedWindowSize READ recommendedWindowSize NOTIFY recommendedWindowSizeChanged)
     Q_PROPERTY(QPointF recommendedWindowPosition READ recommendedWindowPosition NOTIFY recommendedWindowPositionChanged)
     Q_PROPERTY(bool rendererReady READ rendererReady NOTIFY rendererReadyChanged)
+    Q_PROPERTY(DisplaySync displaySync READ displaySync WRITE setDisplaySync NOTIFY displaySyncChanged)
+    Q_PROPERTY(qreal displayRefreshRate READ displayRefreshRate NOTIFY displayRefreshRateChanged)
+    Q_PROPERTY(qreal vsyncJitter READ vsyncJitter NOTIFY vsyncJitterChanged)
+    Q_PROPERTY(bool keyframeIndexReady READ keyframeIndexReady NOTIFY keyframeIndexChanged)
+    Q_PROPERTY(int frameCount READ frameCount NOTIFY keyframeIndexChanged)
+    Q_PROPERTY(bool scrubbing READ scrubbing WRITE setScrubbing NOTIFY scrubbingChanged)
+    Q_PROPERTY(qreal seekLatency READ seekLatency NOTIFY seekLatencyChanged)
+    Q_PROPERTY(qreal firstFrameLatency READ firstFrameLatency NOTIFY firstFrameLatencyChanged)
+    Q_PROPERTY(bool firstFrameWarm READ firstFrameWarm NOTIFY firstFrameLatencyChanged)
+    Q_PROPERTY(int frameCacheSize READ frameCacheSize WRITE setFrameCacheSize NOTIFY frameCacheSizeChanged)
+    Q_PROPERTY(qreal trickPlayThreshold READ trickPlayThreshold WRITE setTrickPlayThreshold NOTIFY trickPlayThresholdChanged)
+    Q_PROPERTY(bool trickPlay READ trickPlay NOTIFY trickPlayChanged)
+    Q_PROPERTY(qint64 loopStart READ loopStart NOTIFY loopRangeChanged)
+    Q_PROPERTY(qint64 loopEnd READ loopEnd NOTIFY loopRangeChanged)
+    Q_PROPERTY(int loopCacheSize READ loopCacheSize WRITE setLoopCacheSize NOTIFY loopCacheSizeChanged)
+    Q_PROPERTY(int prefetchSize READ prefetchSize WRITE setPrefetchSize NOTIFY prefetchSizeChanged)
+    Q_PROPERTY(QList<QUrl> queue READ queue WRITE setQueue NOTIFY queueChanged)
+    Q_PROPERTY(qreal transitionGap READ transitionGap NOTIFY transitionGapChanged)
+    Q_PROPERTY(int decoderThreads READ decoderThreads WRITE setDecoderThreads NOTIFY decoderThreadsChanged)
+    Q_PROPERTY(int cacheSize READ cacheSize WRITE setCacheSize NOTIFY cacheSizeChanged)
+    Q_PROPERTY(int readAheadTime READ readAheadTime WRITE setReadAheadTime NOTIFY readAheadTimeChanged)
+    Q_PROPERTY(int backBufferSize READ backBufferSize WRITE setBackBufferSize NOTIFY backBufferSizeChanged)
+    Q_PROPERTY(bool diskCache READ diskCache WRITE setDiskCache NOTIFY diskCacheChanged)
+    Q_PROPERTY(QVariantList bufferedRanges READ bufferedRanges NOTIFY bufferedRangesChanged)
+    Q_PROPERTY(qint64 inputRate READ inputRate NOTIFY cacheStatisticsChanged)
+    Q_PROPERTY(int underrunCount READ underrunCount NOTIFY cacheStatisticsChanged)
+    Q_PROPERTY(PerformanceProfile performanceProfile READ performanceProfile WRITE setPerformanceProfile NOTIFY performanceProfileChanged)
+    Q_PROPERTY(bool videoDecodingEnabled READ videoDecodingEnabled WRITE setVideoDecodingEnabled NOTIFY videoDecodingEnabledChanged)
+    Q_PROPERTY(bool suspended READ suspended NOTIFY suspendedChanged)
+    Q_PROPERTY(bool standby READ standby WRITE setStandby NOTIFY standbyChanged)
+    Q_PROPERTY(int idleSuspendTimeout READ idleSuspendTimeout WRITE setIdleSuspendTimeout NOTIFY idleSuspendTimeoutChanged)
+    Q_PROPERTY(qint64 memoryBeforeSuspend READ memoryBeforeSuspend NOTIFY suspensionMemoryChanged)
+    Q_PROPERTY(qint64 memoryAfterSuspend READ memoryAfterSuspend NOTIFY suspensionMemoryChanged)
+    Q_PROPERTY(PlayerPriority priority READ priority WRITE setPriority NOTIFY priorityChanged)
+    Q_PROPERTY(qint64 memoryUsage READ memoryUsage NOTIFY memoryUsageChanged)
+    Q_PROPERTY(qint64 estimatedFrameMemory READ estimatedFrameMemory NOTIFY estimatedFrameMemoryChanged)
+    Q_PROPERTY(bool autoSelectDecoder READ autoSelectDecoder WRITE setAutoSelectDecoder NOTIFY autoSelectDecoderChanged)
+    Q_PROPERTY(bool adaptiveQuality READ adaptiveQuality WRITE setAdaptiveQuality NOTIFY adaptiveQualityChanged)
+    Q_PROPERTY(QualityTier qualityTier READ qualityTier NOTIFY qualityTierChanged)
+    Q_PROPERTY(DecodeQuality decodeQuality READ decodeQuality WRITE setDecodeQuality NOTIFY decodeQualityChanged)
+    Q_PROPERTY(QString audioOutput READ audioOutput WRITE setAudioOutput NOTIFY audioOutputChanged)
+    Q_PROPERTY(int audioBufferSize READ audioBufferSize WRITE setAudioBufferSize NOTIFY audioBufferSizeChanged)
+    Q_PROPERTY(int audioPeriodSize READ audioPeriodSize WRITE setAudioPeriodSize NOTIFY audioPeriodSizeChanged)
+    Q_PROPERTY(bool lowLatencyAudio READ lowLatencyAudio WRITE setLowLatencyAudio NOTIFY lowLatencyAudioChanged)
 
 public:
     explicit MediaPlayer(QQuickItem *parent = nullptr);
@@ -281,13 +344,233 @@ public:
 
     Q_NODISCARD virtual bool rendererReady() const = 0;
 
+    Q_NODISCARD DisplaySync displaySync() const;
+    void setDisplaySync(const DisplaySync value);
+
+    // In Hz, zero if unknown.
+    Q_NODISCARD qreal displayRefreshRate() const;
+
+    // Standard deviation of the buffer swap intervals from the vsync grid, in milliseconds.
+    Q_NODISCARD qreal vsyncJitter() const;
+
+    // The key frame index of local files is built in the background once they are opened.
+    Q_NODISCARD bool keyframeIndexReady() const;
+
+    // Number of video frames, zero without a key frame index.
+    Q_NODISCARD int frameCount() const;
+
+    // Set while the user drags the position slider. Automatic seeks are fast
+    // key frame seeks meanwhile, releasing it seeks exactly to the last position.
+    Q_NODISCARD bool scrubbing() const;
+    void setScrubbing(const bool value);
+
+    // Time the most recent seek took to complete, in milliseconds.
+    Q_NODISCARD qreal seekLatency() const;
+
+    // Time from opening the current media until its first frame (at the start
+    // position) was rendered, in milliseconds.
+    Q_NODISCARD qreal firstFrameLatency() const;
+    // Whether that measurement started warm: with a renderer already set up, or
+    // with compiled shaders in the disk cache. Cold starts include creating the
+    // renderer and compiling all the shaders.
+    // The renderer only survives a hidden window if the application makes the
+    // window's graphics resources and scene graph persistent, see
+    // "QQuickWindow::setPersistentGraphics()" and "setPersistentSceneGraph()".
+    Q_NODISCARD bool firstFrameWarm() const;
+
+    // Memory (in megabytes) for decoded frames kept around for stepping and
+    // playing backwards.
+    Q_NODISCARD int frameCacheSize() const;
+    void setFrameCacheSize(const int value);
+
+    // From this playback rate on (in either direction), only key frames are
+    // decoded and the audio is cheapened, so that the CPU load stays bounded.
+    // Zero disables trick play.
+    Q_NODISCARD qreal trickPlayThreshold() const;
+    void setTrickPlayThreshold(const qreal value);
+
+    Q_NODISCARD bool trickPlay() const;
+
+    // The A-B loop range in milliseconds, both are -1 without a loop.
+    Q_NODISCARD qint64 loopStart() const;
+    Q_NODISCARD qint64 loopEnd() const;
+
+    // Memory (in megabytes) for keeping the looped segment around, so that
+    // restarting the loop needs no I/O.
+    Q_NODISCARD int loopCacheSize() const;
+    void setLoopCacheSize(const int value);
+
+    // Upper bound (in megabytes) of the data read ahead by "prefetchAt()".
+    Q_NODISCARD int prefetchSize() const;
+    void setPrefetchSize(const int value);
+
+    // The media to play after the current one, in order. The first one is
+    // preloaded while the current one plays and follows it without a gap.
+    Q_NODISCARD QList<QUrl> queue() const;
+    void setQueue(const QList<QUrl> &value);
+
+    // Time between the end of the previous queued media and the first frame
+    // of the next one, in milliseconds.
+    Q_NODISCARD qreal transitionGap() const;
+
+    // Number of threads used for decoding the video. Zero lets the backend decide.
+    Q_NODISCARD int decoderThreads() const;
+    void setDecoderThreads(const int value);
+
+    // Upper bound (in megabytes) of the demuxed data buffered, ahead of and
+    // behind the playback position together. Zero lets the backend decide.
+    Q_NODISCARD int cacheSize() const;
+    void setCacheSize(const int value);
+
+    // How far (in milliseconds) the demuxer reads ahead at least. -1 leaves it
+    // to the performance profile.
+    Q_NODISCARD int readAheadTime() const;
+    void setReadAheadTime(const int value);
+
+    // Upper bound (in megabytes) of the demuxed data kept behind the playback
+    // position, for fast backward seeks. Zero lets the backend decide. Taken
+    // out of a limited cache size, like the loop cache, never added on top of
+    // it. MDK keeps nothing behind and ignores it.
+    Q_NODISCARD int backBufferSize() const;
+    void setBackBufferSize(const int value);
+
+    // Buffer the demuxed data in a temporary file instead of the memory, which
+    // allows much larger caches for slow sources. mpv only.
+    Q_NODISCARD bool diskCache() const;
+    void setDiskCache(const bool value);
+
+    // The buffered parts of the media, as objects with "start" and "end" (in
+    // milliseconds). Updated at most twice a second, like the statistics below.
+    Q_NODISCARD QVariantList bufferedRanges() const;
+
+    // Bytes per second read from the source, -1 if unknown.
+    Q_NODISCARD qint64 inputRate() const;
+
+    // How often the playback ran out of buffered data for the current media.
+    Q_NODISCARD int underrunCount() const;
+
+    // Buffering, frame dropping, scripts, decoder threads and seek precision
+    // at once. "Custom" can only be set by "loadPerformanceProfile()".
+    Q_NODISCARD PerformanceProfile performanceProfile() const;
+    void setPerformanceProfile(const PerformanceProfile value);
+
+    // Background mode: without video decoding only the audio plays on, the last
+    // frame stays on the screen and nothing is rendered. Enabling it again
+    // continues at the current position, without reloading the media.
+    Q_NODISCARD bool videoDecodingEnabled() const;
+    void setVideoDecodingEnabled(const bool value);
+
+    Q_NODISCARD bool suspended() const;
+
+    // A hidden player which is only kept ready to be shown, see "StreamSwitcher".
+    // It goes on decoding, but renders nothing until it's shown again.
+    Q_NODISCARD bool standby() const;
+    void setStandby(const bool value);
+
+    // Whether the texture node renders new frames, read while syncing. Otherwise
+    // it keeps the last one.
+    Q_NODISCARD bool renderingEnabled() const;
+
+    // A player which stays paused for this many milliseconds is suspended
+    // automatically. Zero disables it.
+    Q_NODISCARD int idleSuspendTimeout() const;
+    void setIdleSuspendTimeout(const int value);
+
+    // Memory (in bytes) the backend reports for this player right before the last
+    // suspension and shortly after it, -1 if unknown: the same figure as
+    // "memoryUsage". The difference is what the suspension gave back. The frame
+    // queues of the decoders are not included, no backend can tell their size,
+    // see "estimatedFrameMemory".
+    Q_NODISCARD qint64 memoryBeforeSuspend() const;
+    Q_NODISCARD qint64 memoryAfterSuspend() const;
+
+    // Decides the share of the process wide resources, see "ResourceGovernor".
+    Q_NODISCARD PlayerPriority priority() const;
+    void setPriority(const PlayerPriority value);
+
+    // Use the fastest software decoder configuration for the codec of the media,
+    // see "DecoderCalibration". The first media of every codec is only used
+    // to calibrate it in the background. Takes effect with the next media and
+    // never while hardware decoding is enabled.
+    Q_NODISCARD bool autoSelectDecoder() const;
+    void setAutoSelectDecoder(const bool value);
+
+    // Trade quality for smooth playback when the machine can't keep up: the
+    // quality tier steps down while frames get dropped, and back up once
+    // there's headroom again. Without it, the tier is always "Full".
+    Q_NODISCARD bool adaptiveQuality() const;
+    void setAdaptiveQuality(const bool value);
+    Q_NODISCARD QualityTier qualityTier() const;
+
+    // A fixed trade of quality for decoding cost, for previews and small tiles
+    // which never show the video at its full size. The adaptive quality tier
+    // can only lower it further.
+    Q_NODISCARD DecodeQuality decodeQuality() const;
+    void setDecodeQuality(const DecodeQuality value);
+
+    // The audio output driver, in the backend's own terms (for example "alsa" or
+    // "wasapi" for mpv, "ALSA" or "XAudio2" for MDK). Empty lets the backend decide.
+    Q_NODISCARD QString audioOutput() const;
+    void setAudioOutput(const QString &value);
+
+    // Audio queued for the device (in milliseconds), and the size of the chunks
+    // it's written in. Smaller means less latency but more dropouts under load.
+    // Zero lets the backend decide. The period is only honored by mpv's ALSA
+    // output, MDK ignores both.
+    Q_NODISCARD int audioBufferSize() const;
+    void setAudioBufferSize(const int value);
+    Q_NODISCARD int audioPeriodSize() const;
+    void setAudioPeriodSize(const int value);
+
+    // Live monitoring: shallow audio buffers unless they are set explicitly.
+    Q_NODISCARD bool lowLatencyAudio() const;
+    void setLowLatencyAudio(const bool value);
+
+    // Memory (in bytes) held by the demuxer cache of this player, including the
+    // back buffer, and by the decoded frames the backend caches itself. Polled
+    // by the resource governor about once a second, -1 if the backend can't tell.
+    Q_NODISCARD qint64 memoryUsage() const;
+
+    // Not measured: the decoded frames the decoders of this player keep alive,
+    // guessed from the video size. Zero while suspended or without video
+    // decoding, -1 if unknown. Updated together with "memoryUsage" and when the
+    // player gets suspended or resumed.
+    Q_NODISCARD qint64 estimatedFrameMemory() const;
+
 public Q_SLOTS:
     virtual void play() = 0;
     void play(const QUrl &url);
-    void open(const QUrl &url);
+    // The first decoded frame is the one at "startPosition" (in milliseconds),
+    // nothing before it gets decoded or rendered.
+    void open(const QUrl &url, const qint64 startPosition = 0);
     virtual void pause() = 0;
     virtual void stop() = 0;
-    virtual void seek(const qint64 value) = 0;
+    // Requests are coalesced, only the latest one matters while a seek is running.
+    void seek(const qint64 value, const SeekMode mode = SeekMode::Auto);
+    // Seeks to the key frame closest to the given position, which needs no decoding
+    // of frames in between. Falls back to a key frame seek without a key frame index.
+    void seekToKeyframe(const qint64 value);
+    void seekToFrame(const int frame);
+    // Both pause the playback and show the next/previous frame.
+    virtual void stepForward() = 0;
+    virtual void stepBackward() = 0;
+    // Repeats the given range (in milliseconds) until cleared.
+    void setLoopRange(const qint64 start, const qint64 end);
+    void clearLoopRange();
+    // Warms up the caches around the given position (in milliseconds) in the
+    // background, so that seeking there soon after needs no disk or network
+    // round trip. A new call replaces the previous one.
+    void prefetchAt(const qint64 value);
+    void cancelPrefetch();
+    void enqueue(const QUrl &url);
+    void clearQueue();
+    // Skips the rest of the current media.
+    void playNext();
+    // Releases the decoders and buffers of a loaded media. The media, the
+    // position and the track selection are kept, the last frame stays on the
+    // screen. Resuming continues exactly where it was suspended.
+    void suspend();
+    void resume();
     virtual void snapshot() = 0;
 
 public:
@@ -307,6 +590,174 @@ public:
     Q_NODISCARD Q_INVOKABLE bool isPlayingVideo() const;
     Q_NODISCARD Q_INVOKABLE bool isPlayingAudio() const;
 
+    // Frames presented and dropped since the media was opened, as counted by the
+    // backend, -1 if unknown. Queried on every call, there's no change signal.
+    Q_NODISCARD Q_INVOKABLE qint64 presentedFrames();
+    Q_NODISCARD Q_INVOKABLE qint64 droppedFrames();
+
+    // Exact mapping between frame numbers and positions (in milliseconds). They
+    // return -1 if the key frame index is not available (yet).
+    Q_NODISCARD Q_INVOKABLE qint64 frameToTimestamp(const int frame) const;
+    Q_NODISCARD Q_INVOKABLE int timestampToFrame(const qint64 value) const;
+    Q_NODISCARD Q_INVOKABLE qint64 keyframeBefore(const qint64 value) const;
+    Q_NODISCARD Q_INVOKABLE qint64 keyframeAfter(const qint64 value) const;
+
+    // Switches to the custom profile in the given JSON file, see "parsePerformanceSettings()".
+    Q_INVOKABLE bool loadPerformanceProfile(const QUrl &url);
+
+protected Q_SLOTS:
+    // Called on the render thread when the scene graph is invalidated.
+    virtual void invalidateSceneGraph();
+
+protected:
+    void itemChange(const ItemChange change, const ItemChangeData &value) override;
+
+    // Can be called from any thread. All the changes queued up until the event
+    // loop runs next are delivered at once on the GUI thread, each NOTIFY signal
+    // only once. Backends use it for everything their callbacks and property
+    // observers report.
+    void notifyChanged(const PropertyChanges changes);
+    // The change a NOTIFY signal reports, none for all other signals.
+    Q_NODISCARD static PropertyChanges signalChange(const QMetaMethod &signal);
+    // Whether anything is connected to the NOTIFY signal of any of the given changes.
+    Q_NODISCARD bool hasChangeListeners(const PropertyChanges changes) const;
+
+    // Time-to-first-frame measurement. Start it on the GUI thread when a new
+    // media is being opened, report it from whichever thread draws the frame.
+    void startFirstFrameTimer();
+    void reportFirstFrame();
+    // Backends report whether their shader cache had any content at startup.
+    void setShaderCacheWarm(const bool value);
+
+    // The position the media being opened should start at. Backends take it
+    // when they load a new media, it's only valid once.
+    Q_NODISCARD qint64 takeStartPosition();
+
+    // Called whenever the display sync mode or the display refresh rate changes.
+    virtual void applyDisplaySync();
+
+    // Resolves DisplaySync::Auto against the given video frame rate.
+    Q_NODISCARD DisplaySync effectiveDisplaySync(const qreal videoFrameRate) const;
+
+    // Starts a seek on behalf of the seek scheduler. Returns false if that's not
+    // possible right now. Backends must call "seekFinished()" once it's done.
+    virtual bool doSeek(const qint64 value, const bool exact) = 0;
+    void seekFinished();
+
+    // Frame steps for backends which can't step while seeking. "requestStep()"
+    // queues the step behind the running seek, "doStep()" starts it on behalf
+    // of the seek scheduler and finishes like "doSeek()". The default can't step.
+    void requestStep(const int frames);
+    virtual bool doStep(const int frames);
+
+    // Whether a new seek cancels the running one, so it can be issued right away.
+    Q_NODISCARD virtual bool canInterruptSeek() const;
+
+    // Called whenever the frame cache size changes.
+    virtual void applyFrameCacheSize();
+
+    // Called whenever trick play starts or stops.
+    virtual void applyTrickPlay();
+
+    // Called whenever the loop range or the loop cache size changes.
+    virtual void applyLoopRange();
+
+    // Whether the backend can already seek to the given position without any I/O,
+    // prefetching it is skipped in that case.
+    Q_NODISCARD virtual bool isPositionCached(const qint64 value) const;
+
+    // The media to preload, invalid if the queue is empty.
+    Q_NODISCARD QUrl nextMedia() const;
+    // Called whenever "nextMedia()" changes.
+    virtual void applyNextMedia();
+    // Backends call these when they switch to "nextMedia()" by themselves: the
+    // timer right when the previous media ended (from any thread), advancing
+    // the queue once the next media became the current one.
+    void startTransitionTimer();
+    void advanceQueue();
+
+    // Called whenever the decoder thread count or any of the cache settings change.
+    virtual void applyResourceLimits();
+
+    // The number of decoder threads to use: the "decoderThreads" property if it's
+    // set, otherwise the share assigned by the resource governor, capped by the
+    // performance profile. Zero lets the backend decide.
+    Q_NODISCARD int effectiveDecoderThreads() const;
+    // The cache size (in megabytes) to use: the smaller one of the "cacheSize"
+    // property and the share of the memory budget. Zero lets the backend decide.
+    Q_NODISCARD int effectiveCacheSize() const;
+
+    // The "readAheadTime" property if it's set, otherwise the one of the
+    // performance profile. -1 lets the backend decide.
+    Q_NODISCARD qint64 effectiveReadAheadTime() const;
+
+    // Current size (in bytes) of the demuxer cache and of the frames the backend
+    // caches on top of its decoders, as reported by the backend, -1 if unknown.
+    Q_NODISCARD virtual qint64 queryMemoryUsage() const;
+
+    // Estimated memory (in bytes) of the frame queues of the decoders, -1 if
+    // unknown. The default guesses it from the video size.
+    Q_NODISCARD virtual qint64 queryFrameMemoryUsage() const;
+
+    // Polled about twice a second while a media is open.
+    Q_NODISCARD virtual CacheState queryCacheState();
+
+    // Null if the backend can't calibrate its decoders. Used on a worker thread.
+    Q_NODISCARD virtual DecoderBenchmarker *createDecoderBenchmarker() const;
+
+    // Polled about once a second while playing with "adaptiveQuality".
+    Q_NODISCARD virtual FrameStatistics queryFrameStatistics();
+    // The sum of the decode quality, the quality tier and trick play.
+    Q_NODISCARD DecodeShortcuts decodeShortcuts() const;
+    // Called whenever the decode quality or the quality tier changes.
+    virtual void applyDecodeQuality();
+
+    // Called whenever any of the audio output settings change.
+    virtual void applyAudioOutput();
+    // The "audioBufferSize" property if it's set, otherwise a shallow buffer in
+    // low latency mode. Zero lets the backend decide.
+    Q_NODISCARD int effectiveAudioBufferSize() const;
+    // The decoder configuration to use for the given codec. Starts calibrating
+    // it with the given media if that didn't happen yet. False means the
+    // backend's default, always the case without "autoSelectDecoder".
+    Q_NODISCARD bool selectDecoder(const QString &codec, const QUrl &url, DecoderConfig *config);
+
+    // The settings of the current performance profile, the ones of the preview
+    // profile in live preview mode.
+    Q_NODISCARD PerformanceSettings performanceSettings() const;
+    // Called whenever the performance profile changes. Backends apply all the
+    // settings at once, including the ones "applyResourceLimits()" depends on.
+    virtual void applyPerformanceProfile();
+
+    // Called whenever the video decoding gets enabled or disabled.
+    virtual void applyVideoDecoding();
+
+    // Called whenever the player gets suspended or resumed. When resuming, backends
+    // continue at the exact position the player was suspended at.
+    virtual void applySuspension();
+
+    // Null until the key frame index of the current media is ready.
+    Q_NODISCARD QSharedPointer<const KeyframeIndex> keyframeIndex() const;
+
+private Q_SLOTS:
+    void updateDisplayRefreshRate();
+    void rebuildKeyframeIndex();
+    void updateTrickPlay();
+    void startPrefetch();
+    void updateIdleTimer();
+    void updateCacheTimer();
+    void updateQualityController();
+    void updateCacheState();
+    void flushChanges();
+
+private:
+    // Called by the resource governor.
+    void updateMemoryUsage();
+    void updateEstimatedFrameMemory();
+
+    // Called on the render thread.
+    void measureFrameSwap();
+
 Q_SIGNALS:
     void loaded();
     void playing();
@@ -344,6 +795,140 @@ Q_SIGNALS:
     void recommendedWindowSizeChanged();
     void recommendedWindowPositionChanged();
     void rendererReadyChanged();
+    void displaySyncChanged();
+    void displayRefreshRateChanged();
+    void vsyncJitterChanged();
+    void keyframeIndexChanged();
+    void scrubbingChanged();
+    void seekLatencyChanged();
+    void firstFrameLatencyChanged();
+    void frameCacheSizeChanged();
+    void trickPlayThresholdChanged();
+    void trickPlayChanged();
+    void loopRangeChanged();
+    void loopCacheSizeChanged();
+    void prefetchSizeChanged();
+    void queueChanged();
+    void transitionGapChanged();
+    void decoderThreadsChanged();
+    void cacheSizeChanged();
+    void readAheadTimeChanged();
+    void backBufferSizeChanged();
+    void diskCacheChanged();
+    void bufferedRangesChanged();
+    void cacheStatisticsChanged();
+    void performanceProfileChanged();
+    void videoDecodingEnabledChanged();
+    void suspendedChanged();
+    void standbyChanged();
+    void idleSuspendTimeoutChanged();
+    void suspensionMemoryChanged();
+    void priorityChanged();
+    void autoSelectDecoderChanged();
+    void adaptiveQualityChanged();
+    void qualityTierChanged();
+    void decodeQualityChanged();
+    void audioOutputChanged();
+    void audioBufferSizeChanged();
+    void audioPeriodSizeChanged();
+    void lowLatencyAudioChanged();
+    void memoryUsageChanged();
+    void estimatedFrameMemoryChanged();
+
+private:
+    std::atomic<quint32> m_pendingChanges{0};
+    // Debug statistics: changes reported by the backend vs. signals emitted.
+    std::atomic<quint64> m_reportedChanges{0};
+    quint64 m_emittedChanges = 0;
+    QElapsedTimer m_changeStatsTimer;
+
+    QPointer<QQuickWindow> m_sceneWindow = nullptr;
+    QList<QMetaObject::Connection> m_sceneWindowConnections = {};
+    QPointer<QScreen> m_refreshRateScreen = nullptr;
+    std::atomic<qint64> m_firstFrameStartTime{-1};
+    qreal m_firstFrameLatency = 0.0;
+    std::atomic_bool m_firstFrameWarmPending{false};
+    bool m_firstFrameWarm = false;
+    bool m_shaderCacheWarm = false;
+    qint64 m_startPosition = 0;
+
+    DisplaySync m_displaySync = DisplaySync::Off;
+    qreal m_displayRefreshRate = 0.0;
+    qreal m_vsyncJitter = 0.0;
+    std::atomic<qreal> m_swapPeriod{0.0}; // In milliseconds, read on the render thread.
+
+    QSharedPointer<const KeyframeIndex> m_keyframeIndex;
+    QSharedPointer<std::atomic_bool> m_keyframeIndexCancelled;
+
+    SeekScheduler *m_seekScheduler = nullptr;
+    bool m_scrubbing = false;
+    qint64 m_scrubbingPosition = -1; // Last position requested while scrubbing.
+    qreal m_seekLatency = 0.0;
+
+    int m_frameCacheSize = 256;
+
+    qreal m_trickPlayThreshold = 4.0;
+    bool m_trickPlay = false;
+
+    qint64 m_loopStart = -1;
+    qint64 m_loopEnd = -1;
+    int m_loopCacheSize = 64;
+
+    int m_prefetchSize = 16;
+    qint64 m_prefetchPosition = -1;
+    QTimer *m_prefetchTimer = nullptr;
+    QSharedPointer<std::atomic_bool> m_prefetchCancelled;
+
+    QList<QUrl> m_queue = {};
+    std::atomic_bool m_transitionPending{false};
+    qreal m_transitionGap = 0.0;
+
+    int m_decoderThreads = 0;
+    int m_cacheSize = 0;
+    int m_readAheadTime = -1;
+    int m_backBufferSize = 0;
+    bool m_diskCache = false;
+
+    QTimer *m_cacheTimer = nullptr;
+    QVariantList m_bufferedRanges = {};
+    qint64 m_inputRate = -1;
+    int m_underrunCount = 0;
+    bool m_underrun = false;
+
+    PerformanceProfile m_performanceProfile = PerformanceProfile::Default;
+    PerformanceSettings m_performanceSettings = {};
+
+    bool m_videoDecodingEnabled = true;
+
+    bool m_suspended = false;
+    bool m_standby = false;
+    bool m_resumePlaying = false;
+    int m_idleSuspendTimeout = 0;
+    QTimer *m_idleTimer = nullptr;
+    qint64 m_memoryBeforeSuspend = -1;
+    qint64 m_memoryAfterSuspend = -1;
+
+    PlayerPriority m_priority = PlayerPriority::Normal;
+
+    bool m_autoSelectDecoder = false;
+
+    bool m_adaptiveQuality = false;
+    QualityController *m_qualityController = nullptr;
+    DecodeQuality m_decodeQuality = DecodeQuality::Full;
+
+    QString m_audioOutput = {};
+    int m_audioBufferSize = 0;
+    int m_audioPeriodSize = 0;
+    bool m_lowLatencyAudio = false;
+    qint64 m_memoryUsage = -1;
+    qint64 m_estimatedFrameMemory = -1;
+
+    // Render thread only.
+    QElapsedTimer m_swapTimer;
+    qint64 m_lastSwapTime = -1;
+    QList<qreal> m_swapDeviations = {};
+    int m_swapDeviationIndex = 0;
+    int m_swapsSincePublish = 0;
 };
 
 QTMEDIAPLAYER_END_NAMESPACE
@@ -77,6 +77,91 @@ enum class FillMode : int
 };
 Q_ENUM_NS(FillMode)
 
+enum class DisplaySync : int
+{
+    Off = 0,      // Video follows the audio clock, frames are shown whenever they are due.
+    Auto = 1,     // Pick one of the modes below based on the display refresh rate and the video frame rate.
+    Resample = 2, // Lock video to the display refresh, slightly resample audio to stay in sync.
+    FrameDrop = 3 // Lock video to the display refresh, drop or repeat frames to stay in sync.
+};
+Q_ENUM_NS(DisplaySync)
+
+enum class SeekMode : int
+{
+    Auto = 0,     // Keyframe while scrubbing, Exact otherwise.
+    Keyframe = 1, // Land on the closest key frame, fast but imprecise.
+    Exact = 2     // Land on the requested position, decodes from the previous key frame.
+};
+Q_ENUM_NS(SeekMode)
+
+enum class PerformanceProfile : int
+{
+    Default = 0,
+    LowLatency = 1, // Shallow buffers, late frames are dropped, no scripts.
+    LowPower = 2,   // Few decoder threads, large and rare reads.
+    Throughput = 3, // Deep buffers for many or heavy streams.
+    Preview = 4,    // Every requested frame is shown exactly, nothing is buffered ahead.
+    Quality = 5,    // No frame is dropped, the video waits instead.
+    Custom = 6      // Loaded from a JSON file.
+};
+Q_ENUM_NS(PerformanceProfile)
+
+enum class PlayerPriority : int
+{
+    Background = 0, // Hidden or small tiles, standby players.
+    Normal = 1,
+    Focused = 2     // The player the user is looking at.
+};
+Q_ENUM_NS(PlayerPriority)
+
+enum class QualityTier : int
+{
+    Full = 0,
+    FastRendering = 1,     // Bilinear scaling, no dithering, debanding or deinterlacing.
+    SkipLoopFilter = 2,    // The deblocking filter is skipped for non reference frames.
+    ReducedResolution = 3, // Decoded at half the resolution, if the decoder can.
+    ReducedFrameRate = 4   // Non reference frames are not decoded at all.
+};
+Q_ENUM_NS(QualityTier)
+
+enum class DecodeQuality : int
+{
+    Full = 0,
+    Fast = 1,   // No loop filter, non spec compliant speedups, cheapest scaling.
+    Preview = 2 // Fast, at a quarter of the resolution, without non reference frames, single threaded.
+};
+Q_ENUM_NS(DecodeQuality)
+
+// The NOTIFY signals backends queue up with "MediaPlayer::notifyChanged()".
+enum class PropertyChange : quint32
+{
+    Source = 1 << 0,
+    FileName = 1 << 1,
+    FilePath = 1 << 2,
+    Position = 1 << 3,
+    Duration = 1 << 4,
+    VideoSize = 1 << 5,
+    Volume = 1 << 6,
+    Mute = 1 << 7,
+    Seekable = 1 << 8,
+    PlaybackState = 1 << 9,
+    MediaStatus = 1 << 10,
+    PlaybackRate = 1 << 11,
+    AspectRatio = 1 << 12,
+    SnapshotDirectory = 1 << 13,
+    SnapshotFormat = 1 << 14,
+    SnapshotTemplate = 1 << 15,
+    HardwareDecoding = 1 << 16,
+    FillMode = 1 << 17,
+    Chapters = 1 << 18,
+    MetaData = 1 << 19,
+    MediaTracks = 1 << 20,
+    ActiveVideoTrack = 1 << 21,
+    ActiveAudioTrack = 1 << 22,
+    ActiveSubtitleTrack = 1 << 23
+};
+Q_DECLARE_FLAGS(PropertyChanges, PropertyChange)
+
 struct ChapterInfo
 {
     QString title = {};
@@ -91,6 +176,30 @@ struct MediaTracks
     QList<QVariantHash> subtitle = {};
 };
 
+struct CacheState
+{
+    QList<QPair<qint64, qint64>> ranges = {}; // Buffered ranges, in milliseconds.
+    qint64 inputRate = -1; // Bytes per second read from the source, -1 if unknown.
+    bool underrun = false; // The demuxer ran dry while playing.
+};
+
+struct FrameStatistics
+{
+    qint64 presented = -1; // Frames shown so far, -1 if unknown.
+    qint64 dropped = -1;   // Frames dropped or shown too late so far, -1 if unknown.
+};
+
+// What the decoder and the renderer may leave out, see "MediaPlayer::decodeShortcuts()".
+// The discard levels use the names of libavcodec.
+struct DecodeShortcuts
+{
+    QString skipLoopFilter = QStringLiteral("default");
+    QString skipFrame = QStringLiteral("default");
+    int lowres = 0;             // Decode at 1/2^lowres of the resolution, where the codec supports it.
+    bool fast = false;          // Non spec compliant speedups.
+    bool fastRendering = false; // Bilinear scaling, no dithering, debanding or deinterlacing.
+};
+
 using Chapters = QList<ChapterInfo>;
 
 using MetaData = QVariantHash;
@@ -98,6 +207,7 @@ using MetaData = QVariantHash;
 QTMEDIAPLAYER_END_NAMESPACE
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(QTMEDIAPLAYER_PREPEND_NAMESPACE(MediaStatus))
+Q_DECLARE_OPERATORS_FOR_FLAGS(QTMEDIAPLAYER_PREPEND_NAMESPACE(PropertyChanges))
 Q_DECLARE_METATYPE(QTMEDIAPLAYER_PREPEND_NAMESPACE(ChapterInfo))
 Q_DECLARE_METATYPE(QTMEDIAPLAYER_PREPEND_NAMESPACE(MediaTracks))
 Q_DECLARE_METATYPE(QTMEDIAPLAYER_PREPEND_NAMESPACE(Chapters))
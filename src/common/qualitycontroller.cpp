@@ -0,0 +1,162 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "qualitycontroller.h"
+#include "playerinterface.h"
+#include <QtCore/qdebug.h>
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+static constexpr const int kSampleInterval = 1000;
+
+// Share of the frames dropped within one sample.
+static constexpr const qreal kPressureThreshold = 0.05;
+static constexpr const qreal kHeadroomThreshold = 0.005;
+
+// Consecutive samples needed for a step, in seconds.
+static constexpr const int kStepDownSamples = 3;
+static constexpr const int kStepUpSamples = 10;
+static constexpr const int kMaximumStepUpSamples = 160;
+
+// A new tier only shows its effect once the frames decoded with the previous
+// one are through the pipeline.
+static constexpr const int kSettleSamples = 2;
+
+// Stepping down again this soon (in milliseconds) means the step up failed.
+static constexpr const qint64 kFailedStepUpWindow = 20000;
+
+QualityController::QualityController(const Sampler &sampler, QObject *parent) : QObject(parent), m_sampler(sampler)
+{
+    Q_ASSERT(m_sampler);
+    m_stepUpSamples = kStepUpSamples;
+    m_timer.setTimerType(Qt::CoarseTimer);
+    m_timer.setInterval(kSampleInterval);
+    connect(&m_timer, &QTimer::timeout, this, &QualityController::sample);
+}
+
+QualityController::~QualityController() = default;
+
+void QualityController::setActive(const bool value)
+{
+    if (m_timer.isActive() == value) {
+        return;
+    }
+    // Pauses and seeks in between would distort the first sample.
+    m_hasBaseline = false;
+    m_pressureSamples = 0;
+    m_headroomSamples = 0;
+    if (value) {
+        m_timer.start();
+    } else {
+        m_timer.stop();
+    }
+}
+
+void QualityController::reset()
+{
+    m_hasBaseline = false;
+    m_settleSamples = 0;
+    m_pressureSamples = 0;
+    m_headroomSamples = 0;
+    m_stepUpSamples = kStepUpSamples;
+    m_stepUpTimer.invalidate();
+    if (m_tier == QualityTier::Full) {
+        return;
+    }
+    m_tier = QualityTier::Full;
+    qCDebug(lcQMPPlayer) << "Quality tier reset -->" << m_tier;
+    Q_EMIT tierChanged();
+}
+
+QualityTier QualityController::tier() const
+{
+    return m_tier;
+}
+
+void QualityController::sample()
+{
+    if (!m_sampler) {
+        return;
+    }
+    const FrameStatistics statistics = m_sampler();
+    if ((statistics.presented < 0) || (statistics.dropped < 0)) {
+        return;
+    }
+    // The counters start over with every media.
+    if (!m_hasBaseline || (statistics.presented < m_lastPresented) || (statistics.dropped < m_lastDropped)) {
+        m_hasBaseline = true;
+        m_lastPresented = statistics.presented;
+        m_lastDropped = statistics.dropped;
+        return;
+    }
+    const qint64 presented = (statistics.presented - m_lastPresented);
+    const qint64 dropped = (statistics.dropped - m_lastDropped);
+    m_lastPresented = statistics.presented;
+    m_lastDropped = statistics.dropped;
+    if (m_settleSamples > 0) {
+        --m_settleSamples;
+        return;
+    }
+    // Nothing played at all, e.g. waiting for the network. Says nothing about the CPU.
+    if ((presented + dropped) <= 0) {
+        return;
+    }
+    const qreal ratio = (qreal(dropped) / qreal(presented + dropped));
+    if (ratio > kPressureThreshold) {
+        ++m_pressureSamples;
+        m_headroomSamples = 0;
+    } else if (ratio < kHeadroomThreshold) {
+        ++m_headroomSamples;
+        m_pressureSamples = 0;
+    } else {
+        m_pressureSamples = 0;
+        m_headroomSamples = 0;
+    }
+    if ((m_pressureSamples >= kStepDownSamples) && (m_tier < QualityTier::ReducedFrameRate)) {
+        if (m_stepUpTimer.isValid() && !m_stepUpTimer.hasExpired(kFailedStepUpWindow)) {
+            m_stepUpSamples = qMin(m_stepUpSamples * 2, kMaximumStepUpSamples);
+        }
+        m_stepUpTimer.invalidate();
+        setTier(static_cast<QualityTier>(int(m_tier) + 1), ratio);
+    } else if ((m_headroomSamples >= m_stepUpSamples) && (m_tier > QualityTier::Full)) {
+        m_stepUpTimer.start();
+        setTier(static_cast<QualityTier>(int(m_tier) - 1), ratio);
+    }
+}
+
+void QualityController::setTier(const QualityTier value, const qreal dropRatio)
+{
+    m_pressureSamples = 0;
+    m_headroomSamples = 0;
+    m_settleSamples = kSettleSamples;
+    if (m_tier == value) {
+        return;
+    }
+    m_tier = value;
+    qCDebug(lcQMPPlayer) << "Quality tier -->" << m_tier << "at a drop ratio of" << dropRatio
+                         << "- stepping up after" << m_stepUpSamples << "seconds of headroom.";
+    Q_EMIT tierChanged();
+}
+
+QTMEDIAPLAYER_END_NAMESPACE
@@ -0,0 +1,79 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "playertypes.h"
+#include <QtCore/qobject.h>
+#include <QtCore/qtimer.h>
+#include <QtCore/qelapsedtimer.h>
+#include <functional>
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+// Closed loop over the dropped frames: sustained drops step the quality tier
+// down, sustained headroom steps it back up. Stepping up is slower than
+// stepping down, and gets slower every time it failed shortly after, so the
+// tier doesn't flap on the edge of what the machine can do.
+class QualityController : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY_MOVE(QualityController)
+
+public:
+    using Sampler = std::function<FrameStatistics()>;
+
+    explicit QualityController(const Sampler &sampler, QObject *parent = nullptr);
+    ~QualityController() override;
+
+    // Only samples while active, e.g. while playing.
+    void setActive(const bool value);
+
+    // Back to full quality, e.g. when the controller gets disabled.
+    void reset();
+
+    Q_NODISCARD QualityTier tier() const;
+
+Q_SIGNALS:
+    void tierChanged();
+
+private:
+    void sample();
+    void setTier(const QualityTier value, const qreal dropRatio);
+
+private:
+    Sampler m_sampler = nullptr;
+    QTimer m_timer;
+    QualityTier m_tier = QualityTier::Full;
+    bool m_hasBaseline = false;
+    qint64 m_lastPresented = 0;
+    qint64 m_lastDropped = 0;
+    int m_settleSamples = 0;
+    int m_pressureSamples = 0;
+    int m_headroomSamples = 0;
+    int m_stepUpSamples = 0;
+    QElapsedTimer m_stepUpTimer;
+};
+
+QTMEDIAPLAYER_END_NAMESPACE
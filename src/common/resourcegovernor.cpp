@@ -0,0 +1,266 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "resourcegovernor.h"
+#include "playerinterface.h"
+#include <QtCore/qdebug.h>
+#include <QtCore/qthread.h>
+#include <QtCore/qtimer.h>
+#include <QtQml/qqmlengine.h>
+#include <algorithm>
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+Q_LOGGING_CATEGORY(lcQMPGovernor, "wangwenx190.qtmediaplayer.governor")
+
+Q_GLOBAL_STATIC(ResourceGovernor, resourceGovernor)
+
+// Interval of polling the memory usage of the players, in milliseconds.
+static constexpr const int kMemoryUsageInterval = 1000;
+
+// Below this (in megabytes), a player can't even buffer a few seconds of a
+// typical stream anymore.
+static constexpr const int kMinimumCacheSize = 4;
+
+// Relative share of the budget per priority.
+[[nodiscard]] static inline int priorityWeight(const PlayerPriority priority)
+{
+    switch (priority) {
+    case PlayerPriority::Background:
+        return 1;
+    case PlayerPriority::Normal:
+        return 2;
+    case PlayerPriority::Focused:
+        return 4;
+    }
+    return 1;
+}
+
+ResourceGovernor::ResourceGovernor(QObject *parent) : QObject(parent)
+{
+    m_threadBudget = qMax(1, QThread::idealThreadCount());
+    m_usageTimer = new QTimer(this);
+    m_usageTimer->setTimerType(Qt::CoarseTimer);
+    m_usageTimer->setInterval(kMemoryUsageInterval);
+    connect(m_usageTimer, &QTimer::timeout, this, &ResourceGovernor::updateMemoryUsage);
+}
+
+ResourceGovernor::~ResourceGovernor() = default;
+
+ResourceGovernor *ResourceGovernor::instance()
+{
+    return resourceGovernor();
+}
+
+QObject *ResourceGovernor::qmlInstance(QQmlEngine *engine, QJSEngine *scriptEngine)
+{
+    Q_UNUSED(engine);
+    Q_UNUSED(scriptEngine);
+    ResourceGovernor * const governor = instance();
+    // Shared by all engines, none of them may delete it.
+    QQmlEngine::setObjectOwnership(governor, QQmlEngine::CppOwnership);
+    return governor;
+}
+
+bool ResourceGovernor::enabled() const
+{
+    return m_enabled;
+}
+
+void ResourceGovernor::setEnabled(const bool value)
+{
+    if (m_enabled == value) {
+        return;
+    }
+    m_enabled = value;
+    qCDebug(lcQMPGovernor) << "Enabled -->" << m_enabled;
+    Q_EMIT enabledChanged();
+    rebalance();
+}
+
+int ResourceGovernor::threadBudget() const
+{
+    return m_threadBudget;
+}
+
+void ResourceGovernor::setThreadBudget(const int value)
+{
+    Q_ASSERT(value > 0);
+    if ((value <= 0) || (m_threadBudget == value)) {
+        return;
+    }
+    m_threadBudget = value;
+    qCDebug(lcQMPGovernor) << "Thread budget -->" << m_threadBudget;
+    Q_EMIT threadBudgetChanged();
+    rebalance();
+}
+
+int ResourceGovernor::memoryBudget() const
+{
+    return m_memoryBudget;
+}
+
+void ResourceGovernor::setMemoryBudget(const int value)
+{
+    Q_ASSERT(value >= 0);
+    if ((value < 0) || (m_memoryBudget == value)) {
+        return;
+    }
+    m_memoryBudget = value;
+    qCDebug(lcQMPGovernor) << "Memory budget -->" << m_memoryBudget << "MB";
+    Q_EMIT memoryBudgetChanged();
+    rebalance();
+}
+
+int ResourceGovernor::playerCount() const
+{
+    return m_players.count();
+}
+
+bool ResourceGovernor::isAnyPlayerDecoding() const
+{
+    return std::any_of(m_players.cbegin(), m_players.cend(), [](const MediaPlayer *player){
+        return (player->isPlaying() && !player->suspended());
+    });
+}
+
+qint64 ResourceGovernor::memoryUsage() const
+{
+    return m_memoryUsage;
+}
+
+void ResourceGovernor::registerPlayer(MediaPlayer *player)
+{
+    Q_ASSERT(player);
+    if (!player || m_players.contains(player)) {
+        return;
+    }
+    m_players.append(player);
+    // Backends may report state changes from their own threads.
+    connect(player, &MediaPlayer::playbackStateChanged, this, &ResourceGovernor::rebalance, Qt::QueuedConnection);
+    connect(player, &MediaPlayer::suspendedChanged, this, &ResourceGovernor::rebalance);
+    connect(player, &MediaPlayer::priorityChanged, this, &ResourceGovernor::rebalance);
+    if (!m_usageTimer->isActive()) {
+        m_usageTimer->start();
+    }
+    Q_EMIT playerCountChanged();
+    rebalance();
+}
+
+void ResourceGovernor::unregisterPlayer(MediaPlayer *player)
+{
+    Q_ASSERT(player);
+    if (!player || !m_players.removeOne(player)) {
+        return;
+    }
+    m_decoderThreads.remove(player);
+    m_cacheSizes.remove(player);
+    disconnect(player, nullptr, this, nullptr);
+    if (m_players.isEmpty()) {
+        m_usageTimer->stop();
+    }
+    Q_EMIT playerCountChanged();
+    rebalance();
+}
+
+int ResourceGovernor::decoderThreads(const MediaPlayer *player) const
+{
+    return m_decoderThreads.value(player, 0);
+}
+
+int ResourceGovernor::cacheSize(const MediaPlayer *player) const
+{
+    return m_cacheSizes.value(player, 0);
+}
+
+void ResourceGovernor::rebalance()
+{
+    if (m_rebalancePending) {
+        return;
+    }
+    m_rebalancePending = true;
+    QMetaObject::invokeMethod(this, "doRebalance", Qt::QueuedConnection);
+}
+
+void ResourceGovernor::doRebalance()
+{
+    m_rebalancePending = false;
+    QHash<const MediaPlayer *, int> threads = {};
+    QHash<const MediaPlayer *, int> cacheSizes = {};
+    if (m_enabled && !m_players.isEmpty()) {
+        // Stopped and suspended players neither decode nor buffer anything, they
+        // get no share.
+        QHash<const MediaPlayer *, int> weights = {};
+        int totalWeight = 0;
+        for (auto &&player : qAsConst(m_players)) {
+            const int weight = ((player->isStopped() || player->suspended()) ? 0 : priorityWeight(player->priority()));
+            weights.insert(player, weight);
+            totalWeight += weight;
+        }
+        // Every player needs a minimum, which may exceed the budgets with too
+        // many active players. Nothing can be done about that.
+        for (auto &&player : qAsConst(m_players)) {
+            const int weight = weights.value(player);
+            threads.insert(player, ((weight > 0) ? qMax(1, (m_threadBudget * weight) / totalWeight) : 1));
+            if (m_memoryBudget > 0) {
+                cacheSizes.insert(player, ((weight > 0) ? qMax(kMinimumCacheSize, (m_memoryBudget * weight) / totalWeight) : kMinimumCacheSize));
+            }
+        }
+    }
+    QList<MediaPlayer *> changed = {};
+    for (auto &&player : qAsConst(m_players)) {
+        if ((threads.value(player, 0) != m_decoderThreads.value(player, 0))
+                || (cacheSizes.value(player, 0) != m_cacheSizes.value(player, 0))) {
+            changed.append(player);
+        }
+    }
+    m_decoderThreads = threads;
+    m_cacheSizes = cacheSizes;
+    if (changed.isEmpty()) {
+        return;
+    }
+    qCDebug(lcQMPGovernor) << "Decoder threads of" << m_players.count() << "players -->" << m_decoderThreads.values();
+    if (!m_cacheSizes.isEmpty()) {
+        qCDebug(lcQMPGovernor) << "Cache sizes of" << m_players.count() << "players -->" << m_cacheSizes.values() << "MB";
+    }
+    for (auto &&player : qAsConst(changed)) {
+        player->applyResourceLimits();
+    }
+}
+
+void ResourceGovernor::updateMemoryUsage()
+{
+    qint64 total = 0;
+    for (auto &&player : qAsConst(m_players)) {
+        player->updateMemoryUsage();
+        total += qMax(qint64(0), player->memoryUsage());
+    }
+    if (m_memoryUsage == total) {
+        return;
+    }
+    m_memoryUsage = total;
+    Q_EMIT memoryUsageChanged();
+}
+
+QTMEDIAPLAYER_END_NAMESPACE
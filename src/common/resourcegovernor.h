@@ -0,0 +1,121 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "playertypes.h"
+#include <QtCore/qobject.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qlist.h>
+
+QT_BEGIN_NAMESPACE
+QT_FORWARD_DECLARE_CLASS(QQmlEngine)
+QT_FORWARD_DECLARE_CLASS(QJSEngine)
+QT_FORWARD_DECLARE_CLASS(QTimer)
+QT_END_NAMESPACE
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(lcQMPGovernor)
+
+class MediaPlayer;
+
+// Process wide budgets of decoder threads and buffer memory, shared by all the
+// players by their priority. Without it, every player sizes its decoder threads
+// to the number of CPU cores and buffers as much as its backend likes, which
+// oversubscribes the machine quickly. Players register themselves, everything
+// happens on the GUI thread.
+class ResourceGovernor : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY_MOVE(ResourceGovernor)
+    Q_PROPERTY(bool enabled READ enabled WRITE setEnabled NOTIFY enabledChanged)
+    Q_PROPERTY(int threadBudget READ threadBudget WRITE setThreadBudget NOTIFY threadBudgetChanged)
+    Q_PROPERTY(int memoryBudget READ memoryBudget WRITE setMemoryBudget NOTIFY memoryBudgetChanged)
+    Q_PROPERTY(int playerCount READ playerCount NOTIFY playerCountChanged)
+    Q_PROPERTY(qint64 memoryUsage READ memoryUsage NOTIFY memoryUsageChanged)
+
+public:
+    explicit ResourceGovernor(QObject *parent = nullptr);
+    ~ResourceGovernor() override;
+
+    // Null once the application is shutting down.
+    Q_NODISCARD static ResourceGovernor *instance();
+    Q_NODISCARD static QObject *qmlInstance(QQmlEngine *engine, QJSEngine *scriptEngine);
+
+    Q_NODISCARD bool enabled() const;
+    void setEnabled(const bool value);
+
+    // Decoder threads shared by all players, the number of CPU cores by default.
+    Q_NODISCARD int threadBudget() const;
+    void setThreadBudget(const int value);
+
+    // Buffer memory (in megabytes) shared by all players, for the demuxed data
+    // ahead of and behind the playback position. Zero means unlimited.
+    Q_NODISCARD int memoryBudget() const;
+    void setMemoryBudget(const int value);
+
+    Q_NODISCARD int playerCount() const;
+
+    // True if any player is playing right now (and not suspended).
+    Q_NODISCARD bool isAnyPlayerDecoding() const;
+
+    // Sum of the "memoryUsage" of all players, in bytes.
+    Q_NODISCARD qint64 memoryUsage() const;
+
+    void registerPlayer(MediaPlayer *player);
+    void unregisterPlayer(MediaPlayer *player);
+
+    // The shares assigned to the given player, zero if it's not governed.
+    Q_NODISCARD int decoderThreads(const MediaPlayer *player) const;
+    Q_NODISCARD int cacheSize(const MediaPlayer *player) const; // In megabytes.
+
+public Q_SLOTS:
+    // Coalesced, the budget is split once per event loop iteration at most.
+    void rebalance();
+
+private Q_SLOTS:
+    void doRebalance();
+    void updateMemoryUsage();
+
+Q_SIGNALS:
+    void enabledChanged();
+    void threadBudgetChanged();
+    void memoryBudgetChanged();
+    void playerCountChanged();
+    void memoryUsageChanged();
+
+private:
+    bool m_enabled = false;
+    int m_threadBudget = 0;
+    int m_memoryBudget = 0;
+    bool m_rebalancePending = false;
+    QList<MediaPlayer *> m_players = {};
+    QHash<const MediaPlayer *, int> m_decoderThreads = {};
+    QHash<const MediaPlayer *, int> m_cacheSizes = {};
+    qint64 m_memoryUsage = 0;
+    QTimer *m_usageTimer = nullptr;
+};
+
+QTMEDIAPLAYER_END_NAMESPACE
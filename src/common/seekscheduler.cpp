@@ -0,0 +1,153 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "seekscheduler.h"
+#include "playerinterface.h"
+#include <QtCore/qdebug.h>
+#include <utility>
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+// Backends don't report every seek (e.g. seeking to the current position), don't wait forever.
+static constexpr const int kSeekTimeout = 3000;
+
+SeekScheduler::SeekScheduler(const Issuer &issuer, QObject *parent) : QObject(parent), m_issuer(issuer)
+{
+    Q_ASSERT(m_issuer);
+    m_watchdog.setSingleShot(true);
+    m_watchdog.setInterval(kSeekTimeout);
+    connect(&m_watchdog, &QTimer::timeout, this, [this](){
+        qCDebug(lcQMPPlayer) << "Seeking to" << m_inFlightPosition << "timed out.";
+        finish();
+    });
+    m_latencyTimer.start();
+}
+
+SeekScheduler::~SeekScheduler() = default;
+
+void SeekScheduler::request(const qint64 position, const bool exact, const bool interruptible)
+{
+    // The steps were meant from the position before this seek.
+    m_pendingSteps = 0;
+    if (m_inFlight && !interruptible) {
+        // Latest wins, whatever was pending before is stale now.
+        m_pending = true;
+        m_pendingPosition = position;
+        m_pendingExact = exact;
+        m_pendingRequestTime = m_latencyTimer.elapsed();
+        return;
+    }
+    m_pending = false;
+    m_pendingRequestTime = m_latencyTimer.elapsed();
+    issue(position, exact);
+}
+
+void SeekScheduler::setStepIssuer(const StepIssuer &issuer)
+{
+    m_stepIssuer = issuer;
+}
+
+void SeekScheduler::requestStep(const int frames)
+{
+    Q_ASSERT(m_stepIssuer);
+    if (!m_stepIssuer || (frames == 0)) {
+        return;
+    }
+    if (m_inFlight) {
+        m_pendingSteps += frames;
+        return;
+    }
+    m_pendingRequestTime = m_latencyTimer.elapsed();
+    issueStep(frames);
+}
+
+void SeekScheduler::finish()
+{
+    if (!m_inFlight) {
+        return;
+    }
+    m_watchdog.stop();
+    m_inFlight = false;
+    const qint64 position = m_inFlightPosition;
+    m_inFlightPosition = -1;
+    if (m_pending) {
+        m_pending = false;
+        issue(m_pendingPosition, m_pendingExact);
+        return;
+    }
+    // Whatever steps are left were requested after the last seek.
+    if (m_pendingSteps != 0) {
+        issueStep(std::exchange(m_pendingSteps, 0));
+        return;
+    }
+    Q_EMIT finished(position, qreal(m_latencyTimer.elapsed() - m_pendingRequestTime));
+}
+
+void SeekScheduler::reset()
+{
+    m_watchdog.stop();
+    m_inFlight = false;
+    m_inFlightPosition = -1;
+    m_pending = false;
+    m_pendingSteps = 0;
+}
+
+bool SeekScheduler::busy() const
+{
+    return (m_inFlight || m_pending);
+}
+
+qint64 SeekScheduler::target() const
+{
+    if (m_pending) {
+        return m_pendingPosition;
+    }
+    return (m_inFlight ? m_inFlightPosition : -1);
+}
+
+void SeekScheduler::issue(const qint64 position, const bool exact)
+{
+    if (!m_issuer || !m_issuer(position, exact)) {
+        m_inFlight = false;
+        m_inFlightPosition = -1;
+        return;
+    }
+    m_inFlight = true;
+    m_inFlightPosition = position;
+    m_watchdog.start();
+}
+
+void SeekScheduler::issueStep(const int frames)
+{
+    if (!m_stepIssuer || !m_stepIssuer(frames)) {
+        m_inFlight = false;
+        m_inFlightPosition = -1;
+        return;
+    }
+    m_inFlight = true;
+    m_inFlightPosition = -1;
+    m_watchdog.start();
+}
+
+QTMEDIAPLAYER_END_NAMESPACE
@@ -0,0 +1,95 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "../loader/qtmediaplayer_global.h"
+#include <QtCore/qobject.h>
+#include <QtCore/qtimer.h>
+#include <QtCore/qelapsedtimer.h>
+#include <functional>
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+// Keeps at most one seek in flight. Requests arriving meanwhile are coalesced,
+// only the latest one is issued once the running seek has finished. Backends
+// which drop a running seek in favour of a new one ("interruptible") get new
+// requests immediately instead. Frame steps are seeks relative to wherever the
+// previous one ends, they queue up behind it and add up instead.
+class SeekScheduler : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY_MOVE(SeekScheduler)
+
+public:
+    // Returns false if the seek could not be started at all.
+    using Issuer = std::function<bool(const qint64 position, const bool exact)>;
+    using StepIssuer = std::function<bool(const int frames)>;
+
+    explicit SeekScheduler(const Issuer &issuer, QObject *parent = nullptr);
+    ~SeekScheduler() override;
+
+    void request(const qint64 position, const bool exact, const bool interruptible);
+
+    // Steps are never interrupted and never interrupt anything. A seek requested
+    // later drops the steps still pending.
+    void setStepIssuer(const StepIssuer &issuer);
+    void requestStep(const int frames);
+
+    // Called by the backend once the running seek has finished.
+    void finish();
+
+    // Forgets everything, e.g. when a new media is opened.
+    void reset();
+
+    Q_NODISCARD bool busy() const;
+
+    // The most recently requested position, or -1 if nothing is in flight or
+    // pending, or the running request is a frame step.
+    Q_NODISCARD qint64 target() const;
+
+Q_SIGNALS:
+    // Latency is measured from the request of the position that was finally
+    // reached, in milliseconds. The position is -1 after a frame step.
+    void finished(const qint64 position, const qreal latency);
+
+private:
+    void issue(const qint64 position, const bool exact);
+    void issueStep(const int frames);
+
+private:
+    Issuer m_issuer = nullptr;
+    StepIssuer m_stepIssuer = nullptr;
+    QTimer m_watchdog;
+    QElapsedTimer m_latencyTimer;
+    bool m_inFlight = false;
+    qint64 m_inFlightPosition = -1;
+    bool m_pending = false;
+    qint64 m_pendingPosition = -1;
+    bool m_pendingExact = false;
+    qint64 m_pendingRequestTime = 0;
+    int m_pendingSteps = 0;
+};
+
+QTMEDIAPLAYER_END_NAMESPACE
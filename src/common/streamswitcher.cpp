@@ -0,0 +1,337 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "streamswitcher.h"
+#include <QtCore/qdebug.h>
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+Q_LOGGING_CATEGORY(lcQMPSwitcher, "wangwenx190.qtmediaplayer.switcher")
+
+StreamSwitcher::StreamSwitcher(QQuickItem *parent) : QQuickItem(parent)
+{
+}
+
+StreamSwitcher::~StreamSwitcher() = default;
+
+QUrl StreamSwitcher::source() const
+{
+    return m_source;
+}
+
+void StreamSwitcher::setSource(const QUrl &value)
+{
+    if (m_source == value) {
+        return;
+    }
+    m_source = value;
+    qCDebug(lcQMPSwitcher) << "Source -->" << m_source;
+    Q_EMIT sourceChanged();
+    if (isComponentComplete()) {
+        switchToSource();
+        updateStandbys();
+    }
+}
+
+QList<QUrl> StreamSwitcher::candidates() const
+{
+    return m_candidates;
+}
+
+void StreamSwitcher::setCandidates(const QList<QUrl> &value)
+{
+    if (m_candidates == value) {
+        return;
+    }
+    m_candidates = value;
+    Q_EMIT candidatesChanged();
+    if (isComponentComplete()) {
+        updateStandbys();
+    }
+}
+
+int StreamSwitcher::standbyCount() const
+{
+    return m_standbyCount;
+}
+
+void StreamSwitcher::setStandbyCount(const int value)
+{
+    Q_ASSERT(value >= 0);
+    if ((value < 0) || (m_standbyCount == value)) {
+        return;
+    }
+    m_standbyCount = value;
+    qCDebug(lcQMPSwitcher) << "Standby count -->" << m_standbyCount;
+    Q_EMIT standbyCountChanged();
+    if (isComponentComplete()) {
+        updateStandbys();
+    }
+}
+
+int StreamSwitcher::standbyCacheSize() const
+{
+    return m_standbyCacheSize;
+}
+
+void StreamSwitcher::setStandbyCacheSize(const int value)
+{
+    Q_ASSERT(value >= 0);
+    if ((value < 0) || (m_standbyCacheSize == value)) {
+        return;
+    }
+    m_standbyCacheSize = value;
+    Q_EMIT standbyCacheSizeChanged();
+    for (auto it = m_players.constBegin(); it != m_players.constEnd(); ++it) {
+        if (it.key() != m_player) {
+            it.key()->setCacheSize(m_standbyCacheSize);
+        }
+    }
+}
+
+int StreamSwitcher::standbyDecoderThreads() const
+{
+    return m_standbyDecoderThreads;
+}
+
+void StreamSwitcher::setStandbyDecoderThreads(const int value)
+{
+    Q_ASSERT(value >= 0);
+    if ((value < 0) || (m_standbyDecoderThreads == value)) {
+        return;
+    }
+    m_standbyDecoderThreads = value;
+    Q_EMIT standbyDecoderThreadsChanged();
+    for (auto it = m_players.constBegin(); it != m_players.constEnd(); ++it) {
+        if (it.key() != m_player) {
+            it.key()->setDecoderThreads(m_standbyDecoderThreads);
+        }
+    }
+}
+
+bool StreamSwitcher::standbyPlaying() const
+{
+    return m_standbyPlaying;
+}
+
+void StreamSwitcher::setStandbyPlaying(const bool value)
+{
+    if (m_standbyPlaying == value) {
+        return;
+    }
+    m_standbyPlaying = value;
+    Q_EMIT standbyPlayingChanged();
+    for (auto it = m_players.constBegin(); it != m_players.constEnd(); ++it) {
+        if (it.key() != m_player) {
+            putOnStandby(it.key());
+        }
+    }
+}
+
+QList<QUrl> StreamSwitcher::standbySources() const
+{
+    QList<QUrl> result = {};
+    for (auto it = m_players.constBegin(); it != m_players.constEnd(); ++it) {
+        if (it.key() != m_player) {
+            result.append(it.value());
+        }
+    }
+    return result;
+}
+
+MediaPlayer *StreamSwitcher::player() const
+{
+    return m_player;
+}
+
+void StreamSwitcher::componentComplete()
+{
+    QQuickItem::componentComplete();
+    switchToSource();
+    updateStandbys();
+}
+
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+void StreamSwitcher::geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry)
+#else
+void StreamSwitcher::geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry)
+#endif
+{
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+#else
+    QQuickItem::geometryChanged(newGeometry, oldGeometry);
+#endif
+    if (newGeometry.size() == oldGeometry.size()) {
+        return;
+    }
+    // Standby players render at the final size too, nothing changes on switching.
+    for (auto it = m_players.constBegin(); it != m_players.constEnd(); ++it) {
+        it.key()->setSize(newGeometry.size());
+    }
+}
+
+void StreamSwitcher::switchToSource()
+{
+    if (!m_source.isValid()) {
+        if (m_player) {
+            m_player->stop();
+            m_players[m_player] = {};
+        }
+        return;
+    }
+    MediaPlayer *target = standbyFor(m_source);
+    const bool prepared = (target != nullptr);
+    if (!target) {
+        // Nothing has been prepared for it, it's opened the usual way.
+        target = (m_player ? m_player : addPlayer());
+        if (!target) {
+            return;
+        }
+    }
+    MediaPlayer *previous = m_player;
+    if (previous && (previous != target)) {
+        // The audio settings belong to the switcher, not to a single stream.
+        target->setVolume(previous->volume());
+        target->setMute(previous->mute());
+        putOnStandby(previous);
+    } else if (!previous) {
+        target->setMute(false);
+    }
+    m_player = target;
+    target->setZ(1.0);
+    target->setOpacity(1.0);
+    target->setStandby(false);
+    target->setCacheSize(0);
+    target->setDecoderThreads(0);
+    target->setPriority(PlayerPriority::Focused);
+    target->setAutoStart(true);
+    if (prepared) {
+        target->play();
+        qCDebug(lcQMPSwitcher) << "Switched to the standby player of" << m_source;
+    } else {
+        m_players[target] = m_source;
+        target->play(m_source);
+        qCDebug(lcQMPSwitcher) << "No standby player for" << m_source;
+    }
+    if (previous != target) {
+        Q_EMIT playerChanged();
+    }
+}
+
+void StreamSwitcher::updateStandbys()
+{
+    QList<QUrl> wanted = {};
+    for (auto &&url : qAsConst(m_candidates)) {
+        if (wanted.size() >= m_standbyCount) {
+            break;
+        }
+        if (url.isValid() && (url != m_source) && !wanted.contains(url)) {
+            wanted.append(url);
+        }
+    }
+    QList<MediaPlayer *> spare = {};
+    for (auto it = m_players.constBegin(); it != m_players.constEnd(); ++it) {
+        if ((it.key() != m_player) && !wanted.contains(it.value())) {
+            spare.append(it.key());
+        }
+    }
+    bool changed = !spare.isEmpty();
+    for (auto &&url : qAsConst(wanted)) {
+        if (standbyFor(url)) {
+            continue;
+        }
+        MediaPlayer *player = (spare.isEmpty() ? addPlayer() : spare.takeFirst());
+        if (!player) {
+            break;
+        }
+        putOnStandby(player);
+        m_players[player] = url;
+        // Standby players don't start playing on their own, see "putOnStandby()".
+        player->setSource(url);
+        changed = true;
+    }
+    // Players nobody needs anymore give their memory back.
+    for (auto &&player : qAsConst(spare)) {
+        m_players.remove(player);
+        player->setVisible(false);
+        player->deleteLater();
+    }
+    if (changed) {
+        qCDebug(lcQMPSwitcher) << "Standby sources -->" << standbySources();
+        Q_EMIT standbySourcesChanged();
+    }
+}
+
+MediaPlayer *StreamSwitcher::addPlayer()
+{
+    MediaPlayer *player = createPlayer();
+    Q_ASSERT(player);
+    if (!player) {
+        return nullptr;
+    }
+    player->setParent(this);
+    player->setParentItem(this);
+    player->setSize(size());
+    m_players.insert(player, {});
+    return player;
+}
+
+MediaPlayer *StreamSwitcher::standbyFor(const QUrl &url) const
+{
+    for (auto it = m_players.constBegin(); it != m_players.constEnd(); ++it) {
+        if ((it.key() != m_player) && (it.value() == url)) {
+            return it.key();
+        }
+    }
+    return nullptr;
+}
+
+void StreamSwitcher::putOnStandby(MediaPlayer *player)
+{
+    Q_ASSERT(player);
+    if (!player) {
+        return;
+    }
+    // Hidden by opacity, not by visibility: invisible items never get a scene
+    // graph node, and the players don't open anything without one. The node
+    // itself renders nothing while the player is on standby.
+    player->setZ(0.0);
+    player->setOpacity(0.0);
+    player->setStandby(true);
+    player->setMute(true);
+    player->setCacheSize(m_standbyCacheSize);
+    player->setDecoderThreads(m_standbyDecoderThreads);
+    player->setPriority(PlayerPriority::Background);
+    player->setAutoStart(m_standbyPlaying);
+    if (m_standbyPlaying) {
+        if (!player->isStopped()) {
+            player->play();
+        }
+    } else {
+        player->pause();
+    }
+}
+
+QTMEDIAPLAYER_END_NAMESPACE
@@ -0,0 +1,125 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "playerinterface.h"
+#include <QtCore/qhash.h>
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(lcQMPSwitcher)
+
+// Fast channel switching: keeps up to "standbyCount" players open and buffering
+// (muted and hidden) for the first "candidates", so that switching to one of them
+// only changes which player is shown. Every backend provides its own players.
+class StreamSwitcher : public QQuickItem
+{
+    Q_OBJECT
+    Q_DISABLE_COPY_MOVE(StreamSwitcher)
+    Q_PROPERTY(QUrl source READ source WRITE setSource NOTIFY sourceChanged)
+    Q_PROPERTY(QList<QUrl> candidates READ candidates WRITE setCandidates NOTIFY candidatesChanged)
+    Q_PROPERTY(int standbyCount READ standbyCount WRITE setStandbyCount NOTIFY standbyCountChanged)
+    Q_PROPERTY(int standbyCacheSize READ standbyCacheSize WRITE setStandbyCacheSize NOTIFY standbyCacheSizeChanged)
+    Q_PROPERTY(int standbyDecoderThreads READ standbyDecoderThreads WRITE setStandbyDecoderThreads NOTIFY standbyDecoderThreadsChanged)
+    Q_PROPERTY(bool standbyPlaying READ standbyPlaying WRITE setStandbyPlaying NOTIFY standbyPlayingChanged)
+    Q_PROPERTY(QList<QUrl> standbySources READ standbySources NOTIFY standbySourcesChanged)
+    Q_PROPERTY(MediaPlayer *player READ player NOTIFY playerChanged)
+
+public:
+    explicit StreamSwitcher(QQuickItem *parent = nullptr);
+    ~StreamSwitcher() override;
+
+    // The media being shown.
+    Q_NODISCARD QUrl source() const;
+    void setSource(const QUrl &value);
+
+    // The media most likely to be switched to next, the most likely one first.
+    Q_NODISCARD QList<QUrl> candidates() const;
+    void setCandidates(const QList<QUrl> &value);
+
+    // How many candidates are kept open at the same time.
+    Q_NODISCARD int standbyCount() const;
+    void setStandbyCount(const int value);
+
+    // Buffer limit (in megabytes) of each standby player. Zero lets the backend decide.
+    Q_NODISCARD int standbyCacheSize() const;
+    void setStandbyCacheSize(const int value);
+
+    // Decoder threads of each standby player. Zero lets the backend decide.
+    Q_NODISCARD int standbyDecoderThreads() const;
+    void setStandbyDecoderThreads(const int value);
+
+    // Standby players are paused on their first frame by default. Keeping them
+    // playing costs decoding, but live streams stay at the live edge.
+    Q_NODISCARD bool standbyPlaying() const;
+    void setStandbyPlaying(const bool value);
+
+    Q_NODISCARD QList<QUrl> standbySources() const;
+
+    // The player showing "source", for controlling the playback.
+    Q_NODISCARD MediaPlayer *player() const;
+
+protected:
+    Q_NODISCARD virtual MediaPlayer *createPlayer() const = 0;
+
+    void componentComplete() override;
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+    void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+#else
+    void geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+#endif
+
+private:
+    void switchToSource();
+    void updateStandbys();
+    Q_NODISCARD MediaPlayer *addPlayer();
+    Q_NODISCARD MediaPlayer *standbyFor(const QUrl &url) const;
+    void putOnStandby(MediaPlayer *player);
+
+Q_SIGNALS:
+    void sourceChanged();
+    void candidatesChanged();
+    void standbyCountChanged();
+    void standbyCacheSizeChanged();
+    void standbyDecoderThreadsChanged();
+    void standbyPlayingChanged();
+    void standbySourcesChanged();
+    void playerChanged();
+
+private:
+    QUrl m_source = {};
+    QList<QUrl> m_candidates = {};
+    int m_standbyCount = 2;
+    int m_standbyCacheSize = 16;
+    int m_standbyDecoderThreads = 1;
+    bool m_standbyPlaying = false;
+
+    // Every player and the media it has been given. The players don't report
+    // their source before their renderer is ready, so it's tracked here.
+    QHash<MediaPlayer *, QUrl> m_players = {};
+    MediaPlayer *m_player = nullptr;
+};
+
+QTMEDIAPLAYER_END_NAMESPACE
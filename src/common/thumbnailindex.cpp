@@ -0,0 +1,661 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "thumbnailindex.h"
+#include "mediacache.h"
+#include <QtCore/qdebug.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qcache.h>
+#include <QtCore/qbitarray.h>
+#include <QtCore/qset.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qthread.h>
+#include <QtCore/qwaitcondition.h>
+#include <QtGui/qpainter.h>
+#include <QtQuick/qquickwindow.h>
+#include <atomic>
+#include <utility>
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+Q_LOGGING_CATEGORY(lcQMPThumbnail, "wangwenx190.qtmediaplayer.thumbnail")
+
+// Thumbnails are packed into sprite sheets of 8x8 tiles. A sheet is the unit
+// of caching, both in memory and on disk.
+static constexpr const int kTilesPerRow = 8;
+static constexpr const int kTilesPerSheet = (kTilesPerRow * kTilesPerRow);
+
+// When the exact thumbnail is not there yet, show a neighbour within this distance.
+static constexpr const int kNeighbourSearchDistance = 4;
+
+// Once the whole index has been generated, tiles evicted from memory are only
+// generated again when they are this close to the previewed position.
+static constexpr const int kRegenerationDistance = kTilesPerSheet;
+
+static constexpr const int kSheetQuality = 85;
+static constexpr const char kSheetFileSuffix[] = ".jpg";
+
+[[nodiscard]] static inline QRectF fittedRect(const QSizeF &size, const QRectF &target)
+{
+    if (size.isEmpty() || target.isEmpty()) {
+        return {};
+    }
+    const QSizeF fittedSize = size.scaled(target.size(), Qt::KeepAspectRatio);
+    return {QPointF(target.x() + ((target.width() - fittedSize.width()) / 2.0),
+                    target.y() + ((target.height() - fittedSize.height()) / 2.0)), fittedSize};
+}
+
+class ThumbnailStore
+{
+    Q_DISABLE_COPY_MOVE(ThumbnailStore)
+
+public:
+    explicit ThumbnailStore(const QSize &tileSize, const int memoryLimit, const QString &diskPath)
+        : m_tileSize(tileSize), m_diskPath(diskPath)
+    {
+        // Costs are in kilobytes.
+        m_sheets.setMaxCost(qMax(1, memoryLimit) * 1024);
+    }
+
+    ~ThumbnailStore() = default;
+
+    Q_NODISCARD QSize tileSize() const
+    {
+        return m_tileSize;
+    }
+
+    void setMemoryLimit(const int value)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_sheets.setMaxCost(qMax(1, value) * 1024);
+    }
+
+    // Called by the worker once the duration is known.
+    void reset(const int count)
+    {
+        QSet<int> sheetsOnDisk = {};
+        if (!m_diskPath.isEmpty()) {
+            const QDir dir(m_diskPath);
+            const QStringList fileNames = dir.entryList({QStringLiteral("*") + QLatin1String(kSheetFileSuffix)}, QDir::Files);
+            for (auto &&fileName : qAsConst(fileNames)) {
+                bool ok = false;
+                const int sheet = QFileInfo(fileName).completeBaseName().toInt(&ok);
+                if (ok && (sheet >= 0)) {
+                    sheetsOnDisk.insert(sheet);
+                }
+            }
+        }
+        QMutexLocker locker(&m_mutex);
+        m_count = count;
+        m_sheets.clear();
+        m_sheetsOnDisk = sheetsOnDisk;
+        m_generated = QBitArray(count);
+        for (auto &&sheet : qAsConst(m_sheetsOnDisk)) {
+            for (int index = (sheet * kTilesPerSheet); index < qMin(count, (sheet + 1) * kTilesPerSheet); ++index) {
+                m_generated.setBit(index);
+            }
+        }
+    }
+
+    Q_NODISCARD int count() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_count;
+    }
+
+    Q_NODISCARD qreal progress() const
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_count <= 0) {
+            return 0.0;
+        }
+        return (qreal(m_generated.count(true)) / qreal(m_count));
+    }
+
+    // Draws the given tile, or the closest available one. Returns false if there's none.
+    bool draw(QPainter *painter, const QRectF &target, const int index)
+    {
+        Q_ASSERT(painter);
+        if (!painter) {
+            return false;
+        }
+        QMutexLocker locker(&m_mutex);
+        if ((index < 0) || (index >= m_count)) {
+            return false;
+        }
+        for (int distance = 0; distance <= kNeighbourSearchDistance; ++distance) {
+            for (auto &&candidate : {index - distance, index + distance}) {
+                if ((candidate < 0) || (candidate >= m_count)) {
+                    continue;
+                }
+                // QCache::object() also marks the sheet as recently used.
+                const Sheet * const sheet = m_sheets.object(candidate / kTilesPerSheet);
+                if (!sheet || !sheet->filled.testBit(candidate % kTilesPerSheet)) {
+                    continue;
+                }
+                painter->drawImage(fittedRect(m_tileSize, target), sheet->image, tileRect(candidate));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Returns the missing tile closest to "focus", or -1 if there's none within
+    // "distance". Sheets found in the disk cache are loaded on the way.
+    Q_NODISCARD int nextMissingTile(const int focus, const int distance)
+    {
+        QMutexLocker locker(&m_mutex);
+        for (int offset = 0; offset <= distance; ++offset) {
+            for (auto &&candidate : {focus + offset, focus - offset}) {
+                if ((candidate < 0) || (candidate >= m_count) || ((offset == 0) && (candidate != focus))) {
+                    continue;
+                }
+                const int sheetIndex = (candidate / kTilesPerSheet);
+                if (!m_sheets.contains(sheetIndex) && m_sheetsOnDisk.contains(sheetIndex)) {
+                    locker.unlock();
+                    QImage image(sheetFilePath(sheetIndex));
+                    locker.relock();
+                    if (!image.isNull()) {
+                        Cache::touch(sheetFilePath(sheetIndex));
+                        auto sheet = new Sheet;
+                        sheet->image = image.convertToFormat(QImage::Format_RGB888);
+                        sheet->filled.fill(true, kTilesPerSheet);
+                        m_sheets.insert(sheetIndex, sheet, cost(sheet));
+                        continue;
+                    }
+                    // Broken file, generate the sheet again.
+                    m_sheetsOnDisk.remove(sheetIndex);
+                }
+                const Sheet * const sheet = m_sheets.object(sheetIndex);
+                if (!sheet || !sheet->filled.testBit(candidate % kTilesPerSheet)) {
+                    return candidate;
+                }
+            }
+        }
+        return -1;
+    }
+
+    void setTile(const int index, const QImage &image)
+    {
+        QMutexLocker locker(&m_mutex);
+        if ((index < 0) || (index >= m_count)) {
+            return;
+        }
+        const int sheetIndex = (index / kTilesPerSheet);
+        Sheet *sheet = m_sheets.object(sheetIndex);
+        if (!sheet) {
+            sheet = new Sheet;
+            sheet->image = QImage(m_tileSize.width() * kTilesPerRow, m_tileSize.height() * kTilesPerRow, QImage::Format_RGB888);
+            sheet->image.fill(Qt::black);
+            sheet->filled.resize(kTilesPerSheet);
+            if (!m_sheets.insert(sheetIndex, sheet, cost(sheet))) {
+                // Larger than the whole cache.
+                return;
+            }
+        }
+        {
+            QPainter painter(&sheet->image);
+            const QRect target = tileRect(index);
+            painter.fillRect(target, Qt::black);
+            painter.drawImage(fittedRect(image.size(), target), image);
+        }
+        sheet->filled.setBit(index % kTilesPerSheet);
+        m_generated.setBit(index);
+        const int tilesInSheet = qMin(kTilesPerSheet, m_count - (sheetIndex * kTilesPerSheet));
+        if (m_diskPath.isEmpty() || (sheet->filled.count(true) < tilesInSheet)) {
+            return;
+        }
+        // Only complete sheets are written to disk, so everything found there can be trusted.
+        const QImage completeSheet = sheet->image;
+        const QString filePath = sheetFilePath(sheetIndex);
+        locker.unlock();
+        if (completeSheet.save(filePath, nullptr, kSheetQuality)) {
+            Cache::addFile(filePath);
+            locker.relock();
+            m_sheetsOnDisk.insert(sheetIndex);
+        } else {
+            qCWarning(lcQMPThumbnail) << "Failed to save the thumbnail sheet" << filePath;
+        }
+    }
+
+private:
+    struct Sheet
+    {
+        QImage image = {};
+        QBitArray filled = {};
+    };
+
+    Q_NODISCARD QRect tileRect(const int index) const
+    {
+        const int local = (index % kTilesPerSheet);
+        return {QPoint((local % kTilesPerRow) * m_tileSize.width(), (local / kTilesPerRow) * m_tileSize.height()), m_tileSize};
+    }
+
+    Q_NODISCARD QString sheetFilePath(const int sheetIndex) const
+    {
+        return (m_diskPath + QDir::separator() + QString::number(sheetIndex) + QLatin1String(kSheetFileSuffix));
+    }
+
+    Q_NODISCARD static int cost(const Sheet *sheet)
+    {
+        Q_ASSERT(sheet);
+        if (!sheet) {
+            return 0;
+        }
+        return qMax(1, int(sheet->image.sizeInBytes() / 1024));
+    }
+
+private:
+    const QSize m_tileSize = {};
+    const QString m_diskPath = {};
+    mutable QMutex m_mutex;
+    QCache<int, Sheet> m_sheets;
+    QSet<int> m_sheetsOnDisk = {};
+    QBitArray m_generated = {};
+    int m_count = 0;
+};
+
+class ThumbnailWorker final : public QThread
+{
+    Q_DISABLE_COPY_MOVE(ThumbnailWorker)
+
+public:
+    explicit ThumbnailWorker(ThumbnailIndex *index, ThumbnailDecoder *decoder, const QSharedPointer<ThumbnailStore> &store)
+        : m_index(index), m_decoder(decoder), m_store(store), m_source(index->m_source),
+          m_interval(index->m_interval), m_generation(index->m_generation)
+    {
+        Q_ASSERT(m_index);
+        Q_ASSERT(m_decoder);
+        Q_ASSERT(m_store);
+        m_focusPosition.store(index->m_position);
+    }
+
+    ~ThumbnailWorker() override
+    {
+        requestStop();
+        wait();
+    }
+
+    void requestStop()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopRequested = true;
+        m_condition.wakeAll();
+    }
+
+    void setFocusPosition(const qint64 value)
+    {
+        m_focusPosition.store(value);
+        // Tiles evicted from memory around the new position may need to be generated again.
+        QMutexLocker locker(&m_mutex);
+        m_condition.wakeAll();
+    }
+
+    // Only the latest request matters.
+    void requestAccurateFrame(const qint64 position, const QSize &size)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_accuratePosition = position;
+        m_accurateSize = size;
+        m_condition.wakeAll();
+    }
+
+protected:
+    void run() override
+    {
+        const qint64 duration = m_decoder->open(m_source);
+        if (duration <= 0) {
+            qCWarning(lcQMPThumbnail) << "Failed to open" << m_source << "for thumbnail generation.";
+            return;
+        }
+        const int count = int(duration / m_interval) + 1;
+        m_store->reset(count);
+        post([duration](ThumbnailIndex *index){
+            index->m_duration = duration;
+            Q_EMIT index->durationChanged();
+        });
+        postProgress();
+        qCDebug(lcQMPThumbnail) << "Generating" << count << "thumbnails for" << m_source;
+        bool firstPassFinished = false;
+        while (true) {
+            qint64 accuratePosition = -1;
+            QSize accurateSize = {};
+            {
+                QMutexLocker locker(&m_mutex);
+                if (m_stopRequested) {
+                    break;
+                }
+                accuratePosition = std::exchange(m_accuratePosition, -1);
+                accurateSize = m_accurateSize;
+            }
+            // The user is waiting for this one, it always goes first.
+            if (accuratePosition >= 0) {
+                const QImage image = m_decoder->decode(accuratePosition, true, accurateSize);
+                if (!image.isNull()) {
+                    post([accuratePosition, image](ThumbnailIndex *index){
+                        if (index->m_position != accuratePosition) {
+                            return;
+                        }
+                        index->m_accurateImage = image;
+                        index->m_accuratePosition = accuratePosition;
+                        index->update();
+                    });
+                }
+                continue;
+            }
+            const int focus = qBound(0, int(m_focusPosition.load() / m_interval), count - 1);
+            const int tile = m_store->nextMissingTile(focus, (firstPassFinished ? kRegenerationDistance : count));
+            if (tile < 0) {
+                if (!firstPassFinished) {
+                    firstPassFinished = true;
+                    qCDebug(lcQMPThumbnail) << "Thumbnail index of" << m_source << "is complete.";
+                }
+                QMutexLocker locker(&m_mutex);
+                if (!m_stopRequested && (m_accuratePosition < 0)) {
+                    m_condition.wait(&m_mutex);
+                }
+                continue;
+            }
+            QImage image = m_decoder->decode(qint64(tile) * m_interval, false, m_store->tileSize());
+            if (image.isNull()) {
+                // Store a black tile anyway, retrying a broken frame forever helps nobody.
+                image = QImage(m_store->tileSize(), QImage::Format_RGB888);
+                image.fill(Qt::black);
+            }
+            m_store->setTile(tile, image);
+            postProgress();
+        }
+    }
+
+private:
+    template<typename Function>
+    void post(Function &&function)
+    {
+        const quint64 generation = m_generation;
+        ThumbnailIndex * const index = m_index;
+        QMetaObject::invokeMethod(index, [index, generation, function](){
+            if (index->m_generation != generation) {
+                return;
+            }
+            function(index);
+        }, Qt::QueuedConnection);
+    }
+
+    void postProgress()
+    {
+        const qreal progress = m_store->progress();
+        post([progress](ThumbnailIndex *index){
+            index->update();
+            if (qFuzzyCompare(index->m_progress, progress)) {
+                return;
+            }
+            index->m_progress = progress;
+            Q_EMIT index->progressChanged();
+        });
+    }
+
+private:
+    ThumbnailIndex *m_index = nullptr;
+    QScopedPointer<ThumbnailDecoder> m_decoder;
+    QSharedPointer<ThumbnailStore> m_store;
+    const QUrl m_source = {};
+    const qint64 m_interval = 0;
+    const quint64 m_generation = 0;
+    std::atomic<qint64> m_focusPosition{0};
+
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+    bool m_stopRequested = false;
+    qint64 m_accuratePosition = -1;
+    QSize m_accurateSize = {};
+};
+
+ThumbnailIndex::ThumbnailIndex(QQuickItem *parent) : QQuickPaintedItem(parent)
+{
+    setFillColor(Qt::black);
+    m_restTimer.setSingleShot(true);
+    connect(&m_restTimer, &QTimer::timeout, this, [this](){
+        if (!m_worker || (m_accuratePosition == m_position)) {
+            return;
+        }
+        const qreal dpr = (window() ? window()->effectiveDevicePixelRatio() : 1.0);
+        const QSize size = QSizeF(width() * dpr, height() * dpr).toSize();
+        if (size.isEmpty()) {
+            return;
+        }
+        m_worker->requestAccurateFrame(m_position, size);
+    });
+}
+
+ThumbnailIndex::~ThumbnailIndex()
+{
+    stopWorker();
+}
+
+QUrl ThumbnailIndex::source() const
+{
+    return m_source;
+}
+
+void ThumbnailIndex::setSource(const QUrl &value)
+{
+    if (m_source == value) {
+        return;
+    }
+    m_source = value;
+    Q_EMIT sourceChanged();
+    restart();
+}
+
+qint64 ThumbnailIndex::position() const
+{
+    return m_position;
+}
+
+void ThumbnailIndex::setPosition(const qint64 value)
+{
+    if (m_position == value) {
+        return;
+    }
+    m_position = value;
+    if (m_worker) {
+        m_worker->setFocusPosition(m_position);
+    }
+    if (m_restDelay >= 0) {
+        m_restTimer.start(m_restDelay);
+    }
+    update();
+    Q_EMIT positionChanged();
+}
+
+qint64 ThumbnailIndex::duration() const
+{
+    return m_duration;
+}
+
+int ThumbnailIndex::interval() const
+{
+    return m_interval;
+}
+
+void ThumbnailIndex::setInterval(const int value)
+{
+    Q_ASSERT(value > 0);
+    if ((value <= 0) || (m_interval == value)) {
+        return;
+    }
+    m_interval = value;
+    Q_EMIT intervalChanged();
+    restart();
+}
+
+QSize ThumbnailIndex::thumbnailSize() const
+{
+    return m_thumbnailSize;
+}
+
+void ThumbnailIndex::setThumbnailSize(const QSize &value)
+{
+    Q_ASSERT(!value.isEmpty());
+    if (value.isEmpty() || (m_thumbnailSize == value)) {
+        return;
+    }
+    m_thumbnailSize = value;
+    Q_EMIT thumbnailSizeChanged();
+    restart();
+}
+
+int ThumbnailIndex::restDelay() const
+{
+    return m_restDelay;
+}
+
+void ThumbnailIndex::setRestDelay(const int value)
+{
+    if (m_restDelay == value) {
+        return;
+    }
+    m_restDelay = value;
+    if (m_restDelay < 0) {
+        m_restTimer.stop();
+    }
+    Q_EMIT restDelayChanged();
+}
+
+int ThumbnailIndex::memoryLimit() const
+{
+    return m_memoryLimit;
+}
+
+void ThumbnailIndex::setMemoryLimit(const int value)
+{
+    Q_ASSERT(value > 0);
+    if ((value <= 0) || (m_memoryLimit == value)) {
+        return;
+    }
+    m_memoryLimit = value;
+    if (m_store) {
+        m_store->setMemoryLimit(m_memoryLimit);
+    }
+    Q_EMIT memoryLimitChanged();
+}
+
+bool ThumbnailIndex::diskCache() const
+{
+    return m_diskCache;
+}
+
+void ThumbnailIndex::setDiskCache(const bool value)
+{
+    if (m_diskCache == value) {
+        return;
+    }
+    m_diskCache = value;
+    Q_EMIT diskCacheChanged();
+    restart();
+}
+
+qreal ThumbnailIndex::progress() const
+{
+    return m_progress;
+}
+
+void ThumbnailIndex::paint(QPainter *painter)
+{
+    Q_ASSERT(painter);
+    if (!painter) {
+        return;
+    }
+    const QRectF target = {0, 0, width(), height()};
+    if ((m_accuratePosition == m_position) && !m_accurateImage.isNull()) {
+        painter->drawImage(fittedRect(m_accurateImage.size(), target), m_accurateImage);
+        return;
+    }
+    if (!m_store || (m_interval <= 0)) {
+        return;
+    }
+    m_store->draw(painter, target, int(qRound64(qreal(m_position) / qreal(m_interval))));
+}
+
+void ThumbnailIndex::componentComplete()
+{
+    QQuickPaintedItem::componentComplete();
+    restart();
+}
+
+void ThumbnailIndex::restart()
+{
+    if (!isComponentComplete()) {
+        return;
+    }
+    stopWorker();
+    ++m_generation;
+    m_store.reset();
+    m_accurateImage = {};
+    m_accuratePosition = -1;
+    m_restTimer.stop();
+    if (m_duration != 0) {
+        m_duration = 0;
+        Q_EMIT durationChanged();
+    }
+    if (!qFuzzyIsNull(m_progress)) {
+        m_progress = 0.0;
+        Q_EMIT progressChanged();
+    }
+    update();
+    if (!m_source.isValid()) {
+        return;
+    }
+    const auto decoder = createDecoder();
+    if (!decoder) {
+        qCWarning(lcQMPThumbnail) << "This backend can't decode thumbnails.";
+        return;
+    }
+    QString diskPath = {};
+    if (m_diskCache) {
+        const QString key = Cache::mediaKey(m_source);
+        if (!key.isEmpty()) {
+            diskPath = Cache::directoryPath(QStringLiteral("thumbnails/%1/%2_%3x%4").arg(key,
+                           QString::number(m_interval), QString::number(m_thumbnailSize.width()),
+                           QString::number(m_thumbnailSize.height())));
+        }
+    }
+    m_store.reset(new ThumbnailStore(m_thumbnailSize, m_memoryLimit, diskPath));
+    m_worker = new ThumbnailWorker(this, decoder, m_store);
+    // Never compete with the actual playback.
+    m_worker->start(QThread::LowestPriority);
+}
+
+void ThumbnailIndex::stopWorker()
+{
+    if (!m_worker) {
+        return;
+    }
+    // Blocks until the frame being decoded right now is done.
+    delete m_worker;
+    m_worker = nullptr;
+}
+
+QTMEDIAPLAYER_END_NAMESPACE
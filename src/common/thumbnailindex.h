@@ -0,0 +1,170 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "../loader/qtmediaplayer_global.h"
+#include <QtCore/qurl.h>
+#include <QtCore/qtimer.h>
+#include <QtCore/qsharedpointer.h>
+#include <QtGui/qimage.h>
+#include <QtQuick/qquickpainteditem.h>
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(lcQMPThumbnail)
+
+// Decodes single video frames for the thumbnail index. Every backend provides
+// its own implementation. All functions are called on the worker thread.
+class ThumbnailDecoder
+{
+    Q_DISABLE_COPY_MOVE(ThumbnailDecoder)
+
+public:
+    explicit ThumbnailDecoder() = default;
+    virtual ~ThumbnailDecoder() = default;
+
+    // Returns the duration of the media in milliseconds, or a negative value on failure.
+    Q_NODISCARD virtual qint64 open(const QUrl &url) = 0;
+
+    // Decodes the frame at the given position, scaled to fit into "size". Without
+    // "accurate", the nearest key frame before the position is good enough.
+    // "timestamp" receives the presentation time of the decoded frame in
+    // milliseconds, or a negative value if the backend can't tell.
+    Q_NODISCARD virtual QImage decode(const qint64 position, const bool accurate, const QSize &size,
+                                      qint64 *timestamp = nullptr) = 0;
+
+    // Decodes the frame following the previously decoded one, for walking through
+    // a whole GOP without seeking. Not every backend supports it.
+    Q_NODISCARD virtual QImage decodeNext(const QSize &size, qint64 *timestamp = nullptr)
+    {
+        Q_UNUSED(size);
+        if (timestamp) {
+            *timestamp = -1;
+        }
+        return {};
+    }
+};
+
+class ThumbnailStore;
+class ThumbnailWorker;
+
+// Timeline preview: decodes a key frame every "interval" milliseconds in the
+// background and shows the one closest to "position" instantly. An accurate
+// frame is only decoded once "position" stays unchanged for "restDelay".
+class ThumbnailIndex : public QQuickPaintedItem
+{
+    Q_OBJECT
+    Q_DISABLE_COPY_MOVE(ThumbnailIndex)
+    Q_PROPERTY(QUrl source READ source WRITE setSource NOTIFY sourceChanged)
+    Q_PROPERTY(qint64 position READ position WRITE setPosition NOTIFY positionChanged)
+    Q_PROPERTY(qint64 duration READ duration NOTIFY durationChanged)
+    Q_PROPERTY(int interval READ interval WRITE setInterval NOTIFY intervalChanged)
+    Q_PROPERTY(QSize thumbnailSize READ thumbnailSize WRITE setThumbnailSize NOTIFY thumbnailSizeChanged)
+    Q_PROPERTY(int restDelay READ restDelay WRITE setRestDelay NOTIFY restDelayChanged)
+    Q_PROPERTY(int memoryLimit READ memoryLimit WRITE setMemoryLimit NOTIFY memoryLimitChanged)
+    Q_PROPERTY(bool diskCache READ diskCache WRITE setDiskCache NOTIFY diskCacheChanged)
+    Q_PROPERTY(qreal progress READ progress NOTIFY progressChanged)
+
+    friend class ThumbnailWorker;
+
+public:
+    explicit ThumbnailIndex(QQuickItem *parent = nullptr);
+    ~ThumbnailIndex() override;
+
+    Q_NODISCARD QUrl source() const;
+    void setSource(const QUrl &value);
+
+    // The position to preview, in milliseconds.
+    Q_NODISCARD qint64 position() const;
+    void setPosition(const qint64 value);
+
+    Q_NODISCARD qint64 duration() const;
+
+    // Distance between two indexed thumbnails, in milliseconds.
+    Q_NODISCARD int interval() const;
+    void setInterval(const int value);
+
+    // Size of each indexed thumbnail, in pixels.
+    Q_NODISCARD QSize thumbnailSize() const;
+    void setThumbnailSize(const QSize &value);
+
+    // In milliseconds. A negative value disables the accurate decoding.
+    Q_NODISCARD int restDelay() const;
+    void setRestDelay(const int value);
+
+    // Upper bound of the in-memory sprite sheets, in megabytes.
+    Q_NODISCARD int memoryLimit() const;
+    void setMemoryLimit(const int value);
+
+    Q_NODISCARD bool diskCache() const;
+    void setDiskCache(const bool value);
+
+    // Fraction of the index which has been generated, from 0 to 1.
+    Q_NODISCARD qreal progress() const;
+
+    void paint(QPainter *painter) override;
+
+protected:
+    Q_NODISCARD virtual ThumbnailDecoder *createDecoder() const = 0;
+
+    void componentComplete() override;
+
+private:
+    void restart();
+    void stopWorker();
+
+Q_SIGNALS:
+    void sourceChanged();
+    void positionChanged();
+    void durationChanged();
+    void intervalChanged();
+    void thumbnailSizeChanged();
+    void restDelayChanged();
+    void memoryLimitChanged();
+    void diskCacheChanged();
+    void progressChanged();
+
+private:
+    QUrl m_source = {};
+    qint64 m_position = 0;
+    qint64 m_duration = 0;
+    int m_interval = 10000;
+    QSize m_thumbnailSize = {160, 90};
+    int m_restDelay = 300;
+    int m_memoryLimit = 64;
+    bool m_diskCache = true;
+    qreal m_progress = 0.0;
+
+    QSharedPointer<ThumbnailStore> m_store;
+    ThumbnailWorker *m_worker = nullptr;
+    quint64 m_generation = 0; // Drops results of workers which have been replaced already.
+    QTimer m_restTimer;
+
+    // Only touched on the GUI thread, or the render thread while the GUI thread is blocked.
+    QImage m_accurateImage = {};
+    qint64 m_accuratePosition = -1;
+};
+
+QTMEDIAPLAYER_END_NAMESPACE
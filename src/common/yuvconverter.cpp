@@ -0,0 +1,558 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "yuvconverter.h"
+#include <QtCore/qdebug.h>
+#include <QtCore/qsemaphore.h>
+#include <QtCore/qthread.h>
+#include <QtCore/qthreadpool.h>
+#include <vector>
+
+#if defined(Q_PROCESSOR_X86)
+#  define QMP_YUV_X86
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#  endif
+#  include <immintrin.h>
+#  if defined(__GNUC__) || defined(__clang__)
+#    define QMP_YUV_TARGET(x) __attribute__((target(x)))
+#  else
+#    define QMP_YUV_TARGET(x)
+#  endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  define QMP_YUV_NEON
+#  include <arm_neon.h>
+#endif
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+static constexpr const char _qmp_yuv_kernel_envVar[] = "QTMEDIAPLAYER_YUV_KERNEL";
+
+// Slices smaller than this are not worth a trip through the thread pool.
+static constexpr const int kMinimumRowsPerSlice = 64;
+
+// 6 bit fixed point, BT.601 limited range for example:
+//   Y' = (Y - 16) * 74.5 + 32 (74 + a half computed by a shift, the 32 rounds the final shift)
+//   R = (Y' + 102 * V) >> 6
+//   G = (Y' - 25 * U - 52 * V) >> 6
+//   B = (Y' + 129 * U) >> 6
+// with U and V centered at zero. Full range has no luma offset and a luma
+// scale of exactly 64, the other matrices only differ in the chroma factors.
+// All intermediate values fit into 16 bit signed integers except the red and
+// blue channels, which the SIMD kernels compute with saturating additions.
+// Saturation only happens for values far above 255, which are clamped anyway,
+// so the scalar code doesn't need to emulate it.
+static constexpr const int kChromaOffset = 128;
+static constexpr const int kRounding = 32;
+static constexpr const int kPrecisionBits = 6;
+
+struct Coefficients
+{
+    int lumaOffset = 0;
+    int lumaScale = 0;
+    int lumaHalfMask = 0; // -1 adds another half of the offset luma, 0 doesn't.
+    int redFromV = 0;
+    int greenFromU = 0;
+    int greenFromV = 0;
+    int blueFromU = 0;
+};
+
+// Indexed by range, then by matrix.
+static constexpr const Coefficients kCoefficients[2][2] = {
+    {
+        {16, 74, -1, 102, 25, 52, 129}, // BT.601 limited
+        {16, 74, -1, 115, 14, 34, 135}  // BT.709 limited
+    },
+    {
+        {0, 64, 0, 90, 22, 46, 113}, // BT.601 full
+        {0, 64, 0, 101, 12, 30, 119} // BT.709 full
+    }
+};
+
+[[nodiscard]] static inline const Coefficients &coefficientsOf(const YUVConverter::Frame &frame)
+{
+    const int range = ((frame.range == YUVConverter::ColorRange::Full) ? 1 : 0);
+    const int matrix = ((frame.matrix == YUVConverter::ColorMatrix::BT709) ? 1 : 0);
+    return kCoefficients[range][matrix];
+}
+
+using RowKernel = void(*)(const uchar *y, const uchar *u, const uchar *v, uchar *dst, const int width, const Coefficients &c);
+
+[[nodiscard]] static inline uchar clampToByte(const int value)
+{
+    return static_cast<uchar>(qBound(0, value >> kPrecisionBits, 255));
+}
+
+static inline void convertPixelsScalar(const uchar *y, const uchar *u, const uchar *v,
+                                       uchar *dst, const int begin, const int end, const Coefficients &c)
+{
+    for (int x = begin; x != end; ++x) {
+        const int offsetLuma = y[x] - c.lumaOffset;
+        const int luma = (offsetLuma * c.lumaScale) + ((offsetLuma >> 1) & c.lumaHalfMask) + kRounding;
+        const int cb = u[x >> 1] - kChromaOffset;
+        const int cr = v[x >> 1] - kChromaOffset;
+        uchar *pixel = dst + (x * 4);
+        pixel[0] = clampToByte(luma + (c.redFromV * cr));
+        pixel[1] = clampToByte(luma - (c.greenFromU * cb) - (c.greenFromV * cr));
+        pixel[2] = clampToByte(luma + (c.blueFromU * cb));
+        pixel[3] = 255;
+    }
+}
+
+static void convertRowScalar(const uchar *y, const uchar *u, const uchar *v, uchar *dst, const int width, const Coefficients &c)
+{
+    convertPixelsScalar(y, u, v, dst, 0, width, c);
+}
+
+#ifdef QMP_YUV_X86
+// Stores 16 pixels, given as one register per channel, as RGBA.
+QMP_YUV_TARGET("sse2") static inline void storeRGBA_SSE2(uchar *dst, const __m128i r, const __m128i g, const __m128i b)
+{
+    const __m128i a = _mm_set1_epi8(static_cast<char>(-1));
+    const __m128i rgLow = _mm_unpacklo_epi8(r, g);
+    const __m128i rgHigh = _mm_unpackhi_epi8(r, g);
+    const __m128i baLow = _mm_unpacklo_epi8(b, a);
+    const __m128i baHigh = _mm_unpackhi_epi8(b, a);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_unpacklo_epi16(rgLow, baLow));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 16), _mm_unpackhi_epi16(rgLow, baLow));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 32), _mm_unpacklo_epi16(rgHigh, baHigh));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 48), _mm_unpackhi_epi16(rgHigh, baHigh));
+}
+
+// The coefficients broadcast to all lanes, set up once per row.
+struct CoefficientsSSE2
+{
+    __m128i lumaOffset;
+    __m128i lumaScale;
+    __m128i lumaHalfMask;
+    __m128i rounding;
+    __m128i redFromV;
+    __m128i greenFromU;
+    __m128i greenFromV;
+    __m128i blueFromU;
+};
+
+QMP_YUV_TARGET("sse2") static inline CoefficientsSSE2 broadcast_SSE2(const Coefficients &c)
+{
+    return {_mm_set1_epi16(c.lumaOffset), _mm_set1_epi16(c.lumaScale), _mm_set1_epi16(c.lumaHalfMask),
+            _mm_set1_epi16(kRounding), _mm_set1_epi16(c.redFromV), _mm_set1_epi16(c.greenFromU),
+            _mm_set1_epi16(c.greenFromV), _mm_set1_epi16(c.blueFromU)};
+}
+
+// Converts 8 pixels, all values are 16 bit lanes, chroma already duplicated and centered.
+QMP_YUV_TARGET("sse2") static inline void convert8_SSE2(const __m128i y, const __m128i u, const __m128i v,
+                                                         const CoefficientsSSE2 &c, __m128i *r, __m128i *g, __m128i *b)
+{
+    const __m128i offsetLuma = _mm_sub_epi16(y, c.lumaOffset);
+    const __m128i luma = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(offsetLuma, c.lumaScale),
+                                                     _mm_and_si128(_mm_srai_epi16(offsetLuma, 1), c.lumaHalfMask)), c.rounding);
+    *r = _mm_srai_epi16(_mm_adds_epi16(luma, _mm_mullo_epi16(v, c.redFromV)), kPrecisionBits);
+    *g = _mm_srai_epi16(_mm_subs_epi16(_mm_subs_epi16(luma, _mm_mullo_epi16(u, c.greenFromU)),
+                                       _mm_mullo_epi16(v, c.greenFromV)), kPrecisionBits);
+    *b = _mm_srai_epi16(_mm_adds_epi16(luma, _mm_mullo_epi16(u, c.blueFromU)), kPrecisionBits);
+}
+
+QMP_YUV_TARGET("sse2") static void convertRowSSE2(const uchar *y, const uchar *u, const uchar *v, uchar *dst, const int width, const Coefficients &c)
+{
+    const CoefficientsSSE2 coefficients = broadcast_SSE2(c);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i chromaOffset = _mm_set1_epi16(kChromaOffset);
+    const int blockEnd = width & ~15;
+    for (int x = 0; x != blockEnd; x += 16) {
+        const __m128i luma = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y + x));
+        const __m128i cb = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(u + (x >> 1))), zero), chromaOffset);
+        const __m128i cr = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(v + (x >> 1))), zero), chromaOffset);
+        __m128i rLow, gLow, bLow, rHigh, gHigh, bHigh;
+        convert8_SSE2(_mm_unpacklo_epi8(luma, zero), _mm_unpacklo_epi16(cb, cb), _mm_unpacklo_epi16(cr, cr), coefficients, &rLow, &gLow, &bLow);
+        convert8_SSE2(_mm_unpackhi_epi8(luma, zero), _mm_unpackhi_epi16(cb, cb), _mm_unpackhi_epi16(cr, cr), coefficients, &rHigh, &gHigh, &bHigh);
+        storeRGBA_SSE2(dst + (x * 4), _mm_packus_epi16(rLow, rHigh), _mm_packus_epi16(gLow, gHigh), _mm_packus_epi16(bLow, bHigh));
+    }
+    convertPixelsScalar(y, u, v, dst, blockEnd, width, c);
+}
+
+// Same as the SSE2 kernel, but all 16 pixels of a block go through the math in one 256 bit register.
+QMP_YUV_TARGET("avx2") static void convertRowAVX2(const uchar *y, const uchar *u, const uchar *v, uchar *dst, const int width, const Coefficients &c)
+{
+    const __m256i chromaOffset = _mm256_set1_epi16(kChromaOffset);
+    const __m256i lumaOffset = _mm256_set1_epi16(c.lumaOffset);
+    const __m256i lumaScale = _mm256_set1_epi16(c.lumaScale);
+    const __m256i lumaHalfMask = _mm256_set1_epi16(c.lumaHalfMask);
+    const __m256i rounding = _mm256_set1_epi16(kRounding);
+    const __m256i redFromV = _mm256_set1_epi16(c.redFromV);
+    const __m256i greenFromU = _mm256_set1_epi16(c.greenFromU);
+    const __m256i greenFromV = _mm256_set1_epi16(c.greenFromV);
+    const __m256i blueFromU = _mm256_set1_epi16(c.blueFromU);
+    const int blockEnd = width & ~15;
+    for (int x = 0; x != blockEnd; x += 16) {
+        const __m256i luma = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(y + x)));
+        const __m128i cb8 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(u + (x >> 1)));
+        const __m128i cr8 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(v + (x >> 1)));
+        const __m256i cb = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_unpacklo_epi8(cb8, cb8)), chromaOffset);
+        const __m256i cr = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_unpacklo_epi8(cr8, cr8)), chromaOffset);
+        const __m256i offsetLuma = _mm256_sub_epi16(luma, lumaOffset);
+        const __m256i scaledLuma = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(offsetLuma, lumaScale),
+                                                                     _mm256_and_si256(_mm256_srai_epi16(offsetLuma, 1), lumaHalfMask)), rounding);
+        const __m256i r = _mm256_srai_epi16(_mm256_adds_epi16(scaledLuma, _mm256_mullo_epi16(cr, redFromV)), kPrecisionBits);
+        const __m256i g = _mm256_srai_epi16(_mm256_subs_epi16(_mm256_subs_epi16(scaledLuma, _mm256_mullo_epi16(cb, greenFromU)),
+                                                              _mm256_mullo_epi16(cr, greenFromV)), kPrecisionBits);
+        const __m256i b = _mm256_srai_epi16(_mm256_adds_epi16(scaledLuma, _mm256_mullo_epi16(cb, blueFromU)), kPrecisionBits);
+        storeRGBA_SSE2(dst + (x * 4),
+                       _mm_packus_epi16(_mm256_castsi256_si128(r), _mm256_extracti128_si256(r, 1)),
+                       _mm_packus_epi16(_mm256_castsi256_si128(g), _mm256_extracti128_si256(g, 1)),
+                       _mm_packus_epi16(_mm256_castsi256_si128(b), _mm256_extracti128_si256(b, 1)));
+    }
+    convertPixelsScalar(y, u, v, dst, blockEnd, width, c);
+}
+
+[[nodiscard]] static inline bool cpuSupportsSSE2()
+{
+#if defined(Q_PROCESSOR_X86_64) || defined(__SSE2__)
+    return true;
+#elif defined(_MSC_VER)
+    int info[4] = {};
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26));
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+
+[[nodiscard]] static inline bool cpuSupportsAVX2()
+{
+#ifdef _MSC_VER
+    int info[4] = {};
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    // The OS must save the YMM registers on context switches as well.
+    const bool osxsave = (info[2] & (1 << 27));
+    const bool avx = (info[2] & (1 << 28));
+    if (!osxsave || !avx || ((_xgetbv(0) & 0x6) != 0x6)) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5));
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif // QMP_YUV_X86
+
+#ifdef QMP_YUV_NEON
+static inline void convert8_NEON(const int16x8_t y, const int16x8_t u, const int16x8_t v, const Coefficients &c,
+                                 uint8x8_t *r, uint8x8_t *g, uint8x8_t *b)
+{
+    const int16x8_t offsetLuma = vsubq_s16(y, vdupq_n_s16(c.lumaOffset));
+    const int16x8_t luma = vaddq_s16(vaddq_s16(vmulq_n_s16(offsetLuma, c.lumaScale),
+                                               vandq_s16(vshrq_n_s16(offsetLuma, 1), vdupq_n_s16(c.lumaHalfMask))), vdupq_n_s16(kRounding));
+    // vqshrun: arithmetic shift, then saturate to [0, 255], exactly what the other kernels do in two steps.
+    *r = vqshrun_n_s16(vqaddq_s16(luma, vmulq_n_s16(v, c.redFromV)), kPrecisionBits);
+    *g = vqshrun_n_s16(vqsubq_s16(vqsubq_s16(luma, vmulq_n_s16(u, c.greenFromU)), vmulq_n_s16(v, c.greenFromV)), kPrecisionBits);
+    *b = vqshrun_n_s16(vqaddq_s16(luma, vmulq_n_s16(u, c.blueFromU)), kPrecisionBits);
+}
+
+static void convertRowNEON(const uchar *y, const uchar *u, const uchar *v, uchar *dst, const int width, const Coefficients &c)
+{
+    const int16x8_t chromaOffset = vdupq_n_s16(kChromaOffset);
+    const int blockEnd = width & ~15;
+    for (int x = 0; x != blockEnd; x += 16) {
+        const uint8x16_t luma = vld1q_u8(y + x);
+        const int16x8_t cb = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(u + (x >> 1)))), chromaOffset);
+        const int16x8_t cr = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(v + (x >> 1)))), chromaOffset);
+        const int16x8x2_t cbPairs = vzipq_s16(cb, cb);
+        const int16x8x2_t crPairs = vzipq_s16(cr, cr);
+        uint8x8_t rLow, gLow, bLow, rHigh, gHigh, bHigh;
+        convert8_NEON(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(luma))), cbPairs.val[0], crPairs.val[0], c, &rLow, &gLow, &bLow);
+        convert8_NEON(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(luma))), cbPairs.val[1], crPairs.val[1], c, &rHigh, &gHigh, &bHigh);
+        uint8x16x4_t rgba;
+        rgba.val[0] = vcombine_u8(rLow, rHigh);
+        rgba.val[1] = vcombine_u8(gLow, gHigh);
+        rgba.val[2] = vcombine_u8(bLow, bHigh);
+        rgba.val[3] = vdupq_n_u8(255);
+        vst4q_u8(dst + (x * 4), rgba);
+    }
+    convertPixelsScalar(y, u, v, dst, blockEnd, width, c);
+}
+#endif // QMP_YUV_NEON
+
+[[nodiscard]] static inline RowKernel rowKernel(const YUVConverter::Kernel kernel)
+{
+    switch (kernel) {
+#ifdef QMP_YUV_X86
+    case YUVConverter::Kernel::SSE2:
+        return convertRowSSE2;
+    case YUVConverter::Kernel::AVX2:
+        return convertRowAVX2;
+#endif
+#ifdef QMP_YUV_NEON
+    case YUVConverter::Kernel::NEON:
+        return convertRowNEON;
+#endif
+    default:
+        break;
+    }
+    return convertRowScalar;
+}
+
+[[nodiscard]] static inline YUVConverter::Kernel resolveKernel(const YUVConverter::Kernel kernel)
+{
+    if ((kernel != YUVConverter::Kernel::Auto) && YUVConverter::isKernelSupported(kernel)) {
+        return kernel;
+    }
+    return YUVConverter::bestKernel();
+}
+
+namespace YUVConverter
+{
+
+bool isKernelSupported(const Kernel kernel)
+{
+    switch (kernel) {
+    case Kernel::Auto:
+    case Kernel::Scalar:
+        return true;
+#ifdef QMP_YUV_X86
+    case Kernel::SSE2: {
+        static const bool supported = cpuSupportsSSE2();
+        return supported;
+    }
+    case Kernel::AVX2: {
+        static const bool supported = cpuSupportsAVX2();
+        return supported;
+    }
+#endif
+#ifdef QMP_YUV_NEON
+    case Kernel::NEON:
+        return true;
+#endif
+    default:
+        break;
+    }
+    return false;
+}
+
+Kernel bestKernel()
+{
+    static const Kernel kernel = []() -> Kernel {
+        const QString forced = qEnvironmentVariable(_qmp_yuv_kernel_envVar).trimmed();
+        if (!forced.isEmpty()) {
+            for (auto &&candidate : {Kernel::Scalar, Kernel::SSE2, Kernel::AVX2, Kernel::NEON}) {
+                if (forced.compare(kernelName(candidate), Qt::CaseInsensitive) != 0) {
+                    continue;
+                }
+                if (isKernelSupported(candidate)) {
+                    return candidate;
+                }
+                qWarning() << "The YUV conversion kernel" << forced << "is not supported by this CPU.";
+                break;
+            }
+        }
+        for (auto &&candidate : {Kernel::AVX2, Kernel::NEON, Kernel::SSE2}) {
+            if (isKernelSupported(candidate)) {
+                return candidate;
+            }
+        }
+        return Kernel::Scalar;
+    }();
+    return kernel;
+}
+
+QString kernelName(const Kernel kernel)
+{
+    switch (kernel) {
+    case Kernel::Auto:
+        return QStringLiteral("Auto");
+    case Kernel::Scalar:
+        return QStringLiteral("Scalar");
+    case Kernel::SSE2:
+        return QStringLiteral("SSE2");
+    case Kernel::AVX2:
+        return QStringLiteral("AVX2");
+    case Kernel::NEON:
+        return QStringLiteral("NEON");
+    }
+    return {};
+}
+
+void convertRows(const Frame &frame, uchar *dst, const int dstBytesPerLine,
+                 const int firstRow, const int rowCount, const Kernel kernel)
+{
+    Q_ASSERT(dst);
+    Q_ASSERT(frame.format != PixelFormat::Unknown);
+    Q_ASSERT((firstRow >= 0) && ((firstRow + rowCount) <= frame.height));
+    if (!dst || (frame.format == PixelFormat::Unknown) || (firstRow < 0) || (rowCount <= 0)
+            || ((firstRow + rowCount) > frame.height) || (frame.width <= 0)) {
+        return;
+    }
+    const RowKernel convertRow = rowKernel(resolveKernel(kernel));
+    const Coefficients &coefficients = coefficientsOf(frame);
+    const int chromaWidth = (frame.width + 1) / 2;
+    // The kernels only understand planar 8 bit rows. I420 already is,
+    // the other formats get repacked into these buffers row by row.
+    std::vector<uchar> lumaRow = {};
+    std::vector<uchar> cbRow = {};
+    std::vector<uchar> crRow = {};
+    if (frame.format != PixelFormat::I420) {
+        cbRow.resize(chromaWidth);
+        crRow.resize(chromaWidth);
+    }
+    if (frame.format == PixelFormat::P010) {
+        lumaRow.resize(frame.width);
+    }
+    for (int row = firstRow; row != (firstRow + rowCount); ++row) {
+        const uchar *luma = frame.planes[0] + (qsizetype(row) * frame.bytesPerLine[0]);
+        const uchar *cb = nullptr;
+        const uchar *cr = nullptr;
+        const int chromaRow = (row >> 1);
+        switch (frame.format) {
+        case PixelFormat::I420:
+            cb = frame.planes[1] + (qsizetype(chromaRow) * frame.bytesPerLine[1]);
+            cr = frame.planes[2] + (qsizetype(chromaRow) * frame.bytesPerLine[2]);
+            break;
+        case PixelFormat::NV12: {
+            const uchar *chroma = frame.planes[1] + (qsizetype(chromaRow) * frame.bytesPerLine[1]);
+            for (int x = 0; x != chromaWidth; ++x) {
+                cbRow[x] = chroma[x * 2];
+                crRow[x] = chroma[(x * 2) + 1];
+            }
+            cb = cbRow.data();
+            cr = crRow.data();
+        } break;
+        case PixelFormat::P010: {
+            // Only the high byte of each little endian sample is used, the
+            // output has 8 bits per channel anyway.
+            for (int x = 0; x != frame.width; ++x) {
+                lumaRow[x] = luma[(x * 2) + 1];
+            }
+            luma = lumaRow.data();
+            const uchar *chroma = frame.planes[1] + (qsizetype(chromaRow) * frame.bytesPerLine[1]);
+            for (int x = 0; x != chromaWidth; ++x) {
+                cbRow[x] = chroma[(x * 4) + 1];
+                crRow[x] = chroma[(x * 4) + 3];
+            }
+            cb = cbRow.data();
+            cr = crRow.data();
+        } break;
+        default:
+            Q_UNREACHABLE();
+            break;
+        }
+        convertRow(luma, cb, cr, dst + (qsizetype(row - firstRow) * dstBytesPerLine), frame.width, coefficients);
+    }
+}
+
+bool convert(const Frame &frame, QImage *image, const Kernel kernel)
+{
+    Q_ASSERT(image);
+    Q_ASSERT(frame.format != PixelFormat::Unknown);
+    Q_ASSERT((frame.width > 0) && (frame.height > 0));
+    if (!image || (frame.format == PixelFormat::Unknown) || (frame.width <= 0) || (frame.height <= 0)) {
+        return false;
+    }
+    const QSize size = {frame.width, frame.height};
+    if ((image->size() != size) || (image->format() != QImage::Format_RGBA8888)) {
+        *image = QImage(size, QImage::Format_RGBA8888);
+        if (image->isNull()) {
+            return false;
+        }
+    }
+    const Kernel resolvedKernel = resolveKernel(kernel);
+    uchar * const bits = image->bits();
+    const int bytesPerLine = image->bytesPerLine();
+    QThreadPool * const pool = QThreadPool::globalInstance();
+    const int sliceCount = qBound(1, qMin(pool->maxThreadCount(), QThread::idealThreadCount()), frame.height / kMinimumRowsPerSlice);
+    // Keep the slices at even rows so that each chroma row belongs to exactly one slice.
+    const int rowsPerSlice = ((((frame.height + sliceCount - 1) / sliceCount) + 1) & ~1);
+    QSemaphore finishedSlices(0);
+    int startedSlices = 0;
+    for (int firstRow = rowsPerSlice; firstRow < frame.height; firstRow += rowsPerSlice) {
+        const int rowCount = qMin(rowsPerSlice, frame.height - firstRow);
+        const auto convertSlice = [&frame, &finishedSlices, bits, bytesPerLine, firstRow, rowCount, resolvedKernel](){
+            convertRows(frame, bits + (qsizetype(firstRow) * bytesPerLine), bytesPerLine, firstRow, rowCount, resolvedKernel);
+            finishedSlices.release();
+        };
+        // Never wait for a busy pool, do the work ourself instead.
+        if (!pool->tryStart(convertSlice)) {
+            convertSlice();
+        }
+        ++startedSlices;
+    }
+    // The first slice is always converted on the calling thread.
+    convertRows(frame, bits, bytesPerLine, 0, qMin(rowsPerSlice, frame.height), resolvedKernel);
+    finishedSlices.acquire(startedSlices);
+    return true;
+}
+
+ImagePool::ImagePool(const int capacity) : m_capacity(qMax(1, capacity))
+{
+}
+
+ImagePool::~ImagePool() = default;
+
+QImage ImagePool::acquire(const QSize &size, const QImage::Format format)
+{
+    Q_ASSERT(size.isValid());
+    if (!size.isValid()) {
+        return {};
+    }
+    for (int i = 0; i != m_images.size(); ++i) {
+        const QImage &image = m_images.at(i);
+        if ((image.size() != size) || (image.format() != format)) {
+            // Left over from a previous video, it won't be useful any more.
+            m_images.removeAt(i);
+            --i;
+            continue;
+        }
+        // Someone is still using it (most likely the renderer).
+        if (!image.isDetached()) {
+            continue;
+        }
+        // Take it out of the pool, otherwise writing to it would detach it again.
+        return m_images.takeAt(i);
+    }
+    return QImage(size, format);
+}
+
+void ImagePool::recycle(QImage &&image)
+{
+    if (image.isNull() || (m_images.size() >= m_capacity)) {
+        return;
+    }
+    m_images.append(std::move(image));
+}
+
+void ImagePool::clear()
+{
+    m_images.clear();
+}
+
+} // namespace YUVConverter
+
+QTMEDIAPLAYER_END_NAMESPACE
@@ -0,0 +1,121 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "../loader/qtmediaplayer_global.h"
+#include <QtCore/qlist.h>
+#include <QtGui/qimage.h>
+
+QTMEDIAPLAYER_BEGIN_NAMESPACE
+
+namespace YUVConverter
+{
+
+enum class PixelFormat : int
+{
+    Unknown = 0,
+    NV12, // 8 bit, Y plane + interleaved UV plane.
+    I420, // 8 bit, Y plane + U plane + V plane.
+    P010  // 16 bit little endian (10 significant bits), Y plane + interleaved UV plane.
+};
+
+// How the samples map to RGB. Other matrices (BT.2020) and HDR transfer
+// functions are not handled, such frames need a different converter.
+enum class ColorMatrix : int
+{
+    BT601 = 0,
+    BT709
+};
+
+enum class ColorRange : int
+{
+    Limited = 0, // 16-235 luma, 16-240 chroma ("TV" or "MPEG" range).
+    Full         // 0-255 ("PC" or "JPEG" range).
+};
+
+enum class Kernel : int
+{
+    Auto = 0, // The fastest one the current CPU supports.
+    Scalar,
+    SSE2,
+    AVX2,
+    NEON
+};
+
+// A 4:2:0 frame living in host memory. The converter never takes ownership
+// of the planes, they must stay valid until the conversion returns.
+struct Frame
+{
+    PixelFormat format = PixelFormat::Unknown;
+    int width = 0;
+    int height = 0;
+    const uchar *planes[3] = {};
+    int bytesPerLine[3] = {};
+    ColorMatrix matrix = ColorMatrix::BT601;
+    ColorRange range = ColorRange::Limited;
+};
+
+// All kernels use the same fixed point math and produce bit exact results, so
+// they can be compared against each other freely.
+// The environment variable "QTMEDIAPLAYER_YUV_KERNEL" (scalar, sse2, avx2 or neon)
+// can be used to force a specific kernel when "Kernel::Auto" is requested.
+Q_NODISCARD bool isKernelSupported(const Kernel kernel);
+Q_NODISCARD Kernel bestKernel();
+Q_NODISCARD QString kernelName(const Kernel kernel);
+
+// Converts the rows [firstRow, firstRow + rowCount) of the frame to RGBA8888
+// on the calling thread. "dst" points to the first pixel of the first row.
+void convertRows(const Frame &frame, uchar *dst, const int dstBytesPerLine,
+                 const int firstRow, const int rowCount, const Kernel kernel = Kernel::Auto);
+
+// Converts the whole frame to RGBA8888. Large frames are split into slices
+// which are converted in parallel on the global thread pool. "image" will be
+// (re)allocated if its size or format doesn't match the frame.
+bool convert(const Frame &frame, QImage *image, const Kernel kernel = Kernel::Auto);
+
+// Recycles the images the converter writes to, to avoid allocating a new frame
+// buffer for every video frame. Images given back through recycle() may still
+// be referenced elsewhere, they are only handed out again once nobody else
+// holds a reference to them any more. This class is not thread-safe.
+class ImagePool
+{
+    Q_DISABLE_COPY_MOVE(ImagePool)
+
+public:
+    explicit ImagePool(const int capacity = 3);
+    ~ImagePool();
+
+    Q_NODISCARD QImage acquire(const QSize &size, const QImage::Format format = QImage::Format_RGBA8888);
+    void recycle(QImage &&image);
+    void clear();
+
+private:
+    int m_capacity = 0;
+    QList<QImage> m_images = {};
+};
+
+} // namespace YUVConverter
+
+QTMEDIAPLAYER_END_NAMESPACE
@@ -105,6 +105,11 @@
       qmlRegisterType<className>(QTMEDIAPLAYER_QML_URI, 1, 0, #typeName)
 #endif
 
+#ifndef QTMEDIAPLAYER_QML_SINGLETON_REGISTER
+#  define QTMEDIAPLAYER_QML_SINGLETON_REGISTER(className, typeName) \
+      qmlRegisterSingletonType<className>(QTMEDIAPLAYER_QML_URI, 1, 0, #typeName, &className::qmlInstance)
+#endif
+
 QTMEDIAPLAYER_BEGIN_NAMESPACE
 Q_DECLARE_LOGGING_CATEGORY(lcQMPLoader)
 [[maybe_unused]] static constexpr const int QTMEDIAPLAYER_VERSION_MAJOR = 1;
@@ -0,0 +1,166 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <qtmediaplayer.h>
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qdeadlinetimer.h>
+#include <QtCore/qeventloop.h>
+#include <QtCore/qtimer.h>
+#include <QtCore/qvector.h>
+#include <QtCore/qmath.h>
+#include <QtQuick/qquickitem.h>
+#include <algorithm>
+#include <functional>
+
+#if defined(Q_OS_WINDOWS)
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Shared by the benchmark executables. They need real media and a display, so
+// they are not registered with CTest: run them by hand, see "--help".
+namespace Benchmark
+{
+
+// Same plugin lookup as the demo application. An empty name picks the first
+// backend that works.
+[[nodiscard]] inline bool initializeBackend(const QString &name)
+{
+    QTMEDIAPLAYER_PREPEND_NAMESPACE(addPluginSearchPath)(
+        QCoreApplication::applicationDirPath() + QStringLiteral("/qtmediaplayer"));
+    const QStringList backends = QTMEDIAPLAYER_PREPEND_NAMESPACE(getAvailableBackends)();
+    if (!name.isEmpty()) {
+        return (backends.contains(name, Qt::CaseInsensitive)
+                && QTMEDIAPLAYER_PREPEND_NAMESPACE(initializeBackend)(name));
+    }
+    for (auto &&backend : qAsConst(backends)) {
+        if (QTMEDIAPLAYER_PREPEND_NAMESPACE(initializeBackend)(backend)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// CPU time (user and kernel) of the whole process in nanoseconds, -1 if unknown.
+// The benchmarks run nothing but their players, so that's what the players cost.
+[[nodiscard]] inline qint64 processCpuTime()
+{
+#if defined(Q_OS_WINDOWS)
+    FILETIME creationTime = {}, exitTime = {}, kernelTime = {}, userTime = {};
+    if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+        return -1;
+    }
+    const auto toInt64 = [](const FILETIME &time) -> qint64 {
+        return ((qint64(time.dwHighDateTime) << 32) | qint64(time.dwLowDateTime));
+    };
+    // In units of 100 nanoseconds.
+    return ((toInt64(kernelTime) + toInt64(userTime)) * 100);
+#else
+    rusage usage = {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+    const auto toNanoseconds = [](const timeval &time) -> qint64 {
+        return ((qint64(time.tv_sec) * 1000000000) + (qint64(time.tv_usec) * 1000));
+    };
+    return (toNanoseconds(usage.ru_utime) + toNanoseconds(usage.ru_stime));
+#endif
+}
+
+// The players are created by QML from whichever backend plugin got loaded, so
+// everything about them goes through the meta object system.
+inline void collectPlayers(QQuickItem *item, QList<QQuickItem *> *players)
+{
+    Q_ASSERT(item);
+    Q_ASSERT(players);
+    if (!item || !players) {
+        return;
+    }
+    if (item->metaObject()->indexOfMethod("presentedFrames()") >= 0) {
+        players->append(item);
+    }
+    const QList<QQuickItem *> children = item->childItems();
+    for (auto &&child : qAsConst(children)) {
+        collectPlayers(child, players);
+    }
+}
+
+[[nodiscard]] inline qint64 invokeCounter(QObject *player, const char *method)
+{
+    qint64 value = -1;
+    if (!QMetaObject::invokeMethod(player, method, Qt::DirectConnection, Q_RETURN_ARG(qint64, value))) {
+        return -1;
+    }
+    return value;
+}
+
+[[nodiscard]] inline bool isPlaying(QObject *player)
+{
+    bool value = false;
+    if (!QMetaObject::invokeMethod(player, "isPlaying", Qt::DirectConnection, Q_RETURN_ARG(bool, value))) {
+        return false;
+    }
+    return value;
+}
+
+// Runs the event loop for the given time without spinning, so that the
+// benchmark itself doesn't show up in the CPU time.
+inline void wait(const int duration)
+{
+    QEventLoop loop;
+    QTimer::singleShot(duration, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+[[nodiscard]] inline bool waitFor(const std::function<bool()> &condition, const int timeout)
+{
+    Q_ASSERT(condition);
+    if (!condition) {
+        return false;
+    }
+    const QDeadlineTimer deadline(timeout);
+    while (!condition()) {
+        if (deadline.hasExpired()) {
+            return false;
+        }
+        wait(50);
+    }
+    return true;
+}
+
+// Nearest rank percentile, "fraction" is between 0 and 1.
+[[nodiscard]] inline qreal percentile(QVector<qreal> values, const qreal fraction)
+{
+    if (values.isEmpty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    const int index = qBound(0, qCeil(fraction * qreal(values.size())) - 1, int(values.size()) - 1);
+    return values.at(index);
+}
+
+} // namespace Benchmark
@@ -0,0 +1,210 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QtCore/qcommandlineparser.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qtextstream.h>
+#include <QtCore/qurl.h>
+#include <QtGui/qguiapplication.h>
+#include <QtQml/qqmlapplicationengine.h>
+#include <QtQuick/qquickwindow.h>
+#include "../common/benchmarkutils.h"
+
+// Plays the media in one small muted player once per decode quality tier and
+// reports the CPU cores the process used and the frames presented per second.
+// A run without any media first gives the baseline (the event loop and the
+// scene graph), which is subtracted to get the cost of the decoding itself.
+
+static constexpr const int kDefaultDuration = 15; // seconds
+static constexpr const int kDefaultWarmup = 3; // seconds
+static constexpr const int kStartTimeout = 30000; // milliseconds
+static constexpr const char kDefaultSize[] = "160x90";
+
+static constexpr const char kScene[] = R"(
+import QtQuick 2.15
+import QtQuick.Window 2.15
+import org.wangwenx190.QtMediaPlayer 1.0
+
+Window {
+    width: %1
+    height: %2
+    visible: true
+    title: "bench_decodequality"
+
+    MediaPlayer {
+        anchors.fill: parent
+        mute: true
+        hardwareDecoding: %3
+        decodeQuality: %4
+    }
+}
+)";
+
+struct Tier
+{
+    const char *name = nullptr;
+    int value = -1; // DecodeQuality, -1 for the baseline without media.
+};
+
+static constexpr const Tier kTiers[] = {
+    {"baseline", -1},
+    {"full", 0},
+    {"fast", 1},
+    {"preview", 2}
+};
+
+struct Result
+{
+    bool valid = false;
+    qreal cores = 0.0;
+    qreal fps = 0.0;
+    QSizeF videoSize = {};
+};
+
+[[nodiscard]] static inline Result measure(const QString &scene, const QUrl &url, const int warmup, const int duration, QTextStream &out)
+{
+    QQmlApplicationEngine engine;
+    engine.loadData(scene.toUtf8());
+    if (engine.rootObjects().isEmpty()) {
+        return {};
+    }
+    const auto window = qobject_cast<QQuickWindow *>(engine.rootObjects().constFirst());
+    if (!window) {
+        return {};
+    }
+    QList<QQuickItem *> players = {};
+    Benchmark::collectPlayers(window->contentItem(), &players);
+    if (players.size() != 1) {
+        return {};
+    }
+    QQuickItem * const player = players.constFirst();
+
+    if (url.isValid()) {
+        QMetaObject::invokeMethod(player, "play", Q_ARG(QUrl, url));
+        if (!Benchmark::waitFor([player](){ return Benchmark::isPlaying(player); }, kStartTimeout)) {
+            out << "The player didn't start playing within " << (kStartTimeout / 1000) << " seconds." << Qt::endl;
+            return {};
+        }
+    }
+    Benchmark::wait(warmup * 1000);
+
+    QElapsedTimer clock;
+    clock.start();
+    const qint64 presentedBefore = Benchmark::invokeCounter(player, "presentedFrames");
+    const qint64 cpuBefore = Benchmark::processCpuTime();
+
+    Benchmark::wait(duration * 1000);
+
+    const qint64 cpuAfter = Benchmark::processCpuTime();
+    const qint64 presentedAfter = Benchmark::invokeCounter(player, "presentedFrames");
+    const qint64 elapsed = clock.nsecsElapsed();
+
+    if ((cpuBefore < 0) || (cpuAfter < 0)) {
+        out << "The CPU time of the process is unknown on this platform." << Qt::endl;
+        return {};
+    }
+    if (url.isValid() && !Benchmark::isPlaying(player)) {
+        out << "The player stopped early, use longer media." << Qt::endl;
+        return {};
+    }
+    Result result = {};
+    result.valid = true;
+    result.cores = (qreal(cpuAfter - cpuBefore) / qreal(elapsed));
+    if ((presentedBefore >= 0) && (presentedAfter >= 0)) {
+        result.fps = (qreal(presentedAfter - presentedBefore) / (qreal(elapsed) / 1000000000.0));
+    }
+    result.videoSize = player->property("videoSize").toSizeF();
+    QMetaObject::invokeMethod(player, "stop");
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication application(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral(
+        "CPU cost of each decode quality tier, for example of a 4K HEVC preview. "
+        "The media should be longer than the warm up plus the duration."));
+    parser.addHelpOption();
+    parser.addPositionalArgument(QStringLiteral("media"), QStringLiteral("The file or URL to play."));
+    const QCommandLineOption sizeOption(QStringLiteral("size"),
+        QStringLiteral("Size of the player."), QStringLiteral("WxH"), QString::fromUtf8(kDefaultSize));
+    const QCommandLineOption durationOption(QStringLiteral("duration"),
+        QStringLiteral("Seconds to measure per tier."), QStringLiteral("seconds"), QString::number(kDefaultDuration));
+    const QCommandLineOption warmupOption(QStringLiteral("warmup"),
+        QStringLiteral("Seconds to play before measuring."), QStringLiteral("seconds"), QString::number(kDefaultWarmup));
+    const QCommandLineOption backendOption(QStringLiteral("backend"),
+        QStringLiteral("Player backend, the first available one by default."), QStringLiteral("name"));
+    const QCommandLineOption hwdecOption(QStringLiteral("hwdec"),
+        QStringLiteral("Allow hardware decoding, which hides most of the decoding cost from the process."));
+    parser.addOptions({sizeOption, durationOption, warmupOption, backendOption, hwdecOption});
+    parser.process(application);
+
+    QTextStream out(stdout);
+
+    const QStringList positional = parser.positionalArguments();
+    if (positional.size() != 1) {
+        parser.showHelp(1);
+    }
+    const QUrl url = QUrl::fromUserInput(positional.constFirst(), QDir::currentPath());
+    const QStringList size = parser.value(sizeOption).split(u'x');
+    const int width = ((size.size() == 2) ? qMax(1, size.at(0).toInt()) : 160);
+    const int height = ((size.size() == 2) ? qMax(1, size.at(1).toInt()) : 90);
+    const int duration = qMax(1, parser.value(durationOption).toInt());
+    const int warmup = qMax(0, parser.value(warmupOption).toInt());
+    const bool hwdec = parser.isSet(hwdecOption);
+
+    if (!Benchmark::initializeBackend(parser.value(backendOption))) {
+        out << "No player backend could be initialized." << Qt::endl;
+        return 1;
+    }
+
+    out << "player size: " << width << 'x' << height << (hwdec ? ", hardware decoding" : ", software decoding") << Qt::endl;
+    qreal baseline = 0.0;
+    for (auto &&tier : kTiers) {
+        const bool isBaseline = (tier.value < 0);
+        const QString scene = QString::fromUtf8(kScene).arg(QString::number(width), QString::number(height),
+            (hwdec ? QStringLiteral("true") : QStringLiteral("false")), QString::number(qMax(0, tier.value)));
+        const Result result = measure(scene, (isBaseline ? QUrl() : url), warmup, duration, out);
+        if (!result.valid) {
+            out << tier.name << ": failed" << Qt::endl;
+            return 1;
+        }
+        if (isBaseline) {
+            baseline = result.cores;
+            out << tier.name << ": " << result.cores << " cores" << Qt::endl;
+            continue;
+        }
+        out << tier.name << ": " << result.cores << " cores, " << (result.cores - baseline)
+            << " cores over the baseline, " << result.fps << " fps";
+        if (!result.videoSize.isEmpty()) {
+            out << ", " << result.videoSize.width() << 'x' << result.videoSize.height() << " video";
+        }
+        out << Qt::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,245 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QtCore/qcommandlineparser.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qtextstream.h>
+#include <QtCore/qurl.h>
+#include <QtGui/qguiapplication.h>
+#include <QtQml/qqmlapplicationengine.h>
+#include <QtQuick/qquickwindow.h>
+#include "../common/benchmarkutils.h"
+#include <atomic>
+
+// Plays the same media in N muted players laid out in one window and reports
+// the frames presented per second, in total and per player, the frames the
+// backends dropped and the intervals between the frames the window presented.
+// The tail of those intervals is what a user sees as stutter.
+
+static constexpr const int kDefaultPlayerCount = 16;
+static constexpr const int kDefaultDuration = 20; // seconds
+static constexpr const int kDefaultWarmup = 3; // seconds
+static constexpr const int kStartTimeout = 30000; // milliseconds
+static constexpr const int kTileWidth = 320;
+static constexpr const int kTileHeight = 180;
+
+static constexpr const char kScene[] = R"(
+import QtQuick 2.15
+import QtQuick.Window 2.15
+import org.wangwenx190.QtMediaPlayer 1.0
+
+Window {
+    width: grid.width
+    height: grid.height
+    visible: true
+    title: "bench_multiplayer"
+    Component.onCompleted: ResourceGovernor.enabled = %5
+
+    Grid {
+        id: grid
+        columns: %2
+
+        Repeater {
+            model: %1
+
+            MediaPlayer {
+                width: %3
+                height: %4
+                mute: true
+            }
+        }
+    }
+}
+)";
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication application(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral(
+        "Aggregate frame rate and frame time tail latency with many players. "
+        "The media should be longer than the warm up plus the duration."));
+    parser.addHelpOption();
+    parser.addPositionalArgument(QStringLiteral("media"), QStringLiteral("The file or URL every player plays."));
+    const QCommandLineOption playersOption(QStringLiteral("players"),
+        QStringLiteral("Number of players."), QStringLiteral("count"), QString::number(kDefaultPlayerCount));
+    const QCommandLineOption durationOption(QStringLiteral("duration"),
+        QStringLiteral("Seconds to measure."), QStringLiteral("seconds"), QString::number(kDefaultDuration));
+    const QCommandLineOption warmupOption(QStringLiteral("warmup"),
+        QStringLiteral("Seconds to play before measuring."), QStringLiteral("seconds"), QString::number(kDefaultWarmup));
+    const QCommandLineOption backendOption(QStringLiteral("backend"),
+        QStringLiteral("Player backend, the first available one by default."), QStringLiteral("name"));
+    const QCommandLineOption governorOption(QStringLiteral("governor"),
+        QStringLiteral("Share threads and memory through the resource governor."));
+    parser.addOptions({playersOption, durationOption, warmupOption, backendOption, governorOption});
+    parser.process(application);
+
+    QTextStream out(stdout);
+
+    const QStringList positional = parser.positionalArguments();
+    if (positional.size() != 1) {
+        parser.showHelp(1);
+    }
+    const QUrl url = QUrl::fromUserInput(positional.constFirst(), QDir::currentPath());
+    const int playerCount = qMax(1, parser.value(playersOption).toInt());
+    const int duration = qMax(1, parser.value(durationOption).toInt());
+    const int warmup = qMax(0, parser.value(warmupOption).toInt());
+    const bool governor = parser.isSet(governorOption);
+
+    if (!Benchmark::initializeBackend(parser.value(backendOption))) {
+        out << "No player backend could be initialized." << Qt::endl;
+        return 1;
+    }
+
+    // Roughly square, like a wall of previews.
+    int columns = 1;
+    while ((columns * columns) < playerCount) {
+        ++columns;
+    }
+    const QString scene = QString::fromUtf8(kScene).arg(QString::number(playerCount), QString::number(columns),
+        QString::number(kTileWidth), QString::number(kTileHeight),
+        (governor ? QStringLiteral("true") : QStringLiteral("false")));
+
+    QQmlApplicationEngine engine;
+    engine.loadData(scene.toUtf8());
+    if (engine.rootObjects().isEmpty()) {
+        return 1;
+    }
+    const auto window = qobject_cast<QQuickWindow *>(engine.rootObjects().constFirst());
+    if (!window) {
+        return 1;
+    }
+
+    QList<QQuickItem *> players = {};
+    Benchmark::collectPlayers(window->contentItem(), &players);
+    if (players.size() != playerCount) {
+        out << "Expected " << playerCount << " players, found " << players.size() << '.' << Qt::endl;
+        return 1;
+    }
+
+    // The scene graph may render on its own thread, so the swaps are recorded
+    // directly from there.
+    QElapsedTimer clock;
+    clock.start();
+    QMutex swapMutex;
+    QVector<qint64> swaps = {};
+    std::atomic_bool recording{false};
+    QObject::connect(window, &QQuickWindow::frameSwapped, window, [&clock, &swapMutex, &swaps, &recording](){
+        if (!recording) {
+            return;
+        }
+        const QMutexLocker locker(&swapMutex);
+        swaps.append(clock.nsecsElapsed());
+    }, Qt::DirectConnection);
+
+    for (auto &&player : qAsConst(players)) {
+        QMetaObject::invokeMethod(player, "play", Q_ARG(QUrl, url));
+    }
+    const bool started = Benchmark::waitFor([&players](){
+        for (auto &&player : qAsConst(players)) {
+            if (!Benchmark::isPlaying(player)) {
+                return false;
+            }
+        }
+        return true;
+    }, kStartTimeout);
+    if (!started) {
+        out << "Not all players started playing within " << (kStartTimeout / 1000) << " seconds." << Qt::endl;
+        return 1;
+    }
+    Benchmark::wait(warmup * 1000);
+
+    const auto snapshot = [&players](const char *method) -> QVector<qint64> {
+        QVector<qint64> result = {};
+        result.reserve(players.size());
+        for (auto &&player : qAsConst(players)) {
+            result.append(Benchmark::invokeCounter(player, method));
+        }
+        return result;
+    };
+    const QVector<qint64> presentedBefore = snapshot("presentedFrames");
+    const QVector<qint64> droppedBefore = snapshot("droppedFrames");
+    const qint64 cpuBefore = Benchmark::processCpuTime();
+    const qint64 wallBefore = clock.nsecsElapsed();
+    recording = true;
+
+    Benchmark::wait(duration * 1000);
+
+    recording = false;
+    const qint64 wallAfter = clock.nsecsElapsed();
+    const qint64 cpuAfter = Benchmark::processCpuTime();
+    const QVector<qint64> presentedAfter = snapshot("presentedFrames");
+    const QVector<qint64> droppedAfter = snapshot("droppedFrames");
+
+    const qreal seconds = (qreal(wallAfter - wallBefore) / 1000000000.0);
+    QVector<qreal> playerFps = {};
+    qint64 presented = 0;
+    qint64 dropped = 0;
+    int stopped = 0;
+    for (int index = 0; index != players.size(); ++index) {
+        if ((presentedBefore.at(index) < 0) || (presentedAfter.at(index) < 0)) {
+            out << "The backend doesn't count presented frames." << Qt::endl;
+            return 1;
+        }
+        const qint64 frames = (presentedAfter.at(index) - presentedBefore.at(index));
+        presented += frames;
+        playerFps.append(qreal(frames) / seconds);
+        if ((droppedBefore.at(index) >= 0) && (droppedAfter.at(index) >= 0)) {
+            dropped += (droppedAfter.at(index) - droppedBefore.at(index));
+        }
+        if (!Benchmark::isPlaying(players.at(index))) {
+            ++stopped;
+        }
+    }
+
+    QVector<qreal> intervals = {};
+    {
+        const QMutexLocker locker(&swapMutex);
+        for (int index = 1; index < swaps.size(); ++index) {
+            intervals.append(qreal(swaps.at(index) - swaps.at(index - 1)) / 1000000.0);
+        }
+    }
+
+    out << "players:              " << playerCount << (governor ? " (governed)" : "") << Qt::endl;
+    out << "measured:             " << seconds << " s" << Qt::endl;
+    out << "aggregate fps:        " << (qreal(presented) / seconds) << Qt::endl;
+    out << "player fps:           min " << Benchmark::percentile(playerFps, 0.0)
+        << ", median " << Benchmark::percentile(playerFps, 0.5)
+        << ", max " << Benchmark::percentile(playerFps, 1.0) << Qt::endl;
+    out << "dropped frames:       " << dropped << Qt::endl;
+    out << "window frame time ms: p50 " << Benchmark::percentile(intervals, 0.5)
+        << ", p99 " << Benchmark::percentile(intervals, 0.99)
+        << ", max " << Benchmark::percentile(intervals, 1.0) << Qt::endl;
+    if ((cpuBefore >= 0) && (cpuAfter >= 0)) {
+        out << "cpu cores:            " << (qreal(cpuAfter - cpuBefore) / qreal(wallAfter - wallBefore)) << Qt::endl;
+    }
+    if (stopped > 0) {
+        out << "warning: " << stopped << " players stopped early, use longer media." << Qt::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,369 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QtCore/qcommandlineparser.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qtextstream.h>
+#include <QtCore/qurl.h>
+#include <QtGui/qguiapplication.h>
+#include <QtNetwork/qtcpserver.h>
+#include <QtNetwork/qtcpsocket.h>
+#include <QtQml/qqmlapplicationengine.h>
+#include <QtQuick/qquickwindow.h>
+#include "../common/benchmarkutils.h"
+
+// Switches a StreamSwitcher through the given media and reports how long each
+// switch took until the shown player presented a new frame, separately for the
+// switches a standby player was ready for and for the cold ones. It also counts
+// the frames the standby players presented: nothing is rendered for them, so with
+// MDK that stays at zero, mpv counts the frames it skipped while playing as well.
+// With "--http" the media are served from a throttled local HTTP server, which
+// stands in for network streams.
+
+static constexpr const int kDefaultSwitches = 20;
+static constexpr const int kDefaultInterval = 2000; // milliseconds
+static constexpr const int kDefaultStandbyCount = 2;
+static constexpr const int kDefaultRate = 1024; // KiB per second
+static constexpr const int kStartTimeout = 30000; // milliseconds
+static constexpr const int kSwitchTimeout = 10000; // milliseconds
+static constexpr const int kServerTick = 10; // milliseconds
+static constexpr const qint64 kMaximumPendingBytes = 64 * 1024;
+
+static constexpr const char kScene[] = R"(
+import QtQuick 2.15
+import QtQuick.Window 2.15
+import org.wangwenx190.QtMediaPlayer 1.0
+
+Window {
+    width: 640
+    height: 360
+    visible: true
+    title: "bench_streamswitcher"
+
+    StreamSwitcher {
+        anchors.fill: parent
+        standbyCount: %1
+        standbyPlaying: %2
+    }
+}
+)";
+
+// Serves "/<index>/<file name>" with Range support, at most "rate" bytes per
+// second for every connection. Just enough HTTP for the backends' demuxers.
+class ThrottledServer
+{
+public:
+    explicit ThrottledServer(const QStringList &files, const qint64 rate) : m_files(files), m_rate(rate)
+    {
+        QObject::connect(&m_server, &QTcpServer::newConnection, &m_server, [this](){
+            while (QTcpSocket *socket = m_server.nextPendingConnection()) {
+                serve(socket);
+            }
+        });
+    }
+
+    [[nodiscard]] bool listen()
+    {
+        return m_server.listen(QHostAddress::LocalHost);
+    }
+
+    [[nodiscard]] QUrl url(const int index) const
+    {
+        return QUrl(QStringLiteral("http://127.0.0.1:%1/%2/%3").arg(QString::number(m_server.serverPort()),
+            QString::number(index), QFileInfo(m_files.at(index)).fileName()));
+    }
+
+private:
+    void serve(QTcpSocket *socket)
+    {
+        QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        QObject::connect(socket, &QTcpSocket::readyRead, socket, [this, socket](){
+            // Keep-alive isn't supported, one request per connection.
+            if (socket->property("file").isValid() || !socket->canReadLine()) {
+                return;
+            }
+            const QList<QByteArray> requestLine = socket->readLine().trimmed().split(' ');
+            qint64 first = 0;
+            qint64 last = -1;
+            bool ranged = false;
+            while (socket->canReadLine()) {
+                const QByteArray header = socket->readLine().trimmed();
+                if (header.isEmpty()) {
+                    break;
+                }
+                if (header.toLower().startsWith("range: bytes=")) {
+                    const QList<QByteArray> bounds = header.mid(13).split('-');
+                    first = bounds.constFirst().toLongLong();
+                    last = ((bounds.size() > 1) && !bounds.at(1).isEmpty()) ? bounds.at(1).toLongLong() : -1;
+                    ranged = true;
+                }
+            }
+            const QList<QByteArray> path = (requestLine.size() >= 2) ? requestLine.at(1).split('/') : QList<QByteArray>{};
+            bool ok = false;
+            const int index = (path.size() >= 2) ? path.at(1).toInt(&ok) : -1;
+            const auto file = new QFile(socket);
+            if (ok && (index >= 0) && (index < m_files.size())) {
+                file->setFileName(m_files.at(index));
+            }
+            if ((requestLine.constFirst() != "GET") || !file->open(QFile::ReadOnly)) {
+                socket->write("HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+                socket->disconnectFromHost();
+                return;
+            }
+            const qint64 size = file->size();
+            last = ((last < 0) || (last >= size)) ? (size - 1) : last;
+            if (ranged && (first >= size)) {
+                socket->write("HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */"
+                    + QByteArray::number(size) + "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+                socket->disconnectFromHost();
+                return;
+            }
+            file->seek(first);
+            QByteArray response = ranged ? "HTTP/1.1 206 Partial Content\r\n" : "HTTP/1.1 200 OK\r\n";
+            if (ranged) {
+                response += "Content-Range: bytes " + QByteArray::number(first) + '-'
+                    + QByteArray::number(last) + '/' + QByteArray::number(size) + "\r\n";
+            }
+            response += "Content-Length: " + QByteArray::number(last - first + 1) + "\r\n"
+                "Accept-Ranges: bytes\r\nConnection: close\r\n\r\n";
+            socket->write(response);
+            socket->setProperty("file", true);
+            socket->setProperty("remaining", last - first + 1);
+
+            const auto timer = new QTimer(socket);
+            timer->setInterval(kServerTick);
+            QObject::connect(timer, &QTimer::timeout, socket, [this, socket, file, timer](){
+                if (socket->bytesToWrite() > kMaximumPendingBytes) {
+                    return;
+                }
+                const qint64 remaining = socket->property("remaining").toLongLong();
+                const QByteArray data = file->read(qMin(remaining, qMax(qint64(1), (m_rate * kServerTick) / 1000)));
+                if (data.isEmpty()) {
+                    timer->stop();
+                    socket->disconnectFromHost();
+                    return;
+                }
+                socket->write(data);
+                socket->setProperty("remaining", remaining - data.size());
+            });
+            timer->start();
+        });
+    }
+
+    QTcpServer m_server;
+    QStringList m_files = {};
+    qint64 m_rate = 0;
+};
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication application(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral(
+        "Switch latency of the StreamSwitcher, with and without a standby player. "
+        "Each switch goes to the next media, the ones after it are the candidates."));
+    parser.addHelpOption();
+    parser.addPositionalArgument(QStringLiteral("media"), QStringLiteral("Two or more local files, or URLs without \"--http\"."));
+    const QCommandLineOption switchesOption(QStringLiteral("switches"),
+        QStringLiteral("Number of switches."), QStringLiteral("count"), QString::number(kDefaultSwitches));
+    const QCommandLineOption intervalOption(QStringLiteral("interval"),
+        QStringLiteral("Milliseconds to stay on each media."), QStringLiteral("ms"), QString::number(kDefaultInterval));
+    const QCommandLineOption standbyOption(QStringLiteral("standby"),
+        QStringLiteral("Number of standby players, zero to only measure cold switches."),
+        QStringLiteral("count"), QString::number(kDefaultStandbyCount));
+    const QCommandLineOption standbyPlayingOption(QStringLiteral("standby-playing"),
+        QStringLiteral("Keep the standby players playing instead of paused."));
+    const QCommandLineOption httpOption(QStringLiteral("http"),
+        QStringLiteral("Serve the files from a throttled local HTTP server."));
+    const QCommandLineOption rateOption(QStringLiteral("rate"),
+        QStringLiteral("Bandwidth of every HTTP connection."), QStringLiteral("KiB/s"), QString::number(kDefaultRate));
+    const QCommandLineOption backendOption(QStringLiteral("backend"),
+        QStringLiteral("Player backend, the first available one by default."), QStringLiteral("name"));
+    parser.addOptions({switchesOption, intervalOption, standbyOption, standbyPlayingOption, httpOption, rateOption, backendOption});
+    parser.process(application);
+
+    QTextStream out(stdout);
+
+    const QStringList positional = parser.positionalArguments();
+    if (positional.size() < 2) {
+        parser.showHelp(1);
+    }
+    const int switches = qMax(1, parser.value(switchesOption).toInt());
+    const int interval = qMax(0, parser.value(intervalOption).toInt());
+    const int standbyCount = qMax(0, parser.value(standbyOption).toInt());
+    const bool standbyPlaying = parser.isSet(standbyPlayingOption);
+    const bool http = parser.isSet(httpOption);
+
+    QStringList files = {};
+    for (auto &&argument : qAsConst(positional)) {
+        files.append(QFileInfo(argument).absoluteFilePath());
+    }
+    ThrottledServer server(files, qint64(qMax(1, parser.value(rateOption).toInt())) * 1024);
+    if (http && !server.listen()) {
+        out << "The local HTTP server could not be started." << Qt::endl;
+        return 1;
+    }
+    QList<QUrl> sources = {};
+    for (int index = 0; index != positional.size(); ++index) {
+        sources.append(http ? server.url(index) : QUrl::fromUserInput(positional.at(index), QDir::currentPath()));
+    }
+
+    if (!Benchmark::initializeBackend(parser.value(backendOption))) {
+        out << "No player backend could be initialized." << Qt::endl;
+        return 1;
+    }
+
+    const QString scene = QString::fromUtf8(kScene).arg(QString::number(standbyCount),
+        (standbyPlaying ? QStringLiteral("true") : QStringLiteral("false")));
+
+    QQmlApplicationEngine engine;
+    engine.loadData(scene.toUtf8());
+    if (engine.rootObjects().isEmpty()) {
+        return 1;
+    }
+    const auto window = qobject_cast<QQuickWindow *>(engine.rootObjects().constFirst());
+    if (!window) {
+        return 1;
+    }
+    const QList<QQuickItem *> children = window->contentItem()->childItems();
+    QQuickItem *switcher = nullptr;
+    for (auto &&child : qAsConst(children)) {
+        if (child->metaObject()->indexOfProperty("standbySources") >= 0) {
+            switcher = child;
+            break;
+        }
+    }
+    if (!switcher) {
+        out << "The backend doesn't provide a StreamSwitcher." << Qt::endl;
+        return 1;
+    }
+
+    const auto activePlayer = [switcher]() -> QObject * {
+        return switcher->property("player").value<QObject *>();
+    };
+    // The ones to prepare after showing "current", in the order they come up.
+    const auto candidatesAfter = [&sources](const int current) -> QList<QUrl> {
+        QList<QUrl> result = {};
+        for (int offset = 1; offset < sources.size(); ++offset) {
+            result.append(sources.at((current + offset) % sources.size()));
+        }
+        return result;
+    };
+    const auto standbyFrames = [switcher, &activePlayer]() -> qint64 {
+        QList<QQuickItem *> players = {};
+        Benchmark::collectPlayers(switcher, &players);
+        const QObject *active = activePlayer();
+        qint64 result = 0;
+        for (auto &&player : qAsConst(players)) {
+            if (player != active) {
+                result += qMax(qint64(0), Benchmark::invokeCounter(player, "presentedFrames"));
+            }
+        }
+        return result;
+    };
+
+    // Checked whenever the window presented something, on the GUI thread.
+    QElapsedTimer clock;
+    QObject *watched = nullptr;
+    qint64 watchedFrames = -1;
+    qint64 firstFrameTime = -1;
+    QObject::connect(window, &QQuickWindow::frameSwapped, &application, [&](){
+        if (!watched || (firstFrameTime >= 0)) {
+            return;
+        }
+        if (Benchmark::invokeCounter(watched, "presentedFrames") > watchedFrames) {
+            firstFrameTime = clock.nsecsElapsed();
+        }
+    }, Qt::QueuedConnection);
+
+    switcher->setProperty("candidates", QVariant::fromValue(candidatesAfter(0)));
+    switcher->setProperty("source", sources.constFirst());
+    const bool started = Benchmark::waitFor([&activePlayer](){
+        QObject *player = activePlayer();
+        return (player && Benchmark::isPlaying(player));
+    }, kStartTimeout);
+    if (!started) {
+        out << "The first media didn't start playing within " << (kStartTimeout / 1000) << " seconds." << Qt::endl;
+        return 1;
+    }
+    Benchmark::wait(interval);
+
+    QVector<qreal> warmLatencies = {};
+    QVector<qreal> coldLatencies = {};
+    int timeouts = 0;
+    qint64 presentedOnStandby = 0;
+    int current = 0;
+    for (int index = 0; index != switches; ++index) {
+        current = ((current + 1) % sources.size());
+        const QUrl target = sources.at(current);
+        const bool warm = switcher->property("standbySources").value<QList<QUrl>>().contains(target);
+
+        watched = nullptr;
+        firstFrameTime = -1;
+        clock.start();
+        switcher->setProperty("source", target);
+        watched = activePlayer();
+        watchedFrames = (watched ? Benchmark::invokeCounter(watched, "presentedFrames") : -1);
+        if (watchedFrames < 0) {
+            out << "The backend doesn't count presented frames." << Qt::endl;
+            return 1;
+        }
+        if (Benchmark::waitFor([&firstFrameTime](){ return (firstFrameTime >= 0); }, kSwitchTimeout)) {
+            (warm ? warmLatencies : coldLatencies).append(qreal(firstFrameTime) / 1000000.0);
+        } else {
+            ++timeouts;
+        }
+        watched = nullptr;
+
+        switcher->setProperty("candidates", QVariant::fromValue(candidatesAfter(current)));
+        const qint64 standbyBefore = standbyFrames();
+        Benchmark::wait(interval);
+        presentedOnStandby += qMax(qint64(0), standbyFrames() - standbyBefore);
+    }
+
+    const auto report = [&out](const char *name, const QVector<qreal> &latencies){
+        out << name << latencies.size() << " switches";
+        if (!latencies.isEmpty()) {
+            out << ", ms p50 " << Benchmark::percentile(latencies, 0.5)
+                << ", p90 " << Benchmark::percentile(latencies, 0.9)
+                << ", max " << Benchmark::percentile(latencies, 1.0);
+        }
+        out << Qt::endl;
+    };
+    out << "media:                " << sources.size() << (http ? " (throttled HTTP)" : "") << Qt::endl;
+    out << "standby players:      " << standbyCount << (standbyPlaying ? " (playing)" : " (paused)") << Qt::endl;
+    report("from standby:         ", warmLatencies);
+    report("cold:                 ", coldLatencies);
+    out << "presented on standby: " << presentedOnStandby << " frames" << Qt::endl;
+    if (timeouts > 0) {
+        out << "warning: " << timeouts << " switches showed no frame within "
+            << (kSwitchTimeout / 1000) << " seconds." << Qt::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,378 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2022 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "../../src/common/yuvconverter.h"
+#include <QtCore/qrandom.h>
+#include <QtTest/qtest.h>
+#include <cmath>
+#include <vector>
+
+QTMEDIAPLAYER_USE_NAMESPACE
+
+using YUVConverter::ColorMatrix;
+using YUVConverter::ColorRange;
+using YUVConverter::Frame;
+using YUVConverter::Kernel;
+using YUVConverter::PixelFormat;
+
+Q_DECLARE_METATYPE(QTMEDIAPLAYER_PREPEND_NAMESPACE(YUVConverter::ColorMatrix))
+Q_DECLARE_METATYPE(QTMEDIAPLAYER_PREPEND_NAMESPACE(YUVConverter::ColorRange))
+Q_DECLARE_METATYPE(QTMEDIAPLAYER_PREPEND_NAMESPACE(YUVConverter::Kernel))
+Q_DECLARE_METATYPE(QTMEDIAPLAYER_PREPEND_NAMESPACE(YUVConverter::PixelFormat))
+
+// Planes of a 4:2:0 frame owned by the test, with padded rows so that reads
+// past the end of a row would show up as wrong pixels.
+struct TestFrame
+{
+    std::vector<uchar> planes[3] = {};
+    Frame layout = {}; // Without the plane pointers, they follow the copies.
+
+    [[nodiscard]] Frame frame() const
+    {
+        Frame result = layout;
+        for (int i = 0; i != 3; ++i) {
+            result.planes[i] = (planes[i].empty() ? nullptr : planes[i].data());
+        }
+        return result;
+    }
+};
+
+static constexpr const int kRowPadding = 32;
+
+[[nodiscard]] static inline TestFrame createI420(const int width, const int height)
+{
+    TestFrame result = {};
+    const int chromaWidth = (width + 1) / 2;
+    const int chromaHeight = (height + 1) / 2;
+    result.layout.format = PixelFormat::I420;
+    result.layout.width = width;
+    result.layout.height = height;
+    result.layout.bytesPerLine[0] = width + kRowPadding;
+    result.layout.bytesPerLine[1] = chromaWidth + kRowPadding;
+    result.layout.bytesPerLine[2] = chromaWidth + kRowPadding;
+    result.planes[0].resize(size_t(result.layout.bytesPerLine[0]) * height);
+    result.planes[1].resize(size_t(result.layout.bytesPerLine[1]) * chromaHeight);
+    result.planes[2].resize(size_t(result.layout.bytesPerLine[2]) * chromaHeight);
+    return result;
+}
+
+[[nodiscard]] static inline TestFrame createRandomI420(const int width, const int height, QRandomGenerator *random)
+{
+    TestFrame result = createI420(width, height);
+    for (auto &&plane : result.planes) {
+        for (auto &&sample : plane) {
+            sample = uchar(random->bounded(256));
+        }
+    }
+    return result;
+}
+
+// The same samples, with U and V interleaved.
+[[nodiscard]] static inline TestFrame toNV12(const TestFrame &source)
+{
+    const Frame &frame = source.layout;
+    const int chromaWidth = (frame.width + 1) / 2;
+    const int chromaHeight = (frame.height + 1) / 2;
+    TestFrame result = {};
+    result.layout = frame;
+    result.layout.format = PixelFormat::NV12;
+    result.layout.bytesPerLine[1] = (chromaWidth * 2) + kRowPadding;
+    result.layout.bytesPerLine[2] = 0;
+    result.planes[0] = source.planes[0];
+    result.planes[1].resize(size_t(result.layout.bytesPerLine[1]) * chromaHeight);
+    for (int row = 0; row != chromaHeight; ++row) {
+        for (int x = 0; x != chromaWidth; ++x) {
+            uchar *pair = result.planes[1].data() + (row * result.layout.bytesPerLine[1]) + (x * 2);
+            pair[0] = source.planes[1].at((row * frame.bytesPerLine[1]) + x);
+            pair[1] = source.planes[2].at((row * frame.bytesPerLine[2]) + x);
+        }
+    }
+    return result;
+}
+
+// The same samples as the high byte of 16 bit little endian ones, the low
+// byte is noise the converter has to ignore.
+[[nodiscard]] static inline TestFrame toP010(const TestFrame &source, QRandomGenerator *random)
+{
+    const TestFrame nv12 = toNV12(source);
+    TestFrame result = {};
+    result.layout = nv12.layout;
+    result.layout.format = PixelFormat::P010;
+    for (int i = 0; i != 2; ++i) {
+        result.layout.bytesPerLine[i] = nv12.layout.bytesPerLine[i] * 2;
+        result.planes[i].resize(nv12.planes[i].size() * 2);
+        for (size_t sample = 0; sample != nv12.planes[i].size(); ++sample) {
+            result.planes[i][(sample * 2)] = uchar(random->bounded(256));
+            result.planes[i][(sample * 2) + 1] = nv12.planes[i][sample];
+        }
+    }
+    return result;
+}
+
+[[nodiscard]] static inline QImage convertWith(const Frame &frame, const Kernel kernel)
+{
+    QImage image(frame.width, frame.height, QImage::Format_RGBA8888);
+    image.fill(Qt::transparent);
+    YUVConverter::convertRows(frame, image.bits(), image.bytesPerLine(), 0, frame.height, kernel);
+    return image;
+}
+
+[[nodiscard]] static inline QList<Kernel> supportedKernels()
+{
+    QList<Kernel> result = {};
+    for (auto &&kernel : {Kernel::Scalar, Kernel::SSE2, Kernel::AVX2, Kernel::NEON}) {
+        if (YUVConverter::isKernelSupported(kernel)) {
+            result.append(kernel);
+        }
+    }
+    return result;
+}
+
+class tst_YUVConverter : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void scalarMatchesReference_data();
+    void scalarMatchesReference();
+    void kernelsAreBitExact_data();
+    void kernelsAreBitExact();
+    void oddSizes_data();
+    void oddSizes();
+    void slicedConversion();
+    void benchmarkKernel_data();
+    void benchmarkKernel();
+    void benchmarkSlicedConversion();
+};
+
+// Every Y, U and V combination: one frame per V value, the luma is the column,
+// U the chroma row.
+static constexpr const int kExhaustiveWidth = 256;
+static constexpr const int kExhaustiveHeight = 512;
+
+[[nodiscard]] static inline TestFrame createExhaustiveI420(const int v, const ColorMatrix matrix = ColorMatrix::BT601,
+                                                           const ColorRange range = ColorRange::Limited)
+{
+    TestFrame result = createI420(kExhaustiveWidth, kExhaustiveHeight);
+    result.layout.matrix = matrix;
+    result.layout.range = range;
+    const Frame &frame = result.layout;
+    for (int row = 0; row != frame.height; ++row) {
+        for (int x = 0; x != frame.width; ++x) {
+            result.planes[0][(row * frame.bytesPerLine[0]) + x] = uchar(x);
+        }
+    }
+    for (int row = 0; row != (frame.height / 2); ++row) {
+        for (int x = 0; x != (frame.width / 2); ++x) {
+            result.planes[1][(row * frame.bytesPerLine[1]) + x] = uchar(row);
+            result.planes[2][(row * frame.bytesPerLine[2]) + x] = uchar(v);
+        }
+    }
+    return result;
+}
+
+void tst_YUVConverter::scalarMatchesReference_data()
+{
+    QTest::addColumn<ColorMatrix>("matrix");
+    QTest::addColumn<ColorRange>("range");
+    QTest::newRow("BT.601 limited") << ColorMatrix::BT601 << ColorRange::Limited;
+    QTest::newRow("BT.601 full") << ColorMatrix::BT601 << ColorRange::Full;
+    QTest::newRow("BT.709 limited") << ColorMatrix::BT709 << ColorRange::Limited;
+    QTest::newRow("BT.709 full") << ColorMatrix::BT709 << ColorRange::Full;
+}
+
+void tst_YUVConverter::scalarMatchesReference()
+{
+    QFETCH(ColorMatrix, matrix);
+    QFETCH(ColorRange, range);
+    // The fixed point math may differ from the exact coefficients by one step.
+    static constexpr const int kTolerance = 1;
+    const qreal kr = ((matrix == ColorMatrix::BT709) ? 0.2126 : 0.299);
+    const qreal kb = ((matrix == ColorMatrix::BT709) ? 0.0722 : 0.114);
+    const qreal kg = (1.0 - kr - kb);
+    const bool full = (range == ColorRange::Full);
+    const qreal lumaScale = (full ? 1.0 : (255.0 / 219.0));
+    const qreal chromaScale = (full ? 1.0 : (255.0 / 224.0));
+    const int lumaOffset = (full ? 0 : 16);
+    for (int v = 0; v != 256; ++v) {
+        const TestFrame source = createExhaustiveI420(v, matrix, range);
+        const QImage image = convertWith(source.frame(), Kernel::Scalar);
+        for (int row = 0; row != kExhaustiveHeight; row += 2) {
+            const int u = row / 2;
+            const uchar *pixel = image.constScanLine(row);
+            for (int y = 0; y != kExhaustiveWidth; ++y, pixel += 4) {
+                const qreal luma = lumaScale * (y - lumaOffset);
+                const qreal cb = chromaScale * (u - 128);
+                const qreal cr = chromaScale * (v - 128);
+                const int expected[3] = {
+                    qBound(0, int(std::lround(luma + (2.0 * (1.0 - kr) * cr))), 255),
+                    qBound(0, int(std::lround(luma - (2.0 * kb * (1.0 - kb) / kg * cb) - (2.0 * kr * (1.0 - kr) / kg * cr))), 255),
+                    qBound(0, int(std::lround(luma + (2.0 * (1.0 - kb) * cb))), 255)
+                };
+                for (int channel = 0; channel != 3; ++channel) {
+                    if (qAbs(pixel[channel] - expected[channel]) > kTolerance) {
+                        QFAIL(qPrintable(QStringLiteral("Y %1 U %2 V %3, channel %4: %5 instead of %6")
+                            .arg(y).arg(u).arg(v).arg(channel).arg(pixel[channel]).arg(expected[channel])));
+                    }
+                }
+                QCOMPARE(pixel[3], uchar(255));
+            }
+        }
+    }
+}
+
+void tst_YUVConverter::kernelsAreBitExact_data()
+{
+    QTest::addColumn<Kernel>("kernel");
+    QTest::addColumn<ColorMatrix>("matrix");
+    QTest::addColumn<ColorRange>("range");
+    for (auto &&kernel : {Kernel::SSE2, Kernel::AVX2, Kernel::NEON}) {
+        for (auto &&matrix : {ColorMatrix::BT601, ColorMatrix::BT709}) {
+            for (auto &&range : {ColorRange::Limited, ColorRange::Full}) {
+                QTest::addRow("%s %s %s", qPrintable(YUVConverter::kernelName(kernel)),
+                              ((matrix == ColorMatrix::BT709) ? "BT.709" : "BT.601"),
+                              ((range == ColorRange::Full) ? "full" : "limited"))
+                    << kernel << matrix << range;
+            }
+        }
+    }
+}
+
+void tst_YUVConverter::kernelsAreBitExact()
+{
+    QFETCH(Kernel, kernel);
+    QFETCH(ColorMatrix, matrix);
+    QFETCH(ColorRange, range);
+    if (!YUVConverter::isKernelSupported(kernel)) {
+        QSKIP("Not supported by this CPU.");
+    }
+    for (int v = 0; v != 256; ++v) {
+        const TestFrame source = createExhaustiveI420(v, matrix, range);
+        const QImage expected = convertWith(source.frame(), Kernel::Scalar);
+        if (convertWith(source.frame(), kernel) != expected) {
+            QFAIL(qPrintable(QStringLiteral("Mismatch for V %1.").arg(v)));
+        }
+    }
+}
+
+void tst_YUVConverter::oddSizes_data()
+{
+    QTest::addColumn<int>("width");
+    QTest::addColumn<int>("height");
+    // Widths around the 16 pixel blocks of the SIMD kernels, heights below a
+    // single slice of the threaded conversion.
+    for (auto &&width : {1, 2, 3, 7, 15, 16, 17, 31, 33, 47, 63, 65, 129, 1921}) {
+        for (auto &&height : {1, 2, 3, 17, 63}) {
+            QTest::addRow("%dx%d", width, height) << width << height;
+        }
+    }
+}
+
+void tst_YUVConverter::oddSizes()
+{
+    QFETCH(int, width);
+    QFETCH(int, height);
+    QRandomGenerator random(quint32((width * 1000) + height));
+    const TestFrame i420 = createRandomI420(width, height, &random);
+    const TestFrame nv12 = toNV12(i420);
+    const TestFrame p010 = toP010(i420, &random);
+    const QImage expected = convertWith(i420.frame(), Kernel::Scalar);
+    const QList<Kernel> kernels = supportedKernels();
+    for (auto &&kernel : qAsConst(kernels)) {
+        const QString name = YUVConverter::kernelName(kernel);
+        QVERIFY2(convertWith(i420.frame(), kernel) == expected, qPrintable(name));
+        QVERIFY2(convertWith(nv12.frame(), kernel) == expected, qPrintable(name));
+        QVERIFY2(convertWith(p010.frame(), kernel) == expected, qPrintable(name));
+    }
+}
+
+void tst_YUVConverter::slicedConversion()
+{
+    // Odd heights and slices which don't divide the frame evenly.
+    for (auto &&height : {64, 65, 127, 129, 1081}) {
+        QRandomGenerator random(quint32(height));
+        const TestFrame source = createRandomI420(723, height, &random);
+        const QImage expected = convertWith(source.frame(), Kernel::Scalar);
+        QImage image = {};
+        QVERIFY(YUVConverter::convert(source.frame(), &image, Kernel::Auto));
+        QCOMPARE(image, expected);
+    }
+}
+
+void tst_YUVConverter::benchmarkKernel_data()
+{
+    QTest::addColumn<Kernel>("kernel");
+    QTest::addColumn<PixelFormat>("format");
+    for (auto &&kernel : {Kernel::Scalar, Kernel::SSE2, Kernel::AVX2, Kernel::NEON}) {
+        const QByteArray name = YUVConverter::kernelName(kernel).toUtf8();
+        QTest::addRow("%s I420", name.constData()) << kernel << PixelFormat::I420;
+        QTest::addRow("%s NV12", name.constData()) << kernel << PixelFormat::NV12;
+        QTest::addRow("%s P010", name.constData()) << kernel << PixelFormat::P010;
+    }
+}
+
+void tst_YUVConverter::benchmarkKernel()
+{
+    QFETCH(Kernel, kernel);
+    QFETCH(PixelFormat, format);
+    if (!YUVConverter::isKernelSupported(kernel)) {
+        QSKIP("Not supported by this CPU.");
+    }
+    // One 1080p frame on the calling thread.
+    QRandomGenerator random(1080);
+    const TestFrame i420 = createRandomI420(1920, 1080, &random);
+    TestFrame source = {};
+    switch (format) {
+    case PixelFormat::NV12:
+        source = toNV12(i420);
+        break;
+    case PixelFormat::P010:
+        source = toP010(i420, &random);
+        break;
+    default:
+        source = i420;
+        break;
+    }
+    const Frame frame = source.frame();
+    QImage image(1920, 1080, QImage::Format_RGBA8888);
+    QBENCHMARK {
+        YUVConverter::convertRows(frame, image.bits(), image.bytesPerLine(), 0, 1080, kernel);
+    }
+}
+
+void tst_YUVConverter::benchmarkSlicedConversion()
+{
+    // One 2160p frame split across the global thread pool with the best kernel.
+    QRandomGenerator random(2160);
+    const TestFrame source = toNV12(createRandomI420(3840, 2160, &random));
+    const Frame frame = source.frame();
+    QImage image = {};
+    QBENCHMARK {
+        YUVConverter::convert(frame, &image);
+    }
+}
+
+QTEST_GUILESS_MAIN(tst_YUVConverter)
+
+#include "tst_yuvconverter.moc"